@@ -0,0 +1,93 @@
+#ifndef __ROBOTEQ_ACK_H__
+#define __ROBOTEQ_ACK_H__
+
+#include <string>
+#include <pthread.h>
+#include <stdint.h>
+
+// Roboteq command acknowledgement handle
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details at
+// http://www.gnu.org/copyleft/gpl.html
+
+// Outcome of one tracked command ("!G 1 500", "^MXRPM 1 3000"). Owned by
+// caller, same life cycle rules as RoboteqQuery. Controller answers
+// every "!", "^" and "%" command with "+" (accepted) or "-" (rejected)
+// in order sent. A command whose answer does not come within timeout is
+// taken as lost and sent again while retries are left.
+
+namespace oxoocoffee
+{
+    using namespace std;
+
+    class RoboteqCom;
+    class RoboteqAck;
+
+    // Completion callback. Runs on reader thread
+    class IAckDone
+    {
+        public:
+            virtual void OnAckDone(RoboteqAck& ack) = 0;
+
+        protected:
+            virtual ~IAckDone(void) {}
+    };
+
+    class RoboteqAck
+    {
+        friend class RoboteqCom;
+
+        public:
+            enum eStatus
+            {
+                eStatus_Idle,
+                eStatus_Pending,
+                eStatus_Accepted,   // "+"
+                eStatus_Rejected,   // "-"
+                eStatus_Timeout,    // Lost and out of retries
+                eStatus_Failed      // Not sent, cancelled or port closed
+            };
+
+                     RoboteqAck(void);
+                    ~RoboteqAck(void);
+
+                    // Blocks until command is no longer pending.
+                    // true when accepted
+            bool     Wait(void);
+
+            eStatus  Status(void) const;
+
+            inline unsigned int  Attempts(void)  const { return _attempts; }
+                    // Send to "+"/"-" of last attempt
+            inline uint64_t      LatencyNs(void) const { return _latencyNs; }
+
+        private:
+                     RoboteqAck(const RoboteqAck&);
+            RoboteqAck& operator=(const RoboteqAck&);
+
+            void     Complete(eStatus status);
+
+            mutable pthread_mutex_t _mx;
+            pthread_cond_t  _cond;
+            eStatus         _status;
+            bool            _finished;      // Status final and callback returned
+            string          _line;          // With terminator, for retransmit
+            unsigned int    _timeoutMs;
+            unsigned int    _retries;       // Left
+            unsigned int    _attempts;
+            uint64_t        _latencyNs;
+            IAckDone*       _pDone;
+            RoboteqCom*     _pCom;
+            RoboteqAck*     _pNext;         // Completion chain
+    };
+}
+
+#endif // __ROBOTEQ_ACK_H__
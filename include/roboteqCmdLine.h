@@ -0,0 +1,94 @@
+#ifndef __ROBOTEQ_CMD_LINE_H__
+#define __ROBOTEQ_CMD_LINE_H__
+
+#include <string>
+#include <ostream>
+#include <string.h>
+#include <stdint.h>
+
+// Roboteq command line builder
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details at
+// http://www.gnu.org/copyleft/gpl.html
+
+// Builds "[@NN]!G 1 900_[@NN]!G 2 900" on the stack, no heap and no
+// stringstream. Integers go through a two digits at a time itoa.
+// What does not fit sets Overflow() and is dropped. Room for
+// terminator is always kept, Terminate() can not overflow
+
+namespace oxoocoffee
+{
+    using namespace std;
+
+    class RoboteqCmdLine
+    {
+        public:
+            enum
+            {
+                MAX_LINE = 1024     // All setpoint slots fit
+            };
+
+            RoboteqCmdLine(void) : _len(0), _count(0), _overflow(false) {}
+
+            inline  void    Clear(void) { _len = 0; _count = 0; _overflow = false; }
+
+                    // Starts next command, '_' joined after first one.
+                    // node != 0 adds CAN "@NN" address
+            RoboteqCmdLine& Next(unsigned int node = 0);
+
+                    // Next(node) then "name channel value", e.g. "!G 1 -500"
+            RoboteqCmdLine& Command(unsigned int node, const char* pName,
+                                    unsigned int channel, int value);
+
+            RoboteqCmdLine& Append(const char* pText, unsigned int len);
+            inline RoboteqCmdLine& Append(const char* pText) { return Append(pText, strlen(pText)); }
+            inline RoboteqCmdLine& Append(const string& text) { return Append(text.data(), text.size()); }
+            inline RoboteqCmdLine& Append(char ch)
+            {
+                if( _len < MAX_LINE )
+                    _buf[_len++] = ch;
+                else
+                    _overflow = true;
+
+                return *this;
+            }
+            RoboteqCmdLine& Append(int value);
+            RoboteqCmdLine& Append(unsigned int value);
+
+                    // Appends ROBO_TERMINATOR ('\r')
+            void    Terminate(void);
+
+            inline  const char*     Data(void)     const { return _buf; }
+            inline  unsigned int    Size(void)     const { return _len; }
+            inline  unsigned int    Count(void)    const { return _count; }
+            inline  bool            Empty(void)    const { return _len == 0; }
+            inline  bool            Overflow(void) const { return _overflow; }
+            inline  string          Str(void)      const { return string(_buf, _len); }
+
+                    // Write digits at pOut, no '\0'. Returns end. pOut
+                    // needs 10 (unsigned) or 11 (int) bytes
+            static  char*   FormatUInt(char* pOut, uint32_t value);
+            static  char*   FormatInt(char* pOut, int value);
+
+        private:
+            char            _buf[MAX_LINE + 1];
+            unsigned int    _len;
+            unsigned int    _count;
+            bool            _overflow;
+    };
+
+    inline ostream& operator<<(ostream& os, const RoboteqCmdLine& line)
+    {
+        return os.write(line.Data(), line.Size());
+    }
+}   // End of namespace oxoocoffee
+
+#endif // __ROBOTEQ_CMD_LINE_H__
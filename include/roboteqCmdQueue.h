@@ -0,0 +1,82 @@
+#ifndef __ROBOTEQ_CMD_QUEUE_H__
+#define __ROBOTEQ_CMD_QUEUE_H__
+
+#include <atomic>
+#include <stdint.h>
+
+// Roboteq command queue
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details at
+// http://www.gnu.org/copyleft/gpl.html
+
+// Bounded multi producer / single consumer queue of preallocated command
+// slots (sequence numbered ring, no locks). Any thread may Push, one
+// writer thread Peeks and Releases. Push never blocks. It fails when
+// queue is full or line does not fit a slot.
+
+#define     ROBO_CMDQ_SLOT_BYTES    232     // Slot is 256 bytes with header
+
+namespace oxoocoffee
+{
+    // Completion notification for queued commands. Called on writer
+    // thread once line went to device. result is line length or -1
+    class ICommandDone
+    {
+        public:
+            virtual void OnCommandDone(uint64_t ticket, int result) = 0;
+
+        protected:
+            virtual ~ICommandDone(void) {}
+    };
+
+    class RoboteqCmdQueue
+    {
+        public:
+                     // slots is rounded up to power of two
+                     RoboteqCmdQueue(unsigned int slots);
+                    ~RoboteqCmdQueue(void);
+
+                    // Any thread. Returns ticket (> 0) or 0 when rejected
+            uint64_t Push(const char* pData, unsigned int len, ICommandDone* pDone);
+
+                    // Writer thread only. Oldest line stays valid until Release
+            bool     Peek(const char*& pData, unsigned int& len,
+                          ICommandDone*& pDone, uint64_t& ticket) const;
+            void     Release(void);
+
+                    // Approximate while producers run
+            unsigned int Size(void) const;
+            inline   unsigned int Capacity(void) const { return _mask + 1; }
+
+        private:
+                     RoboteqCmdQueue(const RoboteqCmdQueue&);
+            RoboteqCmdQueue& operator=(const RoboteqCmdQueue&);
+
+            struct Slot
+            {
+                std::atomic<uint64_t>   sequence;
+                ICommandDone*           pDone;
+                unsigned int            length;
+                char                    data[ROBO_CMDQ_SLOT_BYTES];
+            };
+
+            Slot*                   _slots;
+            unsigned int            _mask;
+
+            char                    _pad0[64];
+            std::atomic<uint64_t>   _enqueuePos;
+            char                    _pad1[64];
+            std::atomic<uint64_t>   _dequeuePos;    // Written by writer thread only
+            char                    _pad2[64];
+    };
+}
+
+#endif // __ROBOTEQ_CMD_QUEUE_H__
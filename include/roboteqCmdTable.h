@@ -0,0 +1,247 @@
+#ifndef __ROBOTEQ_CMD_TABLE_H__
+#define __ROBOTEQ_CMD_TABLE_H__
+
+#include "roboteqCmdLine.h"
+#include <type_traits>
+
+// Roboteq typed command table
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details at
+// http://www.gnu.org/copyleft/gpl.html
+
+// Runtime commands, queries, config and telemetry control the code
+// issues, with their numeric argument counts. Encoder
+//
+//      RoboteqCmd::Cmd<RoboteqCmd::Go>(line, node, channel, value)
+//
+// appends "[@NN]!G channel value" to RoboteqCmdLine. Wrong argument
+// count or non integer argument fails to compile. Name and its length
+// are constants, nothing is looked up or parsed at run time
+
+namespace oxoocoffee
+{
+    namespace RoboteqCmd
+    {
+        enum eKind
+        {
+            eKind_Command,      // '!'
+            eKind_Query,        // '?'
+            eKind_Config,       // '^'
+            eKind_Telemetry,    // '#'
+            eKind_Maintenance   // '%'
+        };
+
+        enum eCommand
+        {
+            eCommand_Go,
+            eCommand_GoPosition,
+            eCommand_GoSpeed,
+            eCommand_SetAccel,
+            eCommand_SetDecel,
+            eCommand_SetCounter,
+            eCommand_SetDigital,
+            eCommand_ResetDigital,
+            eCommand_SetVar,
+            eCommand_EmergencyStop,
+            eCommand_ReleaseStop,
+            eCommand_MotorStop,
+
+            eCommand_ReadAmps,
+            eCommand_ReadBatteryAmps,
+            eCommand_ReadSpeed,
+            eCommand_ReadCounter,
+            eCommand_ReadMotorCmd,
+            eCommand_ReadPower,
+            eCommand_ReadVolts,
+            eCommand_ReadTemp,
+            eCommand_ReadFaults,
+            eCommand_ReadStatus,
+            eCommand_ReadFirmware,
+            eCommand_ReadModel,
+
+            eCommand_Echo,
+            eCommand_Watchdog,
+            eCommand_MotorAccel,
+            eCommand_MotorDecel,
+            eCommand_MaxRpm,
+            eCommand_MotorMode,
+            eCommand_AmpLimit,
+            eCommand_CanNode,
+
+            eCommand_TelemetryStop,
+            eCommand_TelemetryClear,
+            eCommand_TelemetryEvery,
+
+            eCommand_SaveConfig,
+            eCommand_Reset,
+
+            eCommand_Count
+        };
+
+        struct Info
+        {
+            eCommand        id;         // Must match table position
+            const char*     pName;
+            eKind           kind;
+            unsigned char   minArgs;
+            unsigned char   maxArgs;    // Queries: optional channel / index
+        };
+
+        constexpr Info gTable[eCommand_Count] =
+        {
+            { eCommand_Go,              "!G",       eKind_Command,      2, 2 },   // channel, -1000..1000
+            { eCommand_GoPosition,      "!P",       eKind_Command,      2, 2 },   // channel, counts
+            { eCommand_GoSpeed,         "!S",       eKind_Command,      2, 2 },   // channel, rpm
+            { eCommand_SetAccel,        "!AC",      eKind_Command,      2, 2 },   // channel, 0.1 rpm/s
+            { eCommand_SetDecel,        "!DC",      eKind_Command,      2, 2 },
+            { eCommand_SetCounter,      "!C",       eKind_Command,      2, 2 },   // channel, counts
+            { eCommand_SetDigital,      "!D1",      eKind_Command,      1, 1 },   // output
+            { eCommand_ResetDigital,    "!D0",      eKind_Command,      1, 1 },
+            { eCommand_SetVar,          "!VAR",     eKind_Command,      2, 2 },   // index, value
+            { eCommand_EmergencyStop,   "!EX",      eKind_Command,      0, 0 },
+            { eCommand_ReleaseStop,     "!MG",      eKind_Command,      0, 0 },
+            { eCommand_MotorStop,       "!MS",      eKind_Command,      1, 1 },   // channel
+
+            { eCommand_ReadAmps,        "?A",       eKind_Query,        0, 1 },
+            { eCommand_ReadBatteryAmps, "?BA",      eKind_Query,        0, 1 },
+            { eCommand_ReadSpeed,       "?S",       eKind_Query,        0, 1 },
+            { eCommand_ReadCounter,     "?C",       eKind_Query,        0, 1 },
+            { eCommand_ReadMotorCmd,    "?M",       eKind_Query,        0, 1 },
+            { eCommand_ReadPower,       "?P",       eKind_Query,        0, 1 },
+            { eCommand_ReadVolts,       "?V",       eKind_Query,        0, 1 },
+            { eCommand_ReadTemp,        "?T",       eKind_Query,        0, 1 },
+            { eCommand_ReadFaults,      "?FF",      eKind_Query,        0, 0 },
+            { eCommand_ReadStatus,      "?FS",      eKind_Query,        0, 0 },
+            { eCommand_ReadFirmware,    "?$1E",     eKind_Query,        0, 0 },   // FID
+            { eCommand_ReadModel,       "?$1F",     eKind_Query,        0, 0 },   // TRN
+
+            { eCommand_Echo,            "^ECHOF",   eKind_Config,       1, 1 },   // 1 = echo off
+            { eCommand_Watchdog,        "^RWD",     eKind_Config,       1, 1 },   // ms, 0 = off
+            { eCommand_MotorAccel,      "^MAC",     eKind_Config,       2, 2 },   // channel, value
+            { eCommand_MotorDecel,      "^MDEC",    eKind_Config,       2, 2 },
+            { eCommand_MaxRpm,          "^MXRPM",   eKind_Config,       2, 2 },
+            { eCommand_MotorMode,       "^MMOD",    eKind_Config,       2, 2 },
+            { eCommand_AmpLimit,        "^ALIM",    eKind_Config,       2, 2 },
+            { eCommand_CanNode,         "^CNOD",    eKind_Config,       1, 1 },
+
+            { eCommand_TelemetryStop,   "#",        eKind_Telemetry,    0, 0 },
+            { eCommand_TelemetryClear,  "# C",      eKind_Telemetry,    0, 0 },
+            { eCommand_TelemetryEvery,  "#",        eKind_Telemetry,    1, 1 },   // ms
+
+            { eCommand_SaveConfig,      "%EESAV",   eKind_Maintenance,  0, 0 },
+            { eCommand_Reset,           "%RESET",   eKind_Maintenance,  1, 1 }    // 321654987
+        };
+
+        constexpr unsigned int  NameLen(const char* pName)
+        {
+            return *pName ? 1 + NameLen(pName + 1) : 0;
+        }
+
+        constexpr bool  TableInOrder(unsigned int Idx)
+        {
+            return Idx == eCommand_Count ||
+                   (gTable[Idx].id == (eCommand)Idx && gTable[Idx].minArgs <= gTable[Idx].maxArgs &&
+                    TableInOrder(Idx + 1));
+        }
+
+        static_assert(TableInOrder(0), "RoboteqCmd - gTable out of eCommand order");
+
+        template<eCommand Id>
+        struct Tag
+        {
+            static constexpr eCommand       ID   = Id;
+            static constexpr eKind          KIND = gTable[Id].kind;
+            enum { LEN = NameLen(gTable[Id].pName) };
+
+            static inline const char*   Name(void) { return gTable[Id].pName; }
+        };
+
+        typedef Tag<eCommand_Go>                Go;
+        typedef Tag<eCommand_GoPosition>        GoPosition;
+        typedef Tag<eCommand_GoSpeed>           GoSpeed;
+        typedef Tag<eCommand_SetAccel>          SetAccel;
+        typedef Tag<eCommand_SetDecel>          SetDecel;
+        typedef Tag<eCommand_SetCounter>        SetCounter;
+        typedef Tag<eCommand_SetDigital>        SetDigital;
+        typedef Tag<eCommand_ResetDigital>      ResetDigital;
+        typedef Tag<eCommand_SetVar>            SetVar;
+        typedef Tag<eCommand_EmergencyStop>     EmergencyStop;
+        typedef Tag<eCommand_ReleaseStop>       ReleaseStop;
+        typedef Tag<eCommand_MotorStop>         MotorStop;
+
+        typedef Tag<eCommand_ReadAmps>          ReadAmps;
+        typedef Tag<eCommand_ReadBatteryAmps>   ReadBatteryAmps;
+        typedef Tag<eCommand_ReadSpeed>         ReadSpeed;
+        typedef Tag<eCommand_ReadCounter>       ReadCounter;
+        typedef Tag<eCommand_ReadMotorCmd>      ReadMotorCmd;
+        typedef Tag<eCommand_ReadPower>         ReadPower;
+        typedef Tag<eCommand_ReadVolts>         ReadVolts;
+        typedef Tag<eCommand_ReadTemp>          ReadTemp;
+        typedef Tag<eCommand_ReadFaults>        ReadFaults;
+        typedef Tag<eCommand_ReadStatus>        ReadStatus;
+        typedef Tag<eCommand_ReadFirmware>      ReadFirmware;
+        typedef Tag<eCommand_ReadModel>         ReadModel;
+
+        typedef Tag<eCommand_Echo>              Echo;
+        typedef Tag<eCommand_Watchdog>          Watchdog;
+        typedef Tag<eCommand_MotorAccel>        MotorAccel;
+        typedef Tag<eCommand_MotorDecel>        MotorDecel;
+        typedef Tag<eCommand_MaxRpm>            MaxRpm;
+        typedef Tag<eCommand_MotorMode>         MotorMode;
+        typedef Tag<eCommand_AmpLimit>          AmpLimit;
+        typedef Tag<eCommand_CanNode>           CanNode;
+
+        typedef Tag<eCommand_TelemetryStop>     TelemetryStop;
+        typedef Tag<eCommand_TelemetryClear>    TelemetryClear;
+        typedef Tag<eCommand_TelemetryEvery>    TelemetryEvery;
+
+        typedef Tag<eCommand_SaveConfig>        SaveConfig;
+        typedef Tag<eCommand_Reset>             Reset;
+
+        inline void     AppendArgs(RoboteqCmdLine&) {}
+
+        template<typename TArg, typename... TRest>
+        inline void     AppendArgs(RoboteqCmdLine& line, TArg value, TRest... rest)
+        {
+            static_assert(std::is_integral<TArg>::value || std::is_enum<TArg>::value,
+                          "RoboteqCmd - arguments must be integers");
+
+            line.Append(' ').Append((int)value);
+            AppendArgs(line, rest...);
+        }
+
+                // Appends TCmd for CAN node (0 = serial, no "@NN")
+        template<typename TCmd, typename... TArgs>
+        inline RoboteqCmdLine&  Cmd(RoboteqCmdLine& line, unsigned int node, TArgs... args)
+        {
+            static_assert(sizeof...(TArgs) >= gTable[TCmd::ID].minArgs, "RoboteqCmd - too few arguments");
+            static_assert(sizeof...(TArgs) <= gTable[TCmd::ID].maxArgs, "RoboteqCmd - too many arguments");
+
+            line.Next(node).Append(gTable[TCmd::ID].pName, TCmd::LEN);
+            AppendArgs(line, args...);
+
+            return line;
+        }
+
+                // Single command line, e.g. IssueCommand(Cmd<EmergencyStop>(0))
+        template<typename TCmd, typename... TArgs>
+        inline RoboteqCmdLine   Cmd(unsigned int node, TArgs... args)
+        {
+            RoboteqCmdLine line;
+
+            Cmd<TCmd>(line, node, args...);
+
+            return line;
+        }
+    }   // End of namespace RoboteqCmd
+}   // End of namespace oxoocoffee
+
+#endif // __ROBOTEQ_CMD_TABLE_H__
@@ -0,0 +1,84 @@
+#ifndef __ROBOTEQ_CMD_TEMPLATE_H__
+#define __ROBOTEQ_CMD_TEMPLATE_H__
+
+#include "roboteqCmdTable.h"
+#include <stdint.h>
+
+// Roboteq precompiled command line
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details at
+// http://www.gnu.org/copyleft/gpl.html
+
+// Line compiled once, e.g. "@01!G 1 #_@01!G 2 #_..." where every '#'
+// is a numeric slot. Set() rewrites only the digits of one slot in
+// place. Same digit count is a plain copy, otherwise tail of the line
+// is moved. Data() is always '\r' terminated and ready for write()
+
+namespace oxoocoffee
+{
+    class RoboteqCmdTemplate
+    {
+        public:
+            enum
+            {
+                MAX_LINE  = RoboteqCmdLine::MAX_LINE,
+                MAX_SLOTS = 64
+            };
+
+            RoboteqCmdTemplate(void) { Clear(); }
+
+            void    Clear(void);
+
+                    // Appends "[@NN]name args... <slot>", slot starts at 0.
+                    // Returns slot index for Set()
+            template<typename TCmd, typename... TArgs>
+            unsigned int    Add(unsigned int node, TArgs... args)
+            {
+                static_assert(sizeof...(TArgs) + 1 >= RoboteqCmd::gTable[TCmd::ID].minArgs, "RoboteqCmd - too few arguments");
+                static_assert(sizeof...(TArgs) + 1 <= RoboteqCmd::gTable[TCmd::ID].maxArgs, "RoboteqCmd - too many arguments");
+
+                RoboteqCmdLine  cmd;
+
+                cmd.Next(node).Append(RoboteqCmd::gTable[TCmd::ID].pName, TCmd::LEN);
+                RoboteqCmd::AppendArgs(cmd, args...);
+
+                return AddSlot(cmd.Data(), cmd.Size());
+            }
+
+            void    Set(unsigned int slot, int value);
+
+            inline  const char*     Data(void)     const { return _buf; }
+            inline  unsigned int    Size(void)     const { return _len + 1; }  // With '\r'
+            inline  unsigned int    Count(void)    const { return _count; }
+            inline  bool            Empty(void)    const { return _count == 0; }
+            inline  bool            Overflow(void) const { return _overflow; }
+            inline  string          Str(void)      const { return string(_buf, _len); }
+
+        private:
+            unsigned int    AddSlot(const char* pCmd, unsigned int len);
+
+        private:
+            struct Slot
+            {
+                uint16_t        offset;
+                uint8_t         len;
+                int             value;
+            };
+
+            char            _buf[MAX_LINE + 1];
+            unsigned int    _len;           // Without '\r'
+            unsigned int    _count;
+            bool            _overflow;
+            Slot            _slots[MAX_SLOTS];
+    };
+}   // End of namespace oxoocoffee
+
+#endif // __ROBOTEQ_CMD_TEMPLATE_H__
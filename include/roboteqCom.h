@@ -22,11 +22,39 @@
 #include "roboteqComEvent.h"
 #include "roboteqComEventArgs.h"
 #include "roboteqThread.h"
+#include "roboteqReplyRing.h"
+#include "roboteqCmdQueue.h"
+#include "roboteqQuery.h"
+#include "roboteqAck.h"
+#include "roboteqHistogram.h"
+#include "roboteqCmdLine.h"
+#include "roboteqCmdTable.h"
+#include "roboteqCmdTemplate.h"
+#include "roboteqEngine.h"
+#include <atomic>
+#include <deque>
+
+#define     ROBO_TERMINATOR		'\r'
+#define	    ROBO_MSG_MAX		1024
+#define     ROBO_CMD_SEPARATOR  '_'     // Joins commands on one line
+#define     ROBO_BATCH_MAX      128     // Default batch byte budget
+#define     ROBO_BATCH_HIST     16      // Last bucket counts >= 16 commands
+#define     ROBO_SP_NODES       16      // Setpoint slots. CAN nodes 0..15
+#define     ROBO_SP_CHANNELS    4       // Motor channels 1..3 (0 unused)
+#define     ROBO_SERVICE_MS     2       // Reader wake up when it has timed work
+#define     ROBO_SCHED_SLACK_US 2000    // Scheduler keeps at most this much queued in driver
+#define     ROBO_REPLY_SLOTS    256     // Default reply handoff ring size
+#define     ROBO_WRITER_SLOTS   256     // Default writer command queue size
+#define     ROBO_WRITER_BATCH   64      // Most queued commands per write()
+#define     ROBO_QUERY_TIMEOUT_MS 200   // Default per query timeout
+#define     ROBO_ACK_TIMEOUT_MS 100     // Default wait for "+" / "-"
+#define     ROBO_ACK_WINDOW     256     // Commands awaiting "+" / "-"
+#define     ROBO_ACK_TYPES      32      // Command names with own ack stats
 
 namespace oxoocoffee
 {
 
-class RoboteqCom : public IRunnable
+class RoboteqCom : public IRunnable, private IEngineService
 {
     typedef IEventListener<const IEventArgs>  IRoboteqEvent;
     typedef IDummyListener<const IEventArgs>  IDummyEvent;
@@ -38,26 +66,247 @@ class RoboteqCom : public IRunnable
             eCAN
         };
 
+        // Transmit scheduler classes. Lower value goes first
+        enum ePriority
+        {
+            ePriority_Safety,       // !EX, !MG, !MS
+            ePriority_Motion,       // Other runtime commands (!)
+            ePriority_Query,        // ? and # telemetry
+            ePriority_Config,       // ^ ~ % and everything else
+            ePriority_Count
+        };
+
+        // Latency histograms, always recorded
+        enum eLatency
+        {
+            eLatency_Ack,           // Tracked command write to "+"/"-"
+            eLatency_Query,         // Query call to matching reply
+            eLatency_Telemetry,     // Gap between telemetry frames
+            eLatency_Queue,         // IssueCommand to write, scheduler only
+            eLatency_Count
+        };
+
         // Non threaded version
         RoboteqCom(SerialLogger& log);
 
         // Threaded version. We are using this one!!
         RoboteqCom(SerialLogger& log, IRoboteqEvent& event);
+
+        // Shared reader version. Replies are read and dispatched
+        // by engine thread together with other controllers
+        RoboteqCom(SerialLogger& log, IRoboteqEvent& event, RoboteqEngine& engine);
+
+        ~RoboteqCom(void);
     
         void    Open(eMode mode, const string& device);
         void    Close(void);
 
+        struct WriterStats
+        {
+            unsigned long   submitted;      // Lines queued
+            unsigned long   rejected;       // Queue full or line too long
+            unsigned long   written;        // Lines handed to device
+            unsigned long   failed;         // Write failed or dropped at Close
+            unsigned long   writes;         // write() batches issued by writer
+            unsigned int    maxDepth;
+        };
+
+        struct AckTypeStats
+        {
+            char            name[8];        // "!G", "^MXRPM"
+            unsigned long   accepted;
+            unsigned long   rejected;
+            unsigned long   lost;           // No answer within timeout
+            unsigned long   retransmits;
+            uint64_t        totalNs;        // Send to answer, answered ones
+            uint64_t        maxNs;
+        };
+
+        struct BatchStats
+        {
+            unsigned long   batches;        // write() calls for batched commands
+            unsigned long   commands;       // Commands that went through batching
+            unsigned long   bytes;
+            unsigned long   sizes[ROBO_BATCH_HIST + 1];  // Commands per batch
+        };
+
+        struct SetpointStats
+        {
+            unsigned long   submitted;      // SetMotorSetpoint calls
+            unsigned long   sent;           // Setpoints that went on the wire
+            unsigned long   coalesced;      // Replaced by newer value before sent
+            unsigned long   dropped;        // Discarded unsent (Close, write error)
+            unsigned long   writes;         // write() calls carrying setpoints
+        };
+
+        struct ClassStats
+        {
+            unsigned long   sent;
+            unsigned long   dropped;        // Still queued at Close
+            unsigned long   maxDepth;
+            uint64_t        totalDelayNs;   // Enqueue to write()
+            uint64_t        maxDelayNs;
+        };
+
+        struct SchedulerStats
+        {
+            ClassStats      classes[ePriority_Count];
+            unsigned int    bytesPerSec;    // Link budget at current baud
+        };
+
         int     IssueCommand(const char* buffer, int size);
         int     IssueCommand(const string&  command,
                              const string&  args = "");
+        int     IssueCommand(ePriority      priority,
+                             const string&  command,
+                             const string&  args = "");
+                // Prebuilt line, no heap on direct, batched and writer
+                // paths. Line gets terminated. Throws on Overflow()
+        int     IssueCommand(RoboteqCmdLine& line);
+                // Temporary line, IssueCommand(RoboteqCmd::Cmd<...>(node, ...))
+        inline int IssueCommand(RoboteqCmdLine&& line) { return IssueCommand(line); }
+
+                // Priority scheduler. Once reader runs, commands wait in
+                // per class queues and are written highest class first,
+                // only while modeled link backlog is below slackUs. A long
+                // config dump therefore never sits in driver buffer ahead
+                // of a safety command. Takes precedence over plain
+                // batching (batching then joins lines of same class)
+        void    SetScheduler(bool enable, unsigned int slackUs = ROBO_SCHED_SLACK_US);
+        void    GetSchedulerStats(SchedulerStats& stats);
+        void    ResetSchedulerStats(void);
+        static ePriority Classify(const string& command);
+
+                // Batching. Once reader runs, commands issued within windowUs
+                // of the first queued one (or until maxBytes) are joined
+                // with '_' and sent in one write(). windowUs 0 turns it off.
+                // Reader thread (or RoboteqEngine) flushes a batch whose
+                // window has passed
+        void    SetBatching(unsigned int windowUs,
+                            unsigned int maxBytes = ROBO_BATCH_MAX);
+        int     Flush(void);
+        void    GetBatchStats(BatchStats& stats);
+        void    ResetBatchStats(void);
 
+                // Latest wins motor command ("!G channel value"). Each
+                // (node, channel) has one slot. If link is still busy with
+                // earlier bytes the value waits in its slot and a newer one
+                // replaces it. All pending slots go out on one '_' joined line
+                // as soon as link is free. node 0 means no "@NN" prefix.
+                // send false only stages value so several setpoints
+                // can be updated before they go out together
+        void    SetMotorSetpoint(unsigned int node, unsigned int channel,
+                                 int value, bool send = true);
+        void    GetSetpointStats(SetpointStats& stats);
+        void    ResetSetpointStats(void);
+
+                // Link model. Wire time of bytes written and not yet
+                // transmitted at configured baud rate
+        uint64_t TxBacklogNs(void);
+
+                // Reply length, 0 when woken or timed out, < 0 once
+                // link failed or was closed by peer
         int     ReadReply(string& reply);
+                // Gives up at deadline (absolute CLOCK_MONOTONIC)
+        int     ReadReply(string& reply, const timespec& deadline);
+
+                // Bounds each Open handshake step (sync, version, model)
+        inline       void    SetTimeout(unsigned int ms)       { _timeoutMs = ms; }
+                // Line setup used by Open, 115200 8N1 raw by default.
+                // Receive profile is low latency so USB serial latency
+                // timer does not delay every reply. Port().profileReport()
+                // tells what took effect
+        inline       void    SetPortProfile(SerialPort::eProfile profile) { _portConfig.profile = profile; }
+        inline       void    SetBaud(unsigned int baud)                   { _portConfig.baud = baud; }
+                // Non tty link (SerialNetPort, SerialPtyPort, SerialReplayPort).
+                // Set before Open, device then is the transport address.
+                // Caller owns it and keeps it alive until Close
+        inline       void    SetTransport(ITransport* pTransport)        { _port.transport(pTransport); }
+                // Tee of all port traffic, see SerialCapture. Any time
+        inline       void    SetCapture(SerialCapture* pCapture)         { _port.capture(pCapture); }
 
-        inline       bool    IsThreadRunning(void) const { return _thread.IsRunning(); }
+                // Reply handoff. With slots > 0 reader thread only copies
+                // each reply into a lock free ring and consumer calls
+                // DrainReplies from its own thread, which is where
+                // OnMsgEvent then runs. Slow consumer costs dropped
+                // replies instead of stalled serial reception.
+                // Set before Open. 0 goes back to direct dispatch
+        void    SetReplyQueue(unsigned int slots = ROBO_REPLY_SLOTS);
+        unsigned int DrainReplies(unsigned int maxCount = ~0u);
+        bool    GetReplyQueueStats(RoboteqReplyRing::Stats& stats) const;
+
+                // Writer thread. With slots > 0 Open also starts a writer
+                // thread. IssueCommand and Submit then only copy the line
+                // into a lock free MPSC queue and return, so any number
+                // of threads may issue commands without waiting on the
+                // device. Writer joins whatever is queued into one write()
+                // and retries short writes. Set before Open. 0 turns it off.
+                // Submit returns ticket handed to pDone, 0 if not queued
+                // (writer not running, queue full or line too long)
+        void     SetWriter(unsigned int slots = ROBO_WRITER_SLOTS);
+        uint64_t Submit(const string& command, const string& args = "",
+                        ICommandDone* pDone = 0L);
+        void     GetWriterStats(WriterStats& stats) const;
+
+                // Pipelined queries. Sends command ("?V", "@02?A 1") and
+                // returns at once, so any number can be in flight. Reader
+                // thread hands reply with same key and CAN node to oldest
+                // pending query and completes it (Wait / IQueryDone)
+                // instead of dispatching it to OnMsgEvent. Unanswered
+                // query completes with eStatus_Timeout after timeoutMs.
+                // Replies carry no channel, so a late reply to a timed out
+                // query completes next pending one with same key.
+                // Needs reader thread, throws with RoboteqEngine. Does not
+                // allocate unless scheduler queues it. Numeric keys are
+                // matched for $1E (FID) and $1F (TRN) only. Returns false
+                // if it could not be sent (query then completes with
+                // eStatus_Failed)
+        bool    Query(RoboteqQuery& query, const string& command,
+                      unsigned int timeoutMs = ROBO_QUERY_TIMEOUT_MS,
+                      IQueryDone* pDone = 0L);
+                // false if query was not pending here
+        bool    Cancel(RoboteqQuery& query);
+        inline  unsigned int QueriesPending(void) const { return _queryCount.load(); }
+
+                // Ack tracking. Every "!", "^" and "%" command written is
+                // remembered in send order and paired with next "+" or
+                // "-" (which then no longer reach OnMsgEvent). Latency is
+                // kept per command name for all of them, so fire and
+                // forget commands (IssueCommand, setpoints) still cost
+                // only a window slot. Enable after Open, needs reader
+                // thread (throws with RoboteqEngine). timeoutMs applies to
+                // untracked commands. Answers carry no id, so after a lost
+                // one pairing is off by one until oldest entry times out.
+                // Totals stay right
+        void    SetAckTracking(bool enable, unsigned int timeoutMs = ROBO_ACK_TIMEOUT_MS);
+                // Tracked command. Written right away (not batched, queued
+                // or scheduled). When answer is lost it is sent again up to
+                // retries times, but only if IsIdempotent. false if not sent
+        bool    IssueTracked(RoboteqAck& ack, const string& command,
+                             const string& args = "",
+                             unsigned int timeoutMs = ROBO_ACK_TIMEOUT_MS,
+                             unsigned int retries = 0, IAckDone* pDone = 0L);
+                // false if ack was not pending here
+        bool    Cancel(RoboteqAck& ack);
+                // Fills up to maxCount entries, returns how many
+        unsigned int GetAckStats(AckTypeStats* pStats, unsigned int maxCount);
+        void    ResetAckStats(void);
+                // Safe to repeat. Not "!R" (script restart) or "%" maintenance
+        static bool IsIdempotent(const string& command);
+
+                // Telemetry is any frame not consumed as ack or query
+                // reply. Gaps are taken between terminator stamps (see
+                // IEventArgs::LastByteNs) and show controller / driver jitter
+        void    GetLatency(eLatency which, RoboteqHistogram::Snapshot& snap) const;
+        void    ResetLatency(eLatency which);
+        inline       unsigned int Timeout(void)          const { return _timeoutMs; }
+
+                     bool    IsThreadRunning(void) const;
         inline       bool    IsThreaded(void)      const { return _event.Type() == IRoboteqEvent::eReal; }
         inline const string& Version(void)         const { return _version; }
         inline const string& Model(void)           const { return _model; }
         inline       eMode   Mode(void)            const { return _mode; }
+        inline const SerialPort& Port(void)        const { return _port; }
 
     protected:
         // IRunnable override
@@ -66,10 +315,56 @@ class RoboteqCom : public IRunnable
         virtual void Run(void);
 
         // Used to synchronize on startup
-        bool    Synchronize(void);
+        bool    Synchronize(const timespec& deadline);
 
     private:
         void    CTorInit(void);
+        int     Batch(const char* pLine, unsigned int len);
+        uint64_t SubmitLine(RoboteqCmdLine& line, ICommandDone* pDone);
+        int     FlushLocked(void);
+        int     WriteLocked(const string& line);
+        bool    LinkBusyLocked(uint64_t now);
+        int     FlushSetpointsLocked(void);
+        int     Enqueue(ePriority priority, const string& command, const string& args);
+        void    PumpLocked(void);
+        void    SendQueuedLocked(ePriority priority, uint64_t now);
+        uint64_t NextDueNs(void);
+        void    EnableTimedService(void);
+        // IEngineService overrides, reader thread uses them too
+        virtual uint64_t ServiceDueNs(void);
+        virtual void     Service(void);
+        int     WriteLocked(const char* pLine, unsigned int len);
+        void    WriterRun(void);
+        unsigned int DrainCommands(void);
+        void    StopWriter(void);
+        bool    MatchQuery(const string& reply);
+        void    ExpireQueries(uint64_t now);
+        void    FailQueries(void);
+        uint64_t QueryDueNs(void);
+        void    TrackLineLocked(const char* pLine, unsigned int len, uint64_t now);
+        unsigned int AckTypeLocked(const char* pName, unsigned int len);
+        void    OnAck(bool accepted);
+        void    ExpireAcks(uint64_t now);
+        void    FailAcks(void);
+
+        class WriterRunner : public IRunnable
+        {
+            public:
+                WriterRunner(RoboteqCom& com) : _com(com) {}
+
+            protected:
+                virtual void Run(void) { _com.WriterRun(); }
+
+            private:
+                RoboteqCom& _com;
+        };
+
+        struct Written
+        {
+            ICommandDone*   pDone;
+            uint64_t        ticket;
+            unsigned int    length;
+        };
 
     private:
         string          _device;
@@ -80,7 +375,77 @@ class RoboteqCom : public IRunnable
         IRoboteqEvent&  _event;
         IDummyEvent     _dummyEvent; // do not use it. Only used to init _event reference
         RoboteqThread   _thread;        
+        RoboteqEngine*  _engine;
+        RoboteqReplyRing* _replies;     // 0L means dispatch on reader
+        RoboteqCmdQueue*  _commands;    // 0L means callers write directly
+        WriterRunner    _writerRunner;
+        RoboteqThread   _writerThread;
+        int             _writerWake;    // eventfd
+        std::atomic<bool> _writerIdle;
+        std::atomic<bool> _writerStop;
+        std::atomic<unsigned long> _writerSubmitted;
+        std::atomic<unsigned long> _writerRejected;
+        std::atomic<unsigned int>  _writerMaxDepth;
+        std::atomic<unsigned long> _writerWritten;
+        std::atomic<unsigned long> _writerFailed;
+        std::atomic<unsigned long> _writerWrites;
+        char            _writerBuf[ROBO_MSG_MAX];
+        Written         _writerDone[ROBO_WRITER_BATCH];
+        RoboMutex       _queryMtx;
+        RoboteqQuery*   _queryHead;     // Oldest first
+        RoboteqQuery*   _queryTail;
+        std::atomic<unsigned int> _queryCount;
+        struct AckEntry
+        {
+            uint64_t        sentNs;
+            uint64_t        deadlineNs;
+            RoboteqAck*     pAck;       // 0L for fire and forget
+            unsigned int    type;
+        };
+        std::atomic<bool> _ackEnabled;
+        uint64_t        _ackTimeoutNs;
+        AckEntry        _ackWindow[ROBO_ACK_WINDOW];
+        unsigned int    _ackHead;       // Oldest entry
+        unsigned int    _ackCount;
+        RoboteqAck*     _ackNext;       // Claims next command written
+        RoboteqAck*     _ackOrphans;    // Pushed out of full window
+        AckTypeStats    _ackTypes[ROBO_ACK_TYPES];
+        unsigned int    _ackTypeCount;
+        RoboteqHistogram _latency[eLatency_Count];
+        uint64_t        _lastTelemetryNs;   // Reader thread only
         RoboMutex	    _mtx;
+        unsigned int    _timeoutMs;
+        SerialPort::Config _portConfig;
+        uint64_t        _batchWindowNs;
+        unsigned int    _batchMaxBytes;
+        uint64_t        _batchStartNs;
+        unsigned int    _batchCount;
+        string          _batch;
+        BatchStats      _batchStats;
+        std::atomic<bool> _timedService;    // Reader must wake up periodically
+        uint64_t        _txBusyUntilNs; // Link model. Wire idle after this
+        struct Setpoint
+        {
+            int         value;
+            bool        pending;
+        };
+        Setpoint        _setpoints[ROBO_SP_NODES][ROBO_SP_CHANNELS];
+        unsigned int    _setpointsPending;
+        RoboteqCmdTemplate _spTemplate;     // Last flushed line, digits patched
+        uint64_t        _spTemplateMask;    // Node / channel bits it was built for
+        SetpointStats   _setpointStats;
+        struct Queued
+        {
+            string      line;       // No terminator
+            uint64_t    enqueuedNs;
+        };
+        typedef std::deque<Queued>  TQueue;
+        std::atomic<bool> _schedEnabled;
+        uint64_t        _schedSlackNs;
+        TQueue          _queues[ePriority_Count];
+        unsigned int    _queued;
+        ClassStats      _classStats[ePriority_Count];
+        string          _schedLine;
 };
 
 }   // End of amespace oxoocoffee
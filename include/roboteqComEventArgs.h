@@ -1,7 +1,9 @@
 #ifndef __ROBOTEQ_COM_EVENT_ARGS_H__
 #define __ROBOTEQ_COM_EVENT_ARGS_H__
 
+#include "serialClock.h"
 #include <string>
+#include <ctype.h>
 
 // Event Handler Class
 // Robert J. Gebis (oxoocoffee) <rjgebis@yahoo.com>
@@ -24,23 +26,70 @@ namespace oxoocoffee
 {
     using namespace std;
 
+    // Refers to reader's frame buffer in place. Leading echo byte is
+    // skipped by offset instead of erase. String copy is made only when
+    // Reply() is asked for or when event is copied to outlive dispatch.
+    // Stamps are CLOCK_MONOTONIC ns (SerialClock), 0 when not known
     class IEventArgs
     {
         public:
-            IEventArgs(const string& reply)
-              : _reply(reply)
-	    {
+            IEventArgs(const string& reply, const RxStamp& stamp = RxStamp())
+              : _pData(reply.data()), _length(reply.size()), _stamp(stamp), _cached(false)
+            {
+                if( _length > 0 && isalpha( (unsigned char)_pData[0] ) == 0 )
+                {
+                    ++_pData;
+                    --_length;
+                }
+            }
+
+            IEventArgs(const char* pData, unsigned int length,
+                       const RxStamp& stamp = RxStamp())
+              : _pData(pData), _length(length), _stamp(stamp), _cached(false)
+            {
+                if( _length > 0 && isalpha( (unsigned char)_pData[0] ) == 0 )
+                {
+                    ++_pData;
+                    --_length;
+                }
+            }
 
-		    if( isalpha( _reply[0] ) == 0 )
-			    _reply = _reply.erase(0, 1);
+            IEventArgs(const IEventArgs& evt)
+              : _stamp(evt._stamp), _reply(evt._pData, evt._length), _cached(true)
+            {
+                _pData  = _reply.data();
+                _length = _reply.size();
             }
 
-            IEventArgs(const IEventArgs& evt) : _reply(evt._reply) {}
+        inline const char*   Data(void)   const { return _pData;    }
+        inline unsigned int  Length(void) const { return _length;   }
 
-        inline const string& Reply(void)   const { return _reply;   }
+                // First byte and terminator arrival, estimated sample time.
+                // 0 when unknown, e.g. frame not read from a port
+        inline const RxStamp& Stamp(void)      const { return _stamp;          }
+        inline uint64_t      FirstByteNs(void) const { return _stamp.firstNs;  }
+        inline uint64_t      LastByteNs(void)  const { return _stamp.lastNs;   }
+        inline uint64_t      SampleNs(void)    const { return _stamp.sampleNs; }
+
+        inline const string& Reply(void)  const
+        {
+            if( _cached == false )
+            {
+                _reply.assign(_pData, _length);
+                _cached = true;
+            }
+
+            return _reply;
+        }
 
         private:
-            string _reply;
+            IEventArgs& operator=(const IEventArgs&);
+
+            const char*     _pData;
+            unsigned int    _length;
+            RxStamp         _stamp;
+            mutable string  _reply;
+            mutable bool    _cached;
     };
 }
 
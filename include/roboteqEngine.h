@@ -0,0 +1,116 @@
+#ifndef __ROBOTEQ_ENGINE_H__
+#define __ROBOTEQ_ENGINE_H__
+
+#include "serialPort.h"
+#include "roboteqComEvent.h"
+#include "roboteqComEventArgs.h"
+#include "roboteqThread.h"
+#include <atomic>
+
+// Roboteq multi port I/O engine
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details at
+// http://www.gnu.org/copyleft/gpl.html
+
+// One thread serving many ports. Every registered SerialPort fd sits
+// in one epoll set. When a port turns readable the engine does a single
+// read() into that port's receive buffer, frames every complete reply
+// and dispatches it to the port's listener. Same filtering as the
+// RoboteqCom reader ('+' acks are dropped).
+//
+// Listeners run on engine thread with engine lock held. Do not
+// Add/Remove from inside OnMsgEvent.
+//
+// Port may come with IEngineService for timed work such as a closing
+// batch window. Engine does not sleep past its due time and calls
+// Service once it is reached. Same lock rule as for listeners.
+
+namespace oxoocoffee
+{
+
+class IEngineService
+{
+    public:
+                // Absolute SerialClock::NowNs() time of next timed
+                // work, 0 when there is none
+        virtual uint64_t    ServiceDueNs(void) = 0;
+        virtual void        Service(void) = 0;
+
+    protected:
+        virtual ~IEngineService(void) {}
+};
+
+class RoboteqEngine : public IRunnable
+{
+    typedef IEventListener<const IEventArgs>  IRoboteqEvent;
+
+    public:
+                 RoboteqEngine(SerialLogger& log);
+        virtual ~RoboteqEngine(void);
+
+                // Port must be connected. Remove before disconnecting it
+        void    Add(SerialPort& port, IRoboteqEvent& event,
+                    IEngineService* pService = 0L);
+        void    Remove(SerialPort& port);
+
+                // Makes Poll look at service due times again.
+                // For new timed work, any thread
+        void    Wake(void);
+
+                // Threaded mode
+        void    Start(void);
+        void    Stop(void);
+
+                // Single pass. Waits up to timeoutMs (-1 forever), less
+                // when a service is due, and returns number of replies
+                // dispatched
+        int     Poll(int timeoutMs);
+
+        inline  bool            IsRunning(void) const { return _thread.IsRunning(); }
+        inline  unsigned int    Count(void)     const { return _count; }
+
+    protected:
+        // IRunnable override
+        virtual void Run(void);
+
+    private:
+        struct Entry
+        {
+            SerialPort*     port;
+            IRoboteqEvent*  event;
+            IEngineService* service;
+            uint64_t        dueNs;      // Service due seen by last wait
+            string          frame;
+            Entry*          next;
+        };
+
+        enum { MAX_EVENTS = 64 };
+
+        int     Dispatch(Entry* pEntry);
+        int     ServiceWaitMs(int timeoutMs);
+        void    RunServices(void);
+        void    Unlink(Entry* pEntry);
+
+    private:
+        SerialLogger&   _logger;
+        int             _epfd;
+        int             _wakeFd;    // eventfd used by Stop and Wake
+        Entry*          _entries;
+        Entry*          _dead;      // Unlinked, freed at end of Poll
+        unsigned int    _count;
+        std::atomic<bool> _stop;
+        RoboMutex       _mtx;
+        RoboteqThread   _thread;
+};
+
+}   // End of namespace oxoocoffee
+
+#endif // __ROBOTEQ_ENGINE_H__
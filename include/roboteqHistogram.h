@@ -0,0 +1,102 @@
+#ifndef __ROBOTEQ_HISTOGRAM_H__
+#define __ROBOTEQ_HISTOGRAM_H__
+
+#include <atomic>
+#include <stdint.h>
+
+// Roboteq latency histogram
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details at
+// http://www.gnu.org/copyleft/gpl.html
+
+// HDR style log linear histogram of nanosecond values. Each power of two
+// range is split in 32 buckets, so any value is off by at most ~3%.
+// Covers up to 2^40 ns (~18 min), larger values land in last bucket.
+// Record is a few relaxed atomic adds, safe from any thread. Snapshot
+// copies counters out for percentile math. Reset is not atomic against
+// concurrent Record (a value may land half in old, half in new data).
+
+namespace oxoocoffee
+{
+    class RoboteqHistogram
+    {
+        public:
+            enum
+            {
+                SUB_BITS    = 5,
+                SUB_COUNT   = 1 << SUB_BITS,
+                MAX_BITS    = 40,
+                BUCKETS     = (MAX_BITS - SUB_BITS + 1) * SUB_COUNT
+            };
+
+            struct Snapshot
+            {
+                uint64_t    counts[BUCKETS];
+                uint64_t    total;
+                uint64_t    sum;
+                uint64_t    min;        // 0 when empty
+                uint64_t    max;
+
+                        // pct 0..100. Upper edge of bucket holding it
+                uint64_t    Percentile(double pct) const;
+                double      Mean(void) const;
+            };
+
+                     RoboteqHistogram(void);
+
+            inline void Record(uint64_t valueNs)
+            {
+                _counts[Index(valueNs)].fetch_add(1, std::memory_order_relaxed);
+                _sum.fetch_add(valueNs, std::memory_order_relaxed);
+
+                uint64_t cur = _max.load(std::memory_order_relaxed);
+
+                while( valueNs > cur &&
+                       _max.compare_exchange_weak(cur, valueNs, std::memory_order_relaxed) == false )
+                    ;
+
+                cur = _min.load(std::memory_order_relaxed);
+
+                while( valueNs < cur &&
+                       _min.compare_exchange_weak(cur, valueNs, std::memory_order_relaxed) == false )
+                    ;
+            }
+
+            void     GetSnapshot(Snapshot& snap) const;
+            void     Reset(void);
+
+            static inline unsigned int Index(uint64_t value)
+            {
+                if( value < SUB_COUNT )
+                    return (unsigned int)value;
+
+                unsigned int msb = 63 - __builtin_clzll(value);
+
+                if( msb >= MAX_BITS )
+                    return BUCKETS - 1;
+
+                unsigned int shift = msb - SUB_BITS;
+
+                return (shift + 1) * SUB_COUNT + (unsigned int)(value >> shift) - SUB_COUNT;
+            }
+
+                    // Largest value that lands in bucket
+            static uint64_t UpperEdge(unsigned int index);
+
+        private:
+            std::atomic<uint64_t>   _counts[BUCKETS];
+            std::atomic<uint64_t>   _sum;
+            std::atomic<uint64_t>   _min;
+            std::atomic<uint64_t>   _max;
+    };
+}
+
+#endif // __ROBOTEQ_HISTOGRAM_H__
@@ -0,0 +1,102 @@
+#ifndef __ROBOTEQ_QUERY_H__
+#define __ROBOTEQ_QUERY_H__
+
+#include <string>
+#include <pthread.h>
+#include <stdint.h>
+
+// Roboteq query handle
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details at
+// http://www.gnu.org/copyleft/gpl.html
+
+// Future for one outstanding query ("?V", "@02?A 1", "?$1E"...). Owned by
+// caller and linked into RoboteqCom while pending, so issuing it does not
+// allocate. Reader thread completes it when reply with same key and CAN
+// node arrives, or when its timeout passes. Destroying a pending query
+// cancels it.
+
+namespace oxoocoffee
+{
+    using namespace std;
+
+    class RoboteqCom;
+    class RoboteqQuery;
+
+    // Completion callback. Runs on reader thread
+    class IQueryDone
+    {
+        public:
+            virtual void OnQueryDone(RoboteqQuery& query) = 0;
+
+        protected:
+            virtual ~IQueryDone(void) {}
+    };
+
+    class RoboteqQuery
+    {
+        friend class RoboteqCom;
+
+        public:
+            enum
+            {
+                MAX_KEY_LEN = 15        // "FID", "BA", "VAR"... fit easily
+            };
+
+            enum eStatus
+            {
+                eStatus_Idle,
+                eStatus_Pending,
+                eStatus_Done,
+                eStatus_Timeout,
+                eStatus_Failed      // Not sent, cancelled or port closed
+            };
+
+                     RoboteqQuery(void);
+                    ~RoboteqQuery(void);
+
+                    // Blocks until query is no longer pending.
+                    // true when reply arrived
+            bool     Wait(void);
+
+            eStatus  Status(void) const;
+
+                    // Whole reply ("V=135:241:4980") and part after '='
+            inline const string& Reply(void)   const { return _reply; }
+                   string        Value(void)   const;
+            inline string        Key(void)     const { return string(_key, _keyLen); }
+            inline unsigned int  Node(void)    const { return _node; }
+            inline uint64_t      LatencyNs(void) const { return _latencyNs; }
+
+        private:
+                     RoboteqQuery(const RoboteqQuery&);
+            RoboteqQuery& operator=(const RoboteqQuery&);
+
+            void     Complete(eStatus status);
+
+            mutable pthread_mutex_t _mx;
+            pthread_cond_t  _cond;
+            eStatus         _status;
+            bool            _finished;      // Status final and callback returned
+            char            _key[MAX_KEY_LEN + 1];
+            unsigned int    _keyLen;
+            unsigned int    _node;
+            string          _reply;
+            uint64_t        _sentNs;
+            uint64_t        _deadlineNs;
+            uint64_t        _latencyNs;
+            IQueryDone*     _pDone;
+            RoboteqCom*     _pCom;
+            RoboteqQuery*   _pNext;
+    };
+}
+
+#endif // __ROBOTEQ_QUERY_H__
@@ -0,0 +1,80 @@
+#ifndef __ROBOTEQ_REPLY_RING_H__
+#define __ROBOTEQ_REPLY_RING_H__
+
+#include "serialClock.h"
+#include <atomic>
+
+// Roboteq reply handoff ring
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details at
+// http://www.gnu.org/copyleft/gpl.html
+
+// Bounded single producer / single consumer ring of preallocated reply
+// slots. Reader thread pushes, consumer thread peeks and releases.
+// No locks and no allocation after construction. When full the newest
+// reply is dropped so reader never waits on a slow consumer.
+
+namespace oxoocoffee
+{
+    class RoboteqReplyRing
+    {
+        public:
+            struct Stats
+            {
+                unsigned long   pushed;
+                unsigned long   popped;
+                unsigned long   dropped;    // Ring full or reply too long
+                unsigned int    highWater;  // Most slots in use, as producer saw it
+                unsigned int    capacity;
+            };
+
+                     // slots is rounded up to power of two
+                     RoboteqReplyRing(unsigned int slots, unsigned int slotBytes);
+                    ~RoboteqReplyRing(void);
+
+                    // Producer only
+            bool     Push(const char* pData, unsigned int len,
+                          const RxStamp& stamp = RxStamp());
+
+                    // Consumer only. Oldest reply stays valid until Release
+            bool     Peek(const char*& pData, unsigned int& len) const;
+            bool     Peek(const char*& pData, unsigned int& len, RxStamp& stamp) const;
+            void     Release(void);
+
+            unsigned int Size(void) const;
+            void     GetStats(Stats& stats) const;
+            void     ResetStats(void);
+
+        private:
+                     RoboteqReplyRing(const RoboteqReplyRing&);
+            RoboteqReplyRing& operator=(const RoboteqReplyRing&);
+
+            char*                       _data;
+            unsigned int*               _lengths;
+            RxStamp*                    _stamps;
+            unsigned int                _mask;
+            unsigned int                _slotBytes;
+
+            // Producer and consumer indexes live on own cache lines
+            char                        _pad0[64];
+            std::atomic<unsigned int>   _head;      // Next slot to write
+            unsigned int                _cachedTail;
+            std::atomic<unsigned long>  _pushed;
+            std::atomic<unsigned long>  _dropped;
+            std::atomic<unsigned int>   _highWater;
+            char                        _pad1[64];
+            std::atomic<unsigned int>   _tail;      // Next slot to read
+            std::atomic<unsigned long>  _popped;
+            char                        _pad2[64];
+    };
+}
+
+#endif // __ROBOTEQ_REPLY_RING_H__
@@ -0,0 +1,68 @@
+#ifndef __ROBOTEQ_TELEMETRY_H__
+#define __ROBOTEQ_TELEMETRY_H__
+
+#include <string>
+
+// Roboteq telemetry reply parser
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details at
+// http://www.gnu.org/copyleft/gpl.html
+
+// Decodes "KEY=v1:v2:..." query replies into fixed size struct.
+// Works on caller's bytes in place. No copies, no heap, input is
+// never modified. Key table is ordered so "CR" is tried before "C".
+
+namespace oxoocoffee
+{
+    using namespace std;
+
+    class RoboteqTelemetry
+    {
+        public:
+            enum eKey
+            {
+                eKey_Unknown,
+                eKey_S,         // Encoder speed RPM
+                eKey_A,         // Motor amps x10
+                eKey_V,         // Internal:Battery:5V volts x10
+                eKey_T,         // Temperature C
+                eKey_C,         // Absolute encoder count
+                eKey_CR,        // Relative encoder count
+                eKey_BA,        // Battery amps x10
+                eKey_FF,        // Fault flags
+                eKey_P,         // Motor power output
+                eKey_Count
+            };
+
+            enum
+            {
+                MAX_VALUES = 8
+            };
+
+            struct Reply
+            {
+                eKey            key;
+                unsigned int    count;
+                long            values[MAX_VALUES];
+            };
+
+                    // Returns false on unknown key or malformed value
+                    // list. Leading non alpha echo byte and trailing
+                    // '\r' are skipped
+            static bool         Parse(const char* pReply, unsigned int len, Reply& reply);
+            static inline bool  Parse(const string& reply, Reply& out)
+                                    { return Parse(reply.data(), reply.size(), out); }
+
+            static const char*  KeyName(eKey key);
+    };
+}
+
+#endif // __ROBOTEQ_TELEMETRY_H__
@@ -0,0 +1,130 @@
+#ifndef __SERIAL_ASYNC_LOGGER_H__
+#define __SERIAL_ASYNC_LOGGER_H__
+
+#include "serialLogger.h"
+#include "serialException.h"
+#include <string>
+#include <atomic>
+#include <stdint.h>
+#include <pthread.h>
+
+// Asynchronous file logger
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details at
+// http://www.gnu.org/copyleft/gpl.html
+
+// SerialLogger for reader / writer threads. Log calls copy the message
+// into a bounded lock free multi producer ring of fixed slots and
+// return. Flusher thread drains it every FLUSH_MS into one write().
+//
+// Full ring either drops the new line (eDrop_Newest, default, caller
+// never waits) or spins until flusher makes room (eDrop_Block). Drops
+// are counted and reported in the file. Messages longer than a slot
+// are cut. Close drains everything. Once application opts in with
+// InstallCrashHandler, fatal signals (SEGV, BUS, FPE, ILL, ABRT) drain
+// open loggers and run AddCrashFlush hooks with plain write() before
+// process dies
+
+namespace oxoocoffee
+{
+    using namespace std;
+
+    class SerialAsyncLogger : public SerialLogger
+    {
+        public:
+            enum eDrop
+            {
+                eDrop_Newest,
+                eDrop_Block
+            };
+
+            enum
+            {
+                SLOT_DATA     = 240,        // Longest message kept whole
+                FLUSH_MS      = 10,
+                CRASH_FLUSHES = 4,
+                BATCH         = 64 * 1024   // Bytes per write()
+            };
+
+                    // slots is rounded up to power of two
+                     SerialAsyncLogger(unsigned int slots = 4096);
+            virtual ~SerialAsyncLogger(void);
+
+                    // Appends to filePath
+            bool    Open(const string& filePath);
+            void    Close(void);
+
+            inline  void    SetDropPolicy(eDrop policy) { _policy = policy; }
+
+            virtual bool    IsLogOpen(void) const { return _fd != -1; }
+
+            virtual void    LogLine(const char* pBuffer, unsigned int len);
+            virtual void    LogLine(const std::string& message);
+
+                    // DO NOT Write new line at end
+            virtual void    Log(const char* pBuffer, unsigned int len);
+            virtual void    Log(const std::string& message);
+
+            inline  unsigned long   Lines(void)     const { return _lines.load(std::memory_order_relaxed); }
+            inline  unsigned long   Dropped(void)   const { return _dropped.load(std::memory_order_relaxed); }
+            inline  unsigned long   Truncated(void) const { return _truncated.load(std::memory_order_relaxed); }
+            inline  unsigned long   Writes(void)    const { return _writes.load(std::memory_order_relaxed); }
+
+                    // Opt in, process wide. Installs handler for fatal
+                    // signals that drains open loggers and crash flushes,
+                    // then re-raises with previous handler. Nothing is
+                    // installed unless this is called. Idempotent
+            static  void    InstallCrashHandler(void);
+
+                    // Extra flush run by fatal signal handler after loggers,
+                    // e.g. SerialCapture. pFn must be async signal safe.
+                    // Returns false when all CRASH_FLUSHES are taken
+            static  bool    AddCrashFlush(void (*pFn)(void*), void* pArg);
+            static  void    RemoveCrashFlush(void* pArg);
+
+        private:
+            struct Slot
+            {
+                std::atomic<size_t> seq;
+                uint16_t            len;
+                bool                newline;
+                char                data[SLOT_DATA];
+            };
+
+            void    Push(const char* pBuffer, unsigned int len, bool newline);
+            bool    Drain(void);
+            void    WriteOut(const char* pBuffer, unsigned int len);
+
+            static void* ThreadFn(void* ptr);
+                   void  Flusher(void);
+            static void  OnFatalSignal(int sig);
+
+        private:
+            Slot*                       _slots;
+            size_t                      _mask;
+            std::atomic<size_t>         _head;      // Next slot producers claim
+            size_t                      _tail;      // Next slot flusher takes
+            std::atomic<bool>           _draining;  // Flusher or crash handler
+            int                         _fd;
+            eDrop                       _policy;
+            pthread_t                   _thread;
+            std::atomic<bool>           _stop;
+            char                        _batch[BATCH];
+            unsigned int                _batchLen;
+            std::atomic<unsigned long>  _lines;
+            std::atomic<unsigned long>  _dropped;
+            std::atomic<unsigned long>  _truncated;
+            unsigned long               _reported;  // Drops already noted in file
+            std::atomic<unsigned long>  _writes;
+    };
+}   // End of namespace oxoocoffee
+
+#endif // __SERIAL_ASYNC_LOGGER_H__
@@ -0,0 +1,35 @@
+#ifndef __SERIAL_BAUD_H__
+#define __SERIAL_BAUD_H__
+
+// Serial custom baud rate
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details at
+// http://www.gnu.org/copyleft/gpl.html
+
+// Arbitrary bit rates through Linux termios2 / BOTHER. Lives in own
+// file since <asm/termbits.h> can not be included with <termios.h>.
+// Elsewhere IsSupported is false and Set fails with ENOTSUP
+
+namespace oxoocoffee
+{
+    class SerialBaud
+    {
+        public:
+            static bool IsSupported(void);
+
+                    // Both directions to rate on open fd. false and errno on error
+            static bool Set(int fd, unsigned int rate);
+                    // Output rate driver reports, may be rounded. false and errno on error
+            static bool Get(int fd, unsigned int& rate);
+    };
+}   // End of namespace oxoocoffee
+
+#endif // __SERIAL_BAUD_H__
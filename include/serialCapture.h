@@ -0,0 +1,109 @@
+#ifndef __SERIAL_CAPTURE_H__
+#define __SERIAL_CAPTURE_H__
+
+#include "serialException.h"
+#include <string>
+#include <vector>
+#include <atomic>
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+
+// Serial session capture
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details at
+// http://www.gnu.org/copyleft/gpl.html
+
+// Binary capture of every read() / write() chunk. Host byte order.
+//
+//   header   "RCAP" u32 version, u64 CLOCK_MONOTONIC ns, u64 CLOCK_REALTIME ns
+//   record   u64 ns since header, u32 length | TX_FLAG, length bytes
+//
+// Write is called from reader and writer threads, it copies into a
+// small buffer under a mutex. Buffer goes out with write() when full,
+// once FLUSH_MS passed since last write() (checked by Write and by a
+// SerialPort read that sits idle), and from the fatal signal handler
+// (SerialAsyncLogger::AddCrashFlush, once application installed it).
+// Chunks over MAX_RECORD are split. Write errors are counted, never
+// thrown
+
+namespace oxoocoffee
+{
+    using namespace std;
+
+    class SerialCapture
+    {
+        public:
+            enum eDir
+            {
+                eDir_RX,
+                eDir_TX
+            };
+
+            enum
+            {
+                VERSION  = 1,
+                TX_FLAG  = 0x80000000,
+                BUFFER   = 4096,
+                FLUSH_MS = 100,
+                MAX_RECORD = 0x100000     // Load treats longer as corrupt
+            };
+
+            struct Record
+            {
+                uint64_t    ns;         // Since capture start
+                eDir        dir;
+                string      data;
+            };
+
+                     SerialCapture(void);
+                    ~SerialCapture(void);
+
+            void    Open(const string& path);
+            void    Close(void);
+
+            inline  bool          IsOpen(void)  const { return _fd != -1; }
+            inline  unsigned long Records(void) const { return _records; }
+            inline  unsigned long Errors(void)  const { return _errors; }
+
+            void    Write(eDir dir, const char* pData, unsigned int len);
+
+                    // Absolute SerialClock::NowNs() time buffered data is
+                    // due on disk, 0 when nothing is buffered
+            uint64_t FlushDueNs(void);
+            void    Flush(void);
+
+                    // Whole file, throws when it is not a capture
+            static  void    Load(const string& path, vector<Record>& records);
+                    // Only checks header
+            static  bool    IsCapture(const string& path);
+
+        private:
+            void    Append(const void* pData, unsigned int len);
+            void    FlushLocked(void);
+
+            static  bool    WriteOut(int fd, const char* pData, unsigned int len);
+            static  void    OnCrash(void* ptr);
+
+        private:
+            int                 _fd;
+            uint64_t            _startNs;
+            uint64_t            _flushNs;       // Last write()
+            char                _buf[BUFFER];
+            unsigned int        _len;
+            std::atomic<bool>   _busy;          // Write or crash handler owns _buf
+            pthread_mutex_t     _mtx;
+            unsigned long       _records;
+            unsigned long       _errors;
+    };
+}   // End of namespace oxoocoffee
+
+#endif // __SERIAL_CAPTURE_H__
@@ -0,0 +1,84 @@
+#ifndef __SERIAL_CLOCK_H__
+#define __SERIAL_CLOCK_H__
+
+#include <time.h>
+#include <stdint.h>
+
+// Monotonic clock and deadline helpers
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details at
+// http://www.gnu.org/copyleft/gpl.html
+
+// All deadlines are absolute CLOCK_MONOTONIC times so a deadline
+// survives retries (EINTR, partial reads) without drifting
+
+namespace oxoocoffee
+{
+    class SerialClock
+    {
+        public:
+            static inline timespec  Now(void)
+            {
+                timespec ts;
+                ::clock_gettime(CLOCK_MONOTONIC, &ts);
+                return ts;
+            }
+
+            static inline uint64_t  NowNs(void)
+            {
+                return ToNs( Now() );
+            }
+
+            static inline uint64_t  ToNs(const timespec& ts)
+            {
+                return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+            }
+
+            static inline timespec  FromNs(uint64_t ns)
+            {
+                timespec ts;
+                ts.tv_sec  = ns / 1000000000ULL;
+                ts.tv_nsec = ns % 1000000000ULL;
+                return ts;
+            }
+
+            // Absolute deadline ms milliseconds from now
+            static inline timespec  DeadlineIn(unsigned int ms)
+            {
+                return FromNs( NowNs() + (uint64_t)ms * 1000000ULL );
+            }
+
+            // Milliseconds left until deadline rounded up. 0 if expired
+            static inline int       RemainingMs(const timespec& deadline)
+            {
+                uint64_t now = NowNs();
+                uint64_t end = ToNs(deadline);
+
+                if( end <= now )
+                    return 0;
+
+                return (int)((end - now + 999999ULL) / 1000000ULL);
+            }
+    };
+
+    // Receive time of one frame in CLOCK_MONOTONIC ns, 0 when unknown.
+    // Stamps come from read() return less wire time of bytes that
+    // followed in same chunk, so they are estimates at best
+    // SerialClock::NowNs() values, 0 when unknown
+    struct RxStamp
+    {
+        uint64_t    firstNs;    // First byte arrived
+        uint64_t    lastNs;     // Terminator arrived
+        uint64_t    sampleNs;   // lastNs less wire time of whole frame
+    };
+}   // End of namespace oxoocoffee
+
+#endif // __SERIAL_CLOCK_H__
@@ -2,6 +2,8 @@
 #define __SERIAL_LOGGER_H__
 
 #include <string>
+#include <sstream>
+#include <atomic>
 
 // Serial Logger Interface
 // Robert J. Gebis (oxoocoffee) <rjgebis@yahoo.com>
@@ -26,10 +28,29 @@ namespace oxoocoffee
 class SerialLogger
 {
     public:
-        SerialLogger(void) {}
+        enum eLevel
+        {
+            eLevel_Debug,       // Per frame / per command tracing
+            eLevel_Info,
+            eLevel_Warn,
+            eLevel_Error,
+            eLevel_None
+        };
+
+        SerialLogger(void) : _level(eLevel_Info) {}
 
         virtual bool    IsLogOpen(void) const = 0;
 
+                        // Any thread, SERIAL_LOG callers see it with relaxed loads
+        inline  void    SetLevel(eLevel level)      { _level.store(level, std::memory_order_relaxed); }
+        inline  eLevel  Level(void) const           { return _level.load(std::memory_order_relaxed); }
+                        // Level check first, no virtual call when filtered out
+        inline  bool    IsLogging(eLevel level) const { return level >= Level() && IsLogOpen(); }
+
+                // Used by SERIAL_LOG macros. Loggers that have their
+                // own severities (ROS) override it, others get LogLine
+        virtual void    LogLineAt(eLevel /*level*/, const std::string& message) { LogLine(message); }
+
 		// Write new line at end
         virtual void    LogLine(const char* pBuffer, unsigned int len) = 0;
         virtual void    LogLine(const std::string& message) = 0;
@@ -37,9 +58,39 @@ class SerialLogger
 		// DO NOT Write new line at end
         virtual void    Log(const char* pBuffer, unsigned int len) = 0;
         virtual void    Log(const std::string& message) = 0;
+
+    private:
+        std::atomic<eLevel> _level;
 };
 
 }   // End of namespace oxoocoffee
 
+// Lazily formatted logging. Stream expression is only evaluated when
+// logger is open and level passes, e.g.
+//
+//   SERIAL_LOG_INFO(_logger, "SerialPort - setting baud to " << baud);
+//
+// Build with -DSERIAL_LOG_STRIP_DEBUG to compile SERIAL_LOG_DEBUG out
+// altogether, arguments included
+#define SERIAL_LOG(logger, level, expr)                                 \
+    do                                                                  \
+    {                                                                   \
+        if( (logger).IsLogging(level) )                                 \
+        {                                                               \
+            std::ostringstream serialLogMsg_; serialLogMsg_ << expr;    \
+            (logger).LogLineAt(level, serialLogMsg_.str());             \
+        }                                                               \
+    } while(0)
+
+#ifdef SERIAL_LOG_STRIP_DEBUG
+#define SERIAL_LOG_DEBUG(logger, expr)  do {} while(0)
+#else
+#define SERIAL_LOG_DEBUG(logger, expr)  SERIAL_LOG(logger, oxoocoffee::SerialLogger::eLevel_Debug, expr)
+#endif
+
+#define SERIAL_LOG_INFO(logger, expr)   SERIAL_LOG(logger, oxoocoffee::SerialLogger::eLevel_Info, expr)
+#define SERIAL_LOG_WARN(logger, expr)   SERIAL_LOG(logger, oxoocoffee::SerialLogger::eLevel_Warn, expr)
+#define SERIAL_LOG_ERROR(logger, expr)  SERIAL_LOG(logger, oxoocoffee::SerialLogger::eLevel_Error, expr)
+
 #endif // __SERIAL_LOGGER_H__
 
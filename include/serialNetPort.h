@@ -3,6 +3,7 @@
 
 #include "serialLogger.h"
 #include "serialException.h"
+#include "serialTransport.h"
 
 // Serial Network Class
 // Robert J. Gebis (oxoocoffee) <rjgebis@yahoo.com>
@@ -20,12 +21,15 @@
 // MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
 // General Public License for more details at
 // http://www.gnu.org/copyleft/gpl.html
+
+// TCP link, e.g. to a serial device server or a simulator. Nagle is
+// off so each command leaves at once. Address for Open is "host:port"
  
 namespace oxoocoffee
 {
     using namespace std;
 
-    class SerialNetPort 
+    class SerialNetPort : public ITransport
     {
         public:
                      SerialNetPort(SerialLogger& log);
@@ -34,12 +38,23 @@ namespace oxoocoffee
                     bool isOpen(void) const;
             virtual void connect(const string& host, unsigned short port);
             virtual void disconnect(void);
+            inline  int  fd(void) const { return _fd; }
+
+                    // Rate of serial line behind a device server, 0 if none
+            inline  void setLineRate(unsigned int bitsPerSec) { _lineRate = bitsPerSec; }
+
+            // ITransport
+            virtual int          Open(const string& address);
+            virtual void         Close(int fd);
+            virtual int          PendingOutput(int fd) const;
+            virtual unsigned int LineRate(void) const { return _lineRate; }
+            virtual const char*  Name(void) const     { return "tcp"; }
             
         private:
             SerialLogger&    _logger;
+            int              _fd;
+            unsigned int     _lineRate;
     };
 }
 
 #endif // __SERIAL_NETWORK_PORT_H__
-
-
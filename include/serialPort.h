@@ -3,7 +3,11 @@
 
 #include "serialLogger.h"
 #include "serialException.h"
+#include "serialClock.h"
+#include "serialTransport.h"
+#include "serialCapture.h"
 #include <list>
+#include <atomic>
 #include <termios.h>
 
 // Serial Device Class
@@ -41,6 +45,18 @@ namespace oxoocoffee
     {
         const int   INVALID_FD;
 
+        // Receive buffer size. Large enough to hold several
+        // telemetry frames so one read() serves many replies
+        enum { RX_BUFFER_SIZE = 4096 };
+
+        // read() chunks remembered for frame stamps. Oldest two
+        // are merged when more are buffered than this
+        enum { RX_CHUNKS = 32 };
+
+        // Throughput profile gathers this many bytes, or until line
+        // is quiet for GAP_CHARS character times, before read()
+        enum { THROUGHPUT_BYTES = 64, THROUGHPUT_GAP_CHARS = 3 };
+
         public:
             enum eParity
             {
@@ -77,6 +93,54 @@ namespace oxoocoffee
                 eCanonical_Enable   // Line mode
             };
 
+            // Receive tuning. LowLatency asks driver to push bytes up
+            // at once (ASYNC_LOW_LATENCY, e.g. FTDI latency timer 16 ms
+            // -> 1 ms) and returns each read() on first byte. Throughput
+            // lets driver batch and waits for THROUGHPUT_BYTES or a
+            // quiet gap of THROUGHPUT_GAP_CHARS character times before
+            // read(), so a lone frame is late by that gap only (no gap
+            // without a line rate). tty always keeps VMIN 0 / VTIME 0,
+            // waits stay in poll where deadline and interrupt apply.
+            // Default leaves driver flags alone
+            enum eProfile
+            {
+                eProfile_Default,
+                eProfile_LowLatency,
+                eProfile_Throughput
+            };
+
+            // What the driver reports after settings were applied
+            struct ProfileReport
+            {
+                eProfile        profile;
+                bool            serialInfo;     // TIOCGSERIAL works on device
+                bool            lowLatency;     // ASYNC_LOW_LATENCY set, read back
+                int             lowLatencyErrno;// TIOCSSERIAL failure, 0 if fine
+                unsigned int    gatherBytes;    // Throughput gather target, 0 if off
+                unsigned int    gatherGapUs;    // Quiet gap ending a gather
+            };
+
+            // Whole line setup in one go. Validated by configure, put
+            // on device with one tcsetattr. With skipIfMatching nothing
+            // is written when tty already has these settings (typical
+            // on reconnect, saves a USB control transfer)
+            struct Config
+            {
+                eCanonical      canonical;
+                unsigned int    baud;
+                eDataSize       dataSize;
+                eStopBit        stopBit;
+                eParity         parity;
+                eFlow           flow;
+                eProfile        profile;
+                bool            skipIfMatching;
+
+                Config(void)
+                  : canonical(eCanonical_Disable), baud(9600), dataSize(eDataSize_8Bit),
+                    stopBit(eStopBit_1), parity(eParity_None), flow(eFlow_None),
+                    profile(eProfile_Default), skipIfMatching(true) {}
+            };
+
             typedef list<string>   TList;
 
                      SerialPort(SerialLogger& log);
@@ -84,23 +148,128 @@ namespace oxoocoffee
 
                             // connect will block if not device connected and running!!!!
             virtual void    connect(const string& device);
+                            // Same with config applied once on open
+                    void    connect(const string& device, const Config& config);
+
+                            // Link other than a tty (TCP, pty, replay). Set
+                            // while closed, 0L goes back to tty. device is
+                            // then passed to ITransport::Open as address and
+                            // line settings are kept but not applied
+                    void    transport(ITransport* pTransport);
+            inline  ITransport* Transport(void) const { return _pTransport; }
+
+                            // Every read() / write() chunk is also recorded
+                            // there, 0L stops. Caller keeps it alive
+                    void    capture(SerialCapture* pCapture);
             virtual void    disconnect(bool echo = true);
 
             inline  bool    isOpen(void) const { return _fd != INVALID_FD; }
+
+                            // Wakes any thread waiting in read / readFrame /
+                            // skipUntil, timed or not, and makes every later
+                            // wait fail with ECANCELED until connect or
+                            // disconnect. fd stays open, so caller can join
+                            // its reader before closing
+                    void    interrupt(void);
+            inline  bool    interrupted(void) const { return _interrupted; }
+                            // Ends one read / readFrame / skipUntil wait early
+                            // with 0 (errno EINTR), e.g. so reader picks up new
+                            // timed work. Used up by that wait, unlike interrupt.
+                            // Writes are not affected. Any thread
+                    void    wake(void);
                             // Canonical mode does not work on Roboteq Device
                     void    canonical(const eCanonical mode);
+                            // Any rate. Ones without a Bxxx constant go
+                            // through termios2 / BOTHER (Linux only, see
+                            // serialBaud.h). Driver may round, baudRate()
+                            // then reports what it took
                     void    baud(const unsigned int& baud);
                     void    dateSize(const eDataSize size);
                     void    stopBit(const eStopBit stop);
                     void    parity(const eParity parity);
                     void    flowControl(const eFlow flow);
+                    void    profile(const eProfile profile);
+                            // Throws before touching anything if config is bad
+                    void    configure(const Config& config);
             
+                            // Single write(). fd is non blocking, so it can
+                            // write less or fail with EAGAIN when driver
+                            // buffer is full. writeAll waits instead
                     int     write(const string& mseeage);
                     int     write(const char* pBuffer, const unsigned int numBytes);
                     int     read(char* pBuffer, const unsigned int numBytes);
 
+                            // Keeps writing until all numBytes are out. Retries
+                            // short writes and EINTR, waits for POLLOUT on
+                            // EAGAIN. Returns numBytes or -1 (bytes already
+                            // written stay written). Wait can be interrupted
+                            // (errno ECANCELED) and, timed one, expire (ETIMEDOUT)
+                    int     writeAll(const char* pBuffer, const unsigned int numBytes);
+                    int     writeAll(const char* pBuffer, const unsigned int numBytes,
+                                     const timespec& deadline);
+
+                            // Timed read. deadline is absolute CLOCK_MONOTONIC
+                            // (see SerialClock::DeadlineIn). Returns 0 and sets
+                            // errno to ETIMEDOUT when deadline passes first
+                    int     read(char* pBuffer, const unsigned int numBytes,
+                                 const timespec& deadline);
+
+                            // Buffered reads. Both refill the receive buffer with
+                            // one large read() when it runs dry.
+                            // readFrame returns length of next non empty frame
+                            // ending with terminator (terminator not included),
+                            // 0 when woken or timed out, < 0 on error (errno
+                            // EPIPE once peer closed the link). skipUntil drops
+                            // everything up to and including ch
+                    int     readFrame(string& frame, const char terminator);
+                    bool    skipUntil(const char ch);
+
+                            // Same as above but give up at deadline (errno ETIMEDOUT)
+                    int     readFrame(string& frame, const char terminator,
+                                      const timespec& deadline);
+                    bool    skipUntil(const char ch, const timespec& deadline);
+
+                            // Event loop helpers. receive does exactly one read()
+                            // into receive buffer. popFrame frames what is already
+                            // buffered without touching the device
+                    int     receive(void);
+                    bool    popFrame(string& frame, const char terminator);
+
+                            // Stamps of frame last returned by readFrame or
+                            // popFrame. Sample time assumes controller began
+                            // sending right after sampling
+            inline  const RxStamp&  frameStamp(void) const { return _rxStamp; }
+
+            inline  int     fd(void) const { return _fd; }
+
+                            // Bytes written but not yet sent by driver (TIOCOUTQ)
+                            // -1 if driver can not tell
+                    int     pendingOutput(void) const;
+
+                            // Line model. Start + data + parity + stop bits
+                    unsigned int    bitsPerChar(void) const;
+            inline  unsigned int    baudRate(void)    const { return _baudRate; }
+                            // Time numBytes take on the wire at current settings
+            inline  uint64_t        wireTimeNs(unsigned int numBytes) const
+                    {
+                        unsigned int rate = _pTransport ? _pTransport->LineRate() : _baudRate;
+
+                        return rate ? (uint64_t)numBytes * bitsPerChar() * 1000000000ULL / rate : 0;
+                    }
+
+                            // Number of read()/write() syscalls issued since connect
+            inline  unsigned long   rxReadCount(void)  const { return _rxReads; }
+            inline  unsigned long   txWriteCount(void) const { return _txWrites; }
+                            // write() calls that sent less than asked
+            inline  unsigned long   txShortCount(void) const { return _txShort; }
+                            // Settings written to / found already on device
+            inline  unsigned long   configWriteCount(void) const { return _cfgWrites; }
+            inline  unsigned long   configSkipCount(void)  const { return _cfgSkips; }
+
                     void    log(const string& msg);
                     void    logLine(const string& msg);
+                            // For SERIAL_LOG macros of layers above
+            inline  SerialLogger&   logger(void) const { return _logger; }
 
             static  void    enumeratePorts(TList& lst, const string& path = "/dev/");
             static  void    printPorts(void);
@@ -110,19 +279,66 @@ namespace oxoocoffee
             eDataSize       DataSize(void)    const { return _dataSize; }
             eStopBit        StopBit(void)     const { return _stopBit; }
             eFlow           Flow(void)        const { return _flow; }
+            eProfile        Profile(void)     const { return _profile; }
+                            // Valid once connected
+            const ProfileReport& profileReport(void) const { return _profileReport; }
 
         private:
                     void    applySettings(void);
+                    void    applyProfile(void);
+            static  bool    baudConstant(unsigned int rate, speed_t& speed);
+                    int     fillRx(const timespec* pDeadline);
+                    bool    waitReadable(const timespec* pDeadline);
+                    bool    waitWritable(const timespec* pDeadline);
+                    void    gatherRx(const timespec* pDeadline);
+                    int     writeAllDeadline(const char* pBuffer, const unsigned int numBytes,
+                                             const timespec* pDeadline);
+                    int     readBuffered(char* pBuffer, const unsigned int numBytes);
+                    void    clearInterrupt(void);
+                    int     readFrameUntil(string& frame, const char terminator,
+                                           const timespec* pDeadline);
+                    bool    skipUntilDeadline(const char ch, const timespec* pDeadline);
+                    void    resetRx(void);
+                    uint64_t stampAt(unsigned int offset) const;
+                    void    stampFrame(unsigned int first, unsigned int last);
 
         private:
             SerialLogger&   _logger;
             int             _fd;
             speed_t         _baud;
+            unsigned int    _baudRate;
+            bool            _customBaud;    // _baudRate has no Bxxx constant
             eCanonical      _canonical;
             eParity         _parity;
             eDataSize       _dataSize;
             eStopBit        _stopBit;
             eFlow           _flow;
+            eProfile        _profile;
+            ProfileReport   _profileReport;
+            bool            _skipMatching;
+            ITransport*     _pTransport;
+            SerialCapture*  _pCapture;
+            int             _wakeFd;        // eventfd (pipe read end off Linux)
+            int             _wakeWriteFd;   // Same as _wakeFd on Linux
+            int             _kickFd;        // wake(), read waits only
+            int             _kickWriteFd;
+            std::atomic<bool> _interrupted;
+            char            _rxBuf[RX_BUFFER_SIZE];
+            unsigned int    _rxHead;    // First unread byte
+            unsigned int    _rxTail;    // One past last received byte
+            struct RxChunk
+            {
+                unsigned int    end;        // One past last byte of read()
+                uint64_t        ns;         // read() returned
+            };
+            RxChunk         _rxChunks[RX_CHUNKS];
+            unsigned int    _rxChunkCount;
+            RxStamp         _rxStamp;
+            unsigned long   _rxReads;
+            unsigned long   _txWrites;
+            unsigned long   _txShort;
+            unsigned long   _cfgWrites;
+            unsigned long   _cfgSkips;
     };
 }   // End of namespace oxoocoffee
 
@@ -0,0 +1,57 @@
+#ifndef __SERIAL_PTY_PORT_H__
+#define __SERIAL_PTY_PORT_H__
+
+#include "serialLogger.h"
+#include "serialException.h"
+#include "serialTransport.h"
+
+// Serial pty transport
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details at
+// http://www.gnu.org/copyleft/gpl.html
+
+// Master side of a fresh raw pty. Open ignores address and hands back
+// master fd, a simulator or test opens SlavePath(). Slave is held open
+// here as well so peer can come and go without master seeing EIO
+
+namespace oxoocoffee
+{
+    using namespace std;
+
+    class SerialPtyPort : public ITransport
+    {
+        public:
+                     SerialPtyPort(SerialLogger& log);
+            virtual ~SerialPtyPort(void);
+
+                    // Valid after Open
+            inline const string& SlavePath(void) const { return _slavePath; }
+
+                    // Wire time model for tests, 0 for none
+            inline  void setLineRate(unsigned int bitsPerSec) { _lineRate = bitsPerSec; }
+
+            // ITransport
+            virtual int          Open(const string& address);
+            virtual void         Close(int fd);
+            virtual int          PendingOutput(int fd) const;
+            virtual unsigned int LineRate(void) const { return _lineRate; }
+            virtual const char*  Name(void) const     { return "pty"; }
+
+        private:
+            SerialLogger&   _logger;
+            int             _master;
+            int             _slave;
+            string          _slavePath;
+            unsigned int    _lineRate;
+    };
+}   // End of namespace oxoocoffee
+
+#endif // __SERIAL_PTY_PORT_H__
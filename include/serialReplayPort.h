@@ -0,0 +1,88 @@
+#ifndef __SERIAL_REPLAY_PORT_H__
+#define __SERIAL_REPLAY_PORT_H__
+
+#include "serialLogger.h"
+#include "serialException.h"
+#include "serialTransport.h"
+#include "serialCapture.h"
+#include <vector>
+#include <atomic>
+#include <stdint.h>
+#include <pthread.h>
+
+// Serial replay transport
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details at
+// http://www.gnu.org/copyleft/gpl.html
+
+// Plays back bytes a controller sent. Open(path) takes a SerialCapture
+// file (RX records, optionally paced by their timestamps) or raw
+// received bytes, Open("") uses setData. Capture should start with
+// what controller answers during Open ("+" and ?$1E / ?$1F replies).
+// Whatever host writes is read and counted only. Socket pair
+// underneath so Close wakes reader
+
+namespace oxoocoffee
+{
+    using namespace std;
+
+    class SerialReplayPort : public ITransport
+    {
+        public:
+                     SerialReplayPort(SerialLogger& log);
+            virtual ~SerialReplayPort(void);
+
+                    // Before Open
+            inline  void setData(const string& data)   { _data = data; }
+            inline  void setRepeat(unsigned int count) { _repeat = count; }
+                    // Capture chunks keep their recorded spacing instead
+                    // of going out as fast as reader takes them
+            inline  void setRealTime(bool realTime)    { _realTime = realTime; }
+
+                    // Every repeat of data handed to reader side
+            inline  bool isDone(void) const { return _done; }
+            inline  unsigned long bytesFed(void)     const { return _fed; }
+            inline  unsigned long bytesReceived(void) const { return _received; }
+
+            // ITransport
+            virtual int          Open(const string& address);
+            virtual void         Close(int fd);
+            virtual int          PendingOutput(int fd) const;
+            virtual unsigned int LineRate(void) const { return 0; }
+            virtual const char*  Name(void) const     { return "replay"; }
+
+        private:
+            static void* ThreadFn(void* ptr);
+                   void  Feed(void);
+
+        private:
+            struct Chunk
+            {
+                uint64_t    ns;         // Since first chunk
+                string      data;
+            };
+
+            SerialLogger&           _logger;
+            string                  _data;
+            vector<Chunk>           _chunks;
+            unsigned int            _repeat;
+            bool                    _realTime;
+            int                     _host;      // Handed to SerialPort
+            int                     _feed;      // Feeder end
+            pthread_t               _thread;
+            bool                    _running;
+            std::atomic<bool>           _done;
+            std::atomic<unsigned long>  _fed;
+            std::atomic<unsigned long>  _received;
+    };
+}   // End of namespace oxoocoffee
+
+#endif // __SERIAL_REPLAY_PORT_H__
@@ -0,0 +1,46 @@
+#ifndef __SERIAL_TRANSPORT_H__
+#define __SERIAL_TRANSPORT_H__
+
+#include <string>
+
+// Serial link transport
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details at
+// http://www.gnu.org/copyleft/gpl.html
+
+// Where SerialPort gets its file descriptor from. SerialPort keeps doing
+// framing, stamps, timed reads and writes on whatever fd Open returns,
+// so RoboteqCom and RoboteqEngine run unchanged over any link. Without
+// a transport SerialPort opens and configures a tty itself.
+// fd must be pollable (tty, socket, pty master). SerialPort makes it
+// non blocking and waits with poll
+
+namespace oxoocoffee
+{
+    class ITransport
+    {
+        public:
+            virtual ~ITransport(void) {}
+
+                    // Throws on failure
+            virtual int          Open(const std::string& address) = 0;
+                    // Must wake up a reader blocked on fd where link allows
+            virtual void         Close(int fd) = 0;
+                    // Bytes written but not yet sent, -1 if not known
+            virtual int          PendingOutput(int fd) const = 0;
+                    // Bits per second behind link. 0 when not rate limited,
+                    // wire time is then taken as 0
+            virtual unsigned int LineRate(void) const = 0;
+            virtual const char*  Name(void) const = 0;
+    };
+}   // End of namespace oxoocoffee
+
+#endif // __SERIAL_TRANSPORT_H__
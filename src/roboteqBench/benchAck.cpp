@@ -0,0 +1,85 @@
+#include "benchUtil.h"
+#include "roboteqCom.h"
+#include <stdio.h>
+#include <unistd.h>
+
+class NullListener : public IEventListener<const IEventArgs>
+{
+    public:
+        virtual void OnMsgEvent(const IEventArgs&) {}
+};
+
+static const char* gStatusNames[] = { "idle", "pending", "accepted", "rejected", "timeout", "failed" };
+
+// Config writes are tracked with retries while motion keeps going
+// fire and forget at 100 Hz. Controller loses every dropEvery-th
+// command and rejects out of range values
+int     BenchAck(int argc, char* argv[])
+{
+    long dropEvery = ArgLong(argc, argv, 1, 7);
+    long commands  = ArgLong(argc, argv, 2, 200);
+    long retries   = ArgLong(argc, argv, 3, 2);
+
+    PtyPair         pty;
+    FakeController  ctl(pty.Master());
+    NullLogger      log;
+    NullListener    listener;
+    RoboteqCom      com(log, listener);
+    RoboteqAck      ack;
+    char            args[32];
+    long            status[6] = { 0, 0, 0, 0, 0, 0 };
+    unsigned long   attempts(0);
+
+    ctl.SetReplyLatency(500);
+    ctl.Start();
+
+    com.Open(RoboteqCom::eSerial, pty.SlavePath());
+    com.SetAckTracking(true, 20);
+    ctl.SetDropEvery(dropEvery);
+
+    printf("%ld tracked config writes (%ld retries), motion fire and forget, every %ld-th command lost\n",
+           commands, retries, dropEvery);
+
+    for( long Idx(0); Idx < commands; Idx++ )
+    {
+        snprintf(args, sizeof(args), "1 %ld", Idx % 50 == 49 ? 99999L : 1000 + Idx);
+
+        com.IssueTracked(ack, "^MXRPM", args, 20, retries);
+
+        snprintf(args, sizeof(args), "1 %ld", Idx % 1000);
+        com.IssueCommand("!G", args);
+
+        ack.Wait();
+
+        status[ack.Status()]++;
+        attempts += ack.Attempts();
+    }
+
+    // Last fire and forget answers
+    usleep(50000);
+
+    RoboteqCom::AckTypeStats stats[ROBO_ACK_TYPES];
+    unsigned int             count = com.GetAckStats(stats, ROBO_ACK_TYPES);
+
+    com.Close();
+    ctl.Stop();
+
+    printf("tracked:");
+
+    for( int Idx(RoboteqAck::eStatus_Accepted); Idx <= RoboteqAck::eStatus_Failed; Idx++ )
+        printf("  %s %ld", gStatusNames[Idx], status[Idx]);
+
+    printf("  sends %lu\n", attempts);
+
+    for( unsigned int Idx(0); Idx < count; Idx++ )
+    {
+        const RoboteqCom::AckTypeStats& type = stats[Idx];
+        unsigned long answered = type.accepted + type.rejected;
+
+        printf("   %-8s accepted %5lu  rejected %4lu  lost %4lu  retransmits %4lu  rtt avg us %7.1f  max us %7.1f\n",
+               type.name, type.accepted, type.rejected, type.lost, type.retransmits,
+               answered ? type.totalNs / 1e3 / answered : 0.0, type.maxNs / 1e3);
+    }
+
+    return 0;
+}
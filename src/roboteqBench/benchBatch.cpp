@@ -0,0 +1,97 @@
+#include "benchUtil.h"
+#include "roboteqCom.h"
+#include <stdio.h>
+#include <unistd.h>
+
+class CountingListener : public IEventListener<const IEventArgs>
+{
+    public:
+        CountingListener(void) : _count(0) {}
+
+        virtual void OnMsgEvent(const IEventArgs&) { ++_count; }
+
+        volatile unsigned long _count;
+};
+
+// CAN wheel fan-out issued one command at a time like most
+// IssueCommand callers do: @01..@03, channel 1 and 2
+static void RunCase(unsigned int windowUs, long ticks, unsigned int tickUs)
+{
+    PtyPair             pty;
+    FakeController      ctl(pty.Master());
+    NullLogger          log;
+    CountingListener    listener;
+    RoboteqCom          com(log, listener);
+
+    ctl.SetTelemetry(20);
+    ctl.Start();
+
+    com.Open(RoboteqCom::eCAN, pty.SlavePath());
+    com.SetBatching(windowUs);
+    com.ResetBatchStats();
+
+    unsigned long writes0   = com.Port().txWriteCount();
+    unsigned long commands0 = ctl.Commands();
+    uint64_t      wall0     = NowNs();
+    char          node[8];
+
+    for( long tick(0); tick < ticks; tick++ )
+    {
+        for( int Idx(1); Idx <= 3; Idx++ )
+        {
+            snprintf(node, sizeof(node), "@0%d!G", Idx);
+            com.IssueCommand(node, "1 1200");
+            com.IssueCommand(node, "2 -1200");
+        }
+
+        usleep(tickUs);
+    }
+
+    com.Flush();
+
+    uint64_t      wall   = NowNs() - wall0;
+    unsigned long writes = com.Port().txWriteCount() - writes0;
+    unsigned long issued = ticks * 6;
+
+    // Let controller catch up before reading its counters
+    for( int Idx(0); Idx < 100 && ctl.Commands() - commands0 < issued; Idx++ )
+        usleep(1000);
+
+    RoboteqCom::BatchStats stats;
+    com.GetBatchStats(stats);
+
+    com.Close();
+    ctl.Stop();
+
+    printf("window %5u us  commands %6lu  write() %6lu  saved %6lu  received %6lu  wall ms %7.1f\n",
+           windowUs, issued, writes, issued - writes, ctl.Commands() - commands0,
+           wall / 1e6);
+
+    if( windowUs != 0 )
+    {
+        printf("               commands per batch:");
+
+        for( int Idx(1); Idx <= ROBO_BATCH_HIST; Idx++ )
+        {
+            if( stats.sizes[Idx] )
+                printf("  %d%s x%lu", Idx, Idx == ROBO_BATCH_HIST ? "+" : "", stats.sizes[Idx]);
+        }
+
+        printf("  (avg %.1f bytes)\n", stats.batches ? (double)stats.bytes / stats.batches : 0.0);
+    }
+}
+
+int     BenchBatch(int argc, char* argv[])
+{
+    long ticks  = ArgLong(argc, argv, 1, 2000);
+    long tickUs = ArgLong(argc, argv, 2, 1000);
+
+    printf("%ld cmd_vel ticks every %ld us, 6 commands each\n", ticks, tickUs);
+
+    RunCase(0,    ticks, tickUs);
+    RunCase(50,   ticks, tickUs);
+    RunCase(200,  ticks, tickUs);
+    RunCase(2000, ticks, tickUs);
+
+    return 0;
+}
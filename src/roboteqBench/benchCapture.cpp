@@ -0,0 +1,118 @@
+#include "benchUtil.h"
+#include "serialPort.h"
+#include "serialCapture.h"
+#include "serialReplayPort.h"
+#include "serialException.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdio.h>
+
+static const char*  gTelemetry[] = { "S=1234:-1234\r", "A=125:-37\r", "V=120:245:5000\r" };
+
+struct FeedArgs
+{
+    int     fd;
+    long    frames;
+};
+
+// Telemetry in bursts of 32 frames, like # 10 with a few queries
+static void*    Feed(void* ptr)
+{
+    FeedArgs* pArgs = (FeedArgs*)ptr;
+    string    chunk;
+
+    for( long sent(0); sent < pArgs->frames; )
+    {
+        chunk.clear();
+
+        for( int Idx(0); Idx < 32 && sent < pArgs->frames; Idx++, sent++ )
+            chunk += gTelemetry[sent % 3];
+
+        if( WriteAll(pArgs->fd, chunk.c_str(), chunk.size()) == false )
+            break;
+    }
+
+    return 0L;
+}
+
+static long     Drain(const char* name, SerialPort& port, long frames)
+{
+    string      reply;
+    long        received(0);
+    uint64_t    wall0 = NowNs();
+    uint64_t    cpu0  = ThreadCpuNs();
+
+    while( received < frames && port.readFrame(reply, '\r', SerialClock::DeadlineIn(500)) > 0 )
+        ++received;
+
+    uint64_t    cpu  = ThreadCpuNs() - cpu0;
+    uint64_t    wall = NowNs() - wall0;
+
+    printf("%-12s frames %8ld  frames/s %10.0f  cpu ns/frame %7.1f\n",
+           name, received, received / (wall / 1e9), (double)cpu / received);
+
+    return received;
+}
+
+static void     RunTty(const char* name, SerialCapture* pCapture, long frames)
+{
+    PtyPair     pty;
+    NullLogger  log;
+    SerialPort  port(log);
+
+    port.connect(pty.SlavePath());
+    port.capture(pCapture);
+
+    FeedArgs    args = { pty.Master(), frames };
+    pthread_t   feeder;
+
+    if( ::pthread_create(&feeder, NULL, Feed, &args) != 0 )
+        THROW_RUNTIME_ERROR("BenchCapture - failed to start feeder");
+
+    Drain(name, port, frames);
+
+    ::pthread_join(feeder, NULL);
+    port.disconnect(false);
+}
+
+int     BenchCapture(int argc, char* argv[])
+{
+    long        frames = ArgLong(argc, argv, 1, 200000);
+    char        path[64];
+    NullLogger  log;
+
+    snprintf(path, sizeof(path), "/tmp/roboteqBench_%d.rcap", (int)getpid());
+
+    printf("%ld telemetry replies over pty, SerialPort capture off / on, then replayed\n", frames);
+
+    RunTty("no capture", 0L, frames);
+
+    {
+        SerialCapture capture;
+        struct stat   info;
+
+        capture.Open(path);
+        RunTty("capture", &capture, frames);
+        capture.Close();
+
+        ::stat(path, &info);
+        printf("%-12s records %lu  bytes %ld  errors %lu\n", "", capture.Records(), (long)info.st_size, capture.Errors());
+    }
+
+    for( int realTime(0); realTime < 2; realTime++ )
+    {
+        SerialReplayPort    replay(log);
+        SerialPort          port(log);
+
+        replay.setRealTime(realTime != 0);
+        port.transport(&replay);
+        port.connect(path);
+
+        Drain(realTime ? "replay timed" : "replay fast", port, frames);
+        port.disconnect(false);
+    }
+
+    ::unlink(path);
+
+    return 0;
+}
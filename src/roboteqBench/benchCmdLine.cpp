@@ -0,0 +1,161 @@
+#include "benchUtil.h"
+#include "roboteqCom.h"
+#include "roboteqCmdLine.h"
+#include "roboteqCmdTable.h"
+#include "roboteqCmdTemplate.h"
+#include <sstream>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Heap allocations made by this thread, counted by operator new below
+static __thread unsigned long gAllocs(0);
+
+void*   operator new(size_t size)
+{
+    ++gAllocs;
+
+    void* ptr = malloc(size ? size : 1);
+
+    if( ptr == 0L )
+        throw std::bad_alloc();
+
+    return ptr;
+}
+
+void    operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+enum eCase
+{
+    eCase_Stream,       // stringstream per cmd_vel, then command + '\r'
+    eCase_Snprintf,     // Setpoint flush before, snprintf into string
+    eCase_CmdLine,      // RoboteqCmdLine on stack
+    eCase_Typed,        // RoboteqCmd::Cmd<Go> into RoboteqCmdLine
+    eCase_Template      // Compiled once, digits patched per cmd_vel
+};
+
+// One cmd_vel worth of CAN fan-out, 3 nodes x 2 channels
+static unsigned int BuildLine(eCase which, int left, int right)
+{
+    static RoboteqCmdTemplate tmpl;
+
+    unsigned int sum(0);
+
+    if( which == eCase_Stream )
+    {
+        std::stringstream ss;
+
+        for( int node(1); node <= 3; node++ )
+        {
+            if( node != 1 )
+                ss << "_";
+
+            ss << "@0" << node << "!G 1 " << left << "_@0" << node << "!G 2 " << right;
+        }
+
+        string line = ss.str() + ROBO_TERMINATOR;
+
+        sum = line.size() + line[line.size() / 2];
+    }
+    else if( which == eCase_Snprintf )
+    {
+        string line;
+        char   cmd[32];
+
+        for( unsigned int node(1); node <= 3; node++ )
+        {
+            for( unsigned int channel(1); channel <= 2; channel++ )
+            {
+                if( line.empty() == false )
+                    line += ROBO_CMD_SEPARATOR;
+
+                snprintf(cmd, sizeof(cmd), "@%02u!G %u %d", node, channel, channel == 1 ? left : right);
+                line += cmd;
+            }
+        }
+
+        line += ROBO_TERMINATOR;
+
+        sum = line.size() + line[line.size() / 2];
+    }
+    else if( which == eCase_CmdLine )
+    {
+        RoboteqCmdLine line;
+
+        for( unsigned int node(1); node <= 3; node++ )
+            line.Command(node, "!G", 1, left).Command(node, "!G", 2, right);
+
+        line.Terminate();
+
+        sum = line.Size() + line.Data()[line.Size() / 2];
+    }
+    else if( which == eCase_Typed )
+    {
+        RoboteqCmdLine line;
+
+        for( unsigned int node(1); node <= 3; node++ )
+        {
+            RoboteqCmd::Cmd<RoboteqCmd::Go>(line, node, 1, left);
+            RoboteqCmd::Cmd<RoboteqCmd::Go>(line, node, 2, right);
+        }
+
+        line.Terminate();
+
+        sum = line.Size() + line.Data()[line.Size() / 2];
+    }
+    else
+    {
+        if( tmpl.Empty() )
+        {
+            for( unsigned int node(1); node <= 3; node++ )
+            {
+                tmpl.Add<RoboteqCmd::Go>(node, 1);
+                tmpl.Add<RoboteqCmd::Go>(node, 2);
+            }
+        }
+
+        for( unsigned int slot(0); slot < 6; slot++ )
+            tmpl.Set(slot, slot & 1 ? right : left);
+
+        sum = tmpl.Size() + tmpl.Data()[tmpl.Size() / 2];
+    }
+
+    return sum;
+}
+
+static void     RunCase(const char* name, eCase which, long count)
+{
+    unsigned long   allocs0 = gAllocs;
+    unsigned int    sum(0);
+    uint64_t        cpu0 = ThreadCpuNs();
+
+    for( long Idx(0); Idx < count; Idx++ )
+    {
+        int value = (int)(Idx % 2000) - 1000;
+
+        sum += BuildLine(which, value * 100, -value * 100);
+    }
+
+    uint64_t cpu = ThreadCpuNs() - cpu0;
+
+    printf("%-12s ns/cmd_vel %7.1f  heap allocs/cmd_vel %5.2f  (check %u)\n",
+           name, (double)cpu / count, (double)(gAllocs - allocs0) / count, sum);
+}
+
+int     BenchCmdLine(int argc, char* argv[])
+{
+    long count = ArgLong(argc, argv, 1, 1000000);
+
+    printf("%ld cmd_vel lines, 6 \"@0N!G c v\" commands joined by '_'\n", count);
+
+    RunCase("stringstream", eCase_Stream,   count);
+    RunCase("snprintf",     eCase_Snprintf, count);
+    RunCase("cmdline",      eCase_CmdLine,  count);
+    RunCase("typed",        eCase_Typed,    count);
+    RunCase("template",     eCase_Template, count);
+
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include "benchUtil.h"
+#include "roboteqEngine.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+#include <sys/resource.h>
+
+// Every reply carries its send time so listener can compute
+// feeder write -> listener dispatch latency
+class LatencyListener : public IEventListener<const IEventArgs>
+{
+    public:
+        LatencyListener(void) { _samples.reserve(1 << 20); }
+
+        virtual void OnMsgEvent(const IEventArgs& evt)
+        {
+            const char* pVal = evt.Reply().c_str() + 2;    // Skip "S="
+            uint64_t    sent = strtoull(pVal, 0L, 10);
+
+            _samples.push_back( (uint32_t)((NowNs() - sent) / 1000) );
+        }
+
+        vector<uint32_t>    _samples;   // usec
+};
+
+struct FeedArgs
+{
+    vector<int>     fds;
+    long            rateHz;
+    long            seconds;
+    volatile long   sent;
+};
+
+static void* FeedPorts(void* ptr)
+{
+    FeedArgs*   pArgs  = (FeedArgs*)ptr;
+    uint64_t    period = 1000000000ULL / pArgs->rateHz;
+    uint64_t    end    = NowNs() + pArgs->seconds * 1000000000ULL;
+    uint64_t    next   = NowNs();
+    char        frame[64];
+
+    while( NowNs() < end )
+    {
+        for( size_t Idx(0); Idx < pArgs->fds.size(); Idx++ )
+        {
+            int len = snprintf(frame, sizeof(frame), "S=%llu:0\r", (unsigned long long)NowNs());
+
+            if( WriteAll(pArgs->fds[Idx], frame, len) )
+                pArgs->sent = pArgs->sent + 1;
+        }
+
+        next += period;
+
+        uint64_t now = NowNs();
+
+        if( next > now )
+            usleep((next - now) / 1000);
+    }
+
+    return 0L;
+}
+
+static void RunScale(long ports, long rateHz, long seconds)
+{
+    NullLogger              log;
+    RoboteqEngine           engine(log);
+    LatencyListener         listener;
+    vector<PtyPair*>        ptys;
+    vector<SerialPort*>     serials;
+    FeedArgs                args;
+
+    for( long Idx(0); Idx < ports; Idx++ )
+    {
+        PtyPair*    pPty  = new PtyPair;
+        SerialPort* pPort = new SerialPort(log);
+
+        pPort->canonical(SerialPort::eCanonical_Disable);
+        pPort->baud(115200);
+        pPort->connect(pPty->SlavePath());
+
+        engine.Add(*pPort, listener);
+
+        ptys.push_back(pPty);
+        serials.push_back(pPort);
+        args.fds.push_back(pPty->Master());
+    }
+
+    args.rateHz  = rateHz;
+    args.seconds = seconds;
+    args.sent    = 0;
+
+    pthread_t feeder;
+
+    uint64_t cpu0  = ThreadCpuNs();
+    uint64_t wall0 = NowNs();
+
+    if( ::pthread_create(&feeder, NULL, FeedPorts, &args) != 0 )
+        THROW_RUNTIME_ERROR("BenchEngine - failed to start feeder");
+
+    // Engine runs on this thread so its CPU time is ours
+    uint64_t drainEnd = wall0 + (seconds + 2) * 1000000000ULL;
+
+    while( NowNs() < drainEnd )
+    {
+        engine.Poll(10);
+
+        if( NowNs() > wall0 + seconds * 1000000000ULL && listener._samples.size() >= (size_t)args.sent )
+            break;
+    }
+
+    uint64_t cpu  = ThreadCpuNs() - cpu0;
+    uint64_t wall = NowNs() - wall0;
+
+    ::pthread_join(feeder, NULL);
+
+    vector<uint32_t>& lat = listener._samples;
+
+    std::sort(lat.begin(), lat.end());
+
+    size_t   count = lat.size();
+    uint32_t p50   = count ? lat[count / 2]        : 0;
+    uint32_t p99   = count ? lat[(count * 99) / 100] : 0;
+    uint32_t pMax  = count ? lat[count - 1]        : 0;
+
+    printf("ports %5ld  replies %8zu/%-8ld  engine cpu %5.1f%%  cpu ns/reply %7.0f  latency us p50 %6u p99 %6u max %7u\n",
+           ports, count, (long)args.sent, 100.0 * cpu / wall,
+           count ? (double)cpu / count : 0.0, p50, p99, pMax);
+
+    for( size_t Idx(0); Idx < serials.size(); Idx++ )
+    {
+        engine.Remove(*serials[Idx]);
+        serials[Idx]->disconnect(false);
+        delete serials[Idx];
+        delete ptys[Idx];
+    }
+}
+
+int     BenchEngine(int argc, char* argv[])
+{
+    long rateHz  = ArgLong(argc, argv, 1, 50);
+    long seconds = ArgLong(argc, argv, 2, 2);
+    long maxPort = ArgLong(argc, argv, 3, 1000);
+
+    // Each port costs pty master + slave fd
+    rlimit lim;
+
+    if( ::getrlimit(RLIMIT_NOFILE, &lim) == 0 )
+    {
+        lim.rlim_cur = lim.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &lim);
+    }
+
+    printf("One engine thread, %ld Hz telemetry per port for %ld s\n", rateHz, seconds);
+
+    for( long ports(1); ports <= maxPort; ports *= 10 )
+        RunScale(ports, rateHz, seconds);
+
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include "benchUtil.h"
+#include "roboteqCom.h"
+#include <pthread.h>
+#include <stdio.h>
+
+class NullListener : public IEventListener<const IEventArgs>
+{
+    public:
+        virtual void OnMsgEvent(const IEventArgs&) {}
+};
+
+// Same value spread as real latencies, 1 us .. ~1 s
+static inline uint64_t NextValue(uint64_t& seed)
+{
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+
+    return ((seed >> 33) & 0xFFFFF) << ((seed >> 60) & 0x0F);
+}
+
+struct Recorder
+{
+    RoboteqHistogram*   pHist;
+    long                count;
+    uint64_t            seed;
+};
+
+static void* RecordFn(void* ptr)
+{
+    Recorder& rec = *(Recorder*)ptr;
+
+    for( long Idx(0); Idx < rec.count; Idx++ )
+        rec.pHist->Record(NextValue(rec.seed));
+
+    return 0L;
+}
+
+static void RecordCost(long count, int threads)
+{
+    RoboteqHistogram    hist;
+    Recorder            recs[8];
+    pthread_t           ids[8];
+
+    uint64_t start = NowNs();
+
+    for( int Idx(0); Idx < threads; Idx++ )
+    {
+        recs[Idx].pHist = &hist;
+        recs[Idx].count = count;
+        recs[Idx].seed  = Idx + 1;
+
+        pthread_create(&ids[Idx], 0L, RecordFn, &recs[Idx]);
+    }
+
+    for( int Idx(0); Idx < threads; Idx++ )
+        pthread_join(ids[Idx], 0L);
+
+    uint64_t elapsed = NowNs() - start;
+
+    // Baseline, value generation alone
+    uint64_t          seed(1);
+    volatile uint64_t sink(0);
+    uint64_t base = NowNs();
+
+    for( long Idx(0); Idx < count; Idx++ )
+        sink += NextValue(seed);
+
+    base = NowNs() - base;
+
+    RoboteqHistogram::Snapshot snap;
+    hist.GetSnapshot(snap);
+
+    printf("record %d thread(s)  %6.1f ns/record (%.1f ns value gen)  count %llu\n",
+           threads, (double)elapsed / (count * threads), (double)base / count,
+           (unsigned long long)snap.total);
+}
+
+static void Print(const char* name, const RoboteqHistogram::Snapshot& snap)
+{
+    printf("%-10s n %6llu  mean %8.1f  p50 %8.1f  p90 %8.1f  p99 %8.1f  p99.9 %8.1f  max %8.1f us\n",
+           name, (unsigned long long)snap.total, snap.Mean() / 1e3,
+           snap.Percentile(50) / 1e3, snap.Percentile(90) / 1e3,
+           snap.Percentile(99) / 1e3, snap.Percentile(99.9) / 1e3, snap.max / 1e3);
+}
+
+// Queries and tracked commands while controller streams telemetry
+static void LiveRun(long rounds, unsigned int telemetryMs)
+{
+    PtyPair         pty;
+    FakeController  ctl(pty.Master());
+    NullLogger      log;
+    NullListener    listener;
+    RoboteqCom      com(log, listener);
+    RoboteqQuery    query;
+    RoboteqAck      ack;
+
+    ctl.Start();
+    com.Open(RoboteqCom::eSerial, pty.SlavePath());
+    com.SetAckTracking(true);
+    ctl.SetTelemetry(telemetryMs);
+    ctl.SetReplyLatency(200);
+
+    for( int Idx(0); Idx < RoboteqCom::eLatency_Count; Idx++ )
+        com.ResetLatency((RoboteqCom::eLatency)Idx);
+
+    for( long Idx(0); Idx < rounds; Idx++ )
+    {
+        com.Query(query, "?A 1");
+        query.Wait();
+
+        com.IssueTracked(ack, "!G", "1 100");
+        ack.Wait();
+    }
+
+    RoboteqHistogram::Snapshot snap;
+
+    com.GetLatency(RoboteqCom::eLatency_Query, snap);
+    Print("query", snap);
+    com.GetLatency(RoboteqCom::eLatency_Ack, snap);
+    Print("ack", snap);
+    com.GetLatency(RoboteqCom::eLatency_Telemetry, snap);
+    Print("telemetry", snap);
+
+    com.Close();
+    ctl.Stop();
+}
+
+int     BenchHist(int argc, char* argv[])
+{
+    long count       = ArgLong(argc, argv, 1, 10000000);
+    long rounds      = ArgLong(argc, argv, 2, 500);
+    long telemetryMs = ArgLong(argc, argv, 3, 10);
+
+    RecordCost(count, 1);
+    RecordCost(count / 4, 4);
+
+    printf("%ld query + tracked command rounds, telemetry every %ld ms\n", rounds, telemetryMs);
+    LiveRun(rounds, telemetryMs);
+
+    return 0;
+}
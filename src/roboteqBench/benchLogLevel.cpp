@@ -0,0 +1,103 @@
+#include "benchUtil.h"
+#include "roboteqCom.h"
+#include "serialAsyncLogger.h"
+#include "serialException.h"
+#include <sstream>
+#include <unistd.h>
+#include <stdio.h>
+
+void    CmdVelStripped(RoboteqCom& com, SerialLogger& log, int leftCmd, int rightCmd);
+
+class NullListener : public IEventListener<const IEventArgs>
+{
+    public:
+        virtual void OnMsgEvent(const IEventArgs&) {}
+};
+
+enum eCase
+{
+    eCase_Always,       // Trace formatted and logged on every cmd_vel
+    eCase_DebugOff,     // SERIAL_LOG_DEBUG, level info
+    eCase_DebugOn,      // SERIAL_LOG_DEBUG, level debug
+    eCase_Stripped      // SERIAL_LOG_STRIP_DEBUG build
+};
+
+// RosRoboteqDrv::CmdVelCallback body, CAN fan-out to 3 nodes
+static void     CmdVel(eCase which, RoboteqCom& com, SerialLogger& log, int leftCmd, int rightCmd)
+{
+    if( which == eCase_Stripped )
+    {
+        CmdVelStripped(com, log, leftCmd, rightCmd);
+        return;
+    }
+
+    for( unsigned int node(1); node <= 3; node++ )
+    {
+        com.SetMotorSetpoint(node, 1, leftCmd, false);
+        com.SetMotorSetpoint(node, 2, rightCmd, node == 3);
+    }
+
+    if( which == eCase_Always )
+    {
+        ostringstream msg; msg << "Wheels= " << leftCmd << " : " << rightCmd;
+        log.LogLine(msg.str());
+    }
+    else
+        SERIAL_LOG_DEBUG(log, "Wheels= " << leftCmd << " : " << rightCmd);
+}
+
+static void     RunCase(const char* name, eCase which, const char* path, long count)
+{
+    PtyPair             pty;
+    FakeController      ctl(pty.Master());
+    SerialAsyncLogger   log;
+    NullListener        listener;
+    RoboteqCom          com(log, listener);
+
+    if( log.Open(path) == false )
+        THROW_RUNTIME_ERROR("BenchLogLevel - can not open " << path);
+
+    ctl.Start();
+    com.Open(RoboteqCom::eCAN, pty.SlavePath());
+
+    log.SetLevel(which == eCase_DebugOn ? SerialLogger::eLevel_Debug : SerialLogger::eLevel_Info);
+
+    unsigned long lines0 = log.Lines();
+    uint64_t      cpu0   = ThreadCpuNs();
+
+    for( long Idx(0); Idx < count; Idx++ )
+    {
+        int value = (int)(Idx % 2000) - 1000;
+
+        CmdVel(which, com, log, value * 100, -value * 100);
+    }
+
+    uint64_t      cpu   = ThreadCpuNs() - cpu0;
+    unsigned long lines = log.Lines() - lines0;
+
+    log.SetLevel(SerialLogger::eLevel_Info);
+    com.Close();
+    ctl.Stop();
+    log.Close();
+
+    printf("%-10s cpu ns/cmd_vel %7.1f  log lines/cmd_vel %5.2f\n", name, (double)cpu / count, (double)lines / count);
+}
+
+int     BenchLogLevel(int argc, char* argv[])
+{
+    long    count = ArgLong(argc, argv, 1, 200000);
+    char    path[64];
+
+    snprintf(path, sizeof(path), "/tmp/roboteqBench_%d.log", (int)getpid());
+
+    printf("%ld cmd_vel callbacks, CAN fan-out to 3 nodes, latest wins setpoints, async logger\n", count);
+
+    RunCase("always",   eCase_Always,   path, count);
+    RunCase("debug off", eCase_DebugOff, path, count);
+    RunCase("debug on", eCase_DebugOn,  path, count);
+    RunCase("stripped", eCase_Stripped, path, count);
+
+    ::unlink(path);
+
+    return 0;
+}
@@ -0,0 +1,16 @@
+// Built with debug tracing compiled out, see BenchLogLevel
+#define SERIAL_LOG_STRIP_DEBUG
+
+#include "benchUtil.h"
+#include "roboteqCom.h"
+
+void    CmdVelStripped(RoboteqCom& com, SerialLogger& log, int leftCmd, int rightCmd)
+{
+    for( unsigned int node(1); node <= 3; node++ )
+    {
+        com.SetMotorSetpoint(node, 1, leftCmd, false);
+        com.SetMotorSetpoint(node, 2, rightCmd, node == 3);
+    }
+
+    SERIAL_LOG_DEBUG(log, "Wheels= " << leftCmd << " : " << rightCmd);
+}
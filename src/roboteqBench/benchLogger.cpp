@@ -0,0 +1,159 @@
+#include "benchUtil.h"
+#include "serialAsyncLogger.h"
+#include "serialException.h"
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+#include <stdio.h>
+
+// What roboteqCom / roboteqDbg used to do: mutex, ofstream, flush per line
+class LegacyLogger : public SerialLogger
+{
+    public:
+        LegacyLogger(const string& path)
+        {
+            ::pthread_mutex_init(&_mx, NULL);
+            _file.open(path.c_str(), ios_base::out | ios_base::app);
+        }
+
+        ~LegacyLogger(void)
+        {
+            _file.close();
+            ::pthread_mutex_destroy(&_mx);
+        }
+
+        virtual bool    IsLogOpen(void) const { return _file.is_open(); }
+
+        virtual void    LogLine(const char* pBuffer, unsigned int len)
+        {
+            ::pthread_mutex_lock(&_mx);
+            _file.write(pBuffer, len) << std::endl;
+            _file.flush();
+            ::pthread_mutex_unlock(&_mx);
+        }
+
+        virtual void    LogLine(const std::string& message) { LogLine(message.data(), message.size()); }
+        virtual void    Log(const char* pBuffer, unsigned int len) { LogLine(pBuffer, len); }
+        virtual void    Log(const std::string& message) { LogLine(message.data(), message.size()); }
+
+    private:
+        ofstream        _file;
+        pthread_mutex_t _mx;
+};
+
+struct LogArgs
+{
+    SerialLogger*       pLogger;
+    long                lines;
+    vector<uint32_t>    ns;         // Per LogLine call
+};
+
+// Reader thread logging every reply it gets, "> : S=..." like roboteqCom
+static void*    LogLines(void* ptr)
+{
+    LogArgs*    pArgs = (LogArgs*)ptr;
+    char        line[64];
+
+    pArgs->ns.resize(pArgs->lines);
+
+    for( long Idx(0); Idx < pArgs->lines; Idx++ )
+    {
+        int      len = snprintf(line, sizeof(line), "> : S=%ld:%ld", Idx % 3000, -(Idx % 3000));
+        uint64_t t0  = NowNs();
+
+        pArgs->pLogger->LogLine(line, len);
+
+        pArgs->ns[Idx] = (uint32_t)std::min<uint64_t>(NowNs() - t0, 0xFFFFFFFF);
+    }
+
+    return 0L;
+}
+
+static void     Run(const char* name, SerialLogger& logger, int threads, long lines)
+{
+    vector<LogArgs>     args(threads);
+    vector<pthread_t>   ids(threads);
+    uint64_t            wall0 = NowNs();
+
+    for( int Idx(0); Idx < threads; Idx++ )
+    {
+        args[Idx].pLogger = &logger;
+        args[Idx].lines   = lines;
+
+        if( ::pthread_create(&ids[Idx], NULL, LogLines, &args[Idx]) != 0 )
+            THROW_RUNTIME_ERROR("BenchLogger - failed to start producer");
+    }
+
+    vector<uint32_t>    all;
+
+    for( int Idx(0); Idx < threads; Idx++ )
+    {
+        ::pthread_join(ids[Idx], NULL);
+        all.insert(all.end(), args[Idx].ns.begin(), args[Idx].ns.end());
+    }
+
+    uint64_t    wall = NowNs() - wall0;
+    uint64_t    sum(0);
+
+    for( size_t Idx(0); Idx < all.size(); Idx++ )
+        sum += all[Idx];
+
+    std::sort(all.begin(), all.end());
+
+    printf("%-16s thr %d  ns/line mean %7.1f  p50 %6u  p99 %7u  max %9u  lines/s %10.0f\n",
+           name, threads, (double)sum / all.size(), all[all.size() / 2],
+           all[all.size() * 99 / 100], all.back(), all.size() / (wall / 1e9));
+}
+
+static void     RunAsync(const char* name, const char* path, SerialAsyncLogger::eDrop policy,
+                         unsigned int slots, int threads, long lines)
+{
+    SerialAsyncLogger logger(slots);
+
+    logger.SetDropPolicy(policy);
+
+    if( logger.Open(path) == false )
+        THROW_RUNTIME_ERROR("BenchLogger - can not open " << path);
+
+    Run(name, logger, threads, lines);
+
+    uint64_t t0 = NowNs();
+    logger.Close();
+
+    printf("%-16s lines %lu  dropped %lu  write() %lu  close %.1f ms\n",
+           "", logger.Lines(), logger.Dropped(), logger.Writes(), (NowNs() - t0) / 1e6);
+}
+
+int     BenchLogger(int argc, char* argv[])
+{
+    long    lines   = ArgLong(argc, argv, 1, 200000);
+    int     threads = ArgLong(argc, argv, 2, 4);
+    char    path[64];
+
+    snprintf(path, sizeof(path), "/tmp/roboteqBench_%d.log", (int)getpid());
+
+    printf("%ld LogLine calls per thread, legacy mutex + flush vs async ring\n", lines);
+
+    for( int thr(1); thr <= threads; thr += threads - 1 )
+    {
+        {
+            LegacyLogger legacy(path);
+
+            if( legacy.IsLogOpen() == false )
+                THROW_RUNTIME_ERROR("BenchLogger - can not open " << path);
+
+            Run("legacy", legacy, thr, lines);
+        }
+
+        RunAsync("async newest", path, SerialAsyncLogger::eDrop_Newest, 4096, thr, lines);
+        RunAsync("async block", path, SerialAsyncLogger::eDrop_Block, 4096, thr, lines);
+
+        if( threads == 1 )
+            break;
+    }
+
+    ::unlink(path);
+
+    return 0;
+}
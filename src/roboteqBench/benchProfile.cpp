@@ -0,0 +1,92 @@
+#include "benchUtil.h"
+#include "serialPort.h"
+#include "roboteqHistogram.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Paced telemetry, each frame carries its send time "T=<ns>\r"
+struct PacedArgs
+{
+    int     fd;
+    long    frames;
+    long    periodUs;
+};
+
+static void* FeedPaced(void* ptr)
+{
+    PacedArgs* pArgs = (PacedArgs*)ptr;
+    char       frame[32];
+
+    for( long Idx(0); Idx < pArgs->frames; Idx++ )
+    {
+        int len = snprintf(frame, sizeof(frame), "T=%llu\r", (unsigned long long)NowNs());
+
+        if( WriteAll(pArgs->fd, frame, len) == false )
+            break;
+
+        ::usleep(pArgs->periodUs);
+    }
+
+    return 0L;
+}
+
+static void RunCase(const char* name, SerialPort::eProfile profile, long frames, long periodUs)
+{
+    PtyPair             pty;
+    NullLogger          log;
+    SerialPort          port(log);
+    RoboteqHistogram    hist;
+
+    port.canonical(SerialPort::eCanonical_Disable);
+    port.profile(profile);
+    port.connect(pty.SlavePath());
+
+    PacedArgs   args = { pty.Master(), frames, periodUs };
+    pthread_t   feeder;
+
+    if( ::pthread_create(&feeder, NULL, FeedPaced, &args) != 0 )
+        THROW_RUNTIME_ERROR("BenchProfile - failed to start feeder");
+
+    string      reply;
+    long        received(0);
+
+    while( received < frames )
+    {
+        if( port.readFrame(reply, '\r', SerialClock::DeadlineIn(1000)) <= 0 )
+            break;
+
+        hist.Record(NowNs() - strtoull(reply.c_str() + 2, 0L, 10));
+        ++received;
+    }
+
+    ::pthread_join(feeder, NULL);
+
+    const SerialPort::ProfileReport& report = port.profileReport();
+    RoboteqHistogram::Snapshot      snap;
+
+    hist.GetSnapshot(snap);
+
+    printf("%-11s gather %2u B / %4u us  low latency %-3s  read()/frame %5.2f  latency p50 %8.1f  p99 %8.1f  max %8.1f us\n",
+           name, report.gatherBytes, report.gatherGapUs,
+           report.serialInfo ? (report.lowLatency ? "on" : "off") : "n/a",
+           received ? (double)port.rxReadCount() / received : 0.0,
+           snap.Percentile(50) / 1e3, snap.Percentile(99) / 1e3, snap.max / 1e3);
+
+    port.disconnect(false);
+}
+
+int     BenchProfile(int argc, char* argv[])
+{
+    long frames   = ArgLong(argc, argv, 1, 2000);
+    long periodUs = ArgLong(argc, argv, 2, 1000);
+
+    printf("%ld paced frames every %ld us, send to framed latency per receive profile\n", frames, periodUs);
+
+    RunCase("default",     SerialPort::eProfile_Default,     frames, periodUs);
+    RunCase("low latency", SerialPort::eProfile_LowLatency,  frames, periodUs);
+    RunCase("throughput",  SerialPort::eProfile_Throughput,  frames, periodUs);
+
+    return 0;
+}
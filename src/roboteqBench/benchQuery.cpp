@@ -0,0 +1,81 @@
+#include "benchUtil.h"
+#include "roboteqCom.h"
+#include <stdio.h>
+
+class NullListener : public IEventListener<const IEventArgs>
+{
+    public:
+        virtual void OnMsgEvent(const IEventArgs&) {}
+};
+
+// Typical config / diagnostics read out
+static const char* gQueries[] =
+{
+    "?V", "?A 1", "?A 2", "?T 1", "?T 2", "?FF", "?BA 1", "?BA 2",
+    "?C 1", "?C 2", "?S 1", "?S 2", "?P 1", "?P 2", "?CR 1", "?CR 2"
+};
+
+static const int gQueryCount = sizeof(gQueries) / sizeof(gQueries[0]);
+
+static void RunCase(bool pipelined, long rounds, unsigned int latencyUs)
+{
+    PtyPair         pty;
+    FakeController  ctl(pty.Master());
+    NullLogger      log;
+    NullListener    listener;
+    RoboteqCom      com(log, listener);
+    RoboteqQuery    queries[gQueryCount];
+
+    ctl.Start();
+    com.Open(RoboteqCom::eSerial, pty.SlavePath());
+    ctl.SetReplyLatency(latencyUs);
+
+    long     done(0);
+    long     failed(0);
+    uint64_t latencySum(0);
+    uint64_t start = NowNs();
+
+    for( long round(0); round < rounds; round++ )
+    {
+        for( int Idx(0); Idx < gQueryCount; Idx++ )
+        {
+            com.Query(queries[Idx], gQueries[Idx]);
+
+            if( pipelined == false )
+                queries[Idx].Wait();
+        }
+
+        for( int Idx(0); Idx < gQueryCount; Idx++ )
+        {
+            if( queries[Idx].Wait() )
+            {
+                ++done;
+                latencySum += queries[Idx].LatencyNs();
+            }
+            else
+                ++failed;
+        }
+    }
+
+    uint64_t elapsed = NowNs() - start;
+
+    com.Close();
+    ctl.Stop();
+
+    printf("%-10s  %ld queries  %8.1f ms total  %7.1f us/query  avg latency %7.1f us  failed %ld\n",
+           pipelined ? "pipelined" : "serial", done + failed, elapsed / 1e6,
+           elapsed / 1e3 / (done + failed), done ? latencySum / 1e3 / done : 0.0, failed);
+}
+
+int     BenchQuery(int argc, char* argv[])
+{
+    long rounds    = ArgLong(argc, argv, 1, 20);
+    long latencyUs = ArgLong(argc, argv, 2, 1000);
+
+    printf("%ld rounds of %d config queries, %ld us controller turnaround\n", rounds, gQueryCount, latencyUs);
+
+    RunCase(false, rounds, latencyUs);
+    RunCase(true,  rounds, latencyUs);
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include "benchUtil.h"
+#include "serialPort.h"
+#include "roboteqCom.h"
+#include <stdio.h>
+
+class NullListener : public IEventListener<const IEventArgs>
+{
+    public:
+        virtual void OnMsgEvent(const IEventArgs&) {}
+};
+
+enum eCase
+{
+    eCase_Setters,      // Each setter on open port, tcsetattr per call
+    eCase_Config,       // One Config, always written
+    eCase_Skip          // One Config, skipped when tty matches
+};
+
+static void RunCase(const char* name, eCase which, long rounds)
+{
+    PtyPair             pty;
+    NullLogger          log;
+    SerialPort          port(log);
+    SerialPort::Config  config;
+    unsigned long       writes(0);
+
+    config.baud           = 115200;
+    config.profile        = SerialPort::eProfile_LowLatency;
+    config.skipIfMatching = which == eCase_Skip;
+
+    uint64_t start = NowNs();
+
+    for( long Idx(0); Idx < rounds; Idx++ )
+    {
+        if( which == eCase_Setters )
+        {
+            port.connect(pty.SlavePath());
+            port.canonical(SerialPort::eCanonical_Disable);
+            port.baud(115200);
+            port.dateSize(SerialPort::eDataSize_8Bit);
+            port.stopBit(SerialPort::eStopBit_1);
+            port.parity(SerialPort::eParity_None);
+            port.flowControl(SerialPort::eFlow_None);
+            port.profile(SerialPort::eProfile_LowLatency);
+        }
+        else
+            port.connect(pty.SlavePath(), config);
+
+        writes += port.configWriteCount();
+        port.disconnect(false);
+    }
+
+    uint64_t elapsed = NowNs() - start;
+
+    printf("%-12s %6.1f us/reconnect  tcsetattr/reconnect %5.2f\n",
+           name, elapsed / 1e3 / rounds, (double)writes / rounds);
+}
+
+// Whole RoboteqCom Open / Close against pty controller
+static void RunOpen(long rounds)
+{
+    PtyPair         pty;
+    FakeController  ctl(pty.Master());
+    NullLogger      log;
+    NullListener    listener;
+    RoboteqCom      com(log, listener);
+
+    ctl.Start();
+
+    uint64_t start = NowNs();
+
+    for( long Idx(0); Idx < rounds; Idx++ )
+    {
+        com.Open(RoboteqCom::eSerial, pty.SlavePath());
+        com.Close();
+    }
+
+    uint64_t elapsed = NowNs() - start;
+
+    ctl.Stop();
+
+    printf("%-12s %6.1f us/reconnect  tcsetattr on last %lu\n",
+           "RoboteqCom", elapsed / 1e3 / rounds, com.Port().configWriteCount());
+}
+
+int     BenchReconnect(int argc, char* argv[])
+{
+    long rounds = ArgLong(argc, argv, 1, 2000);
+
+    printf("%ld reconnects of a pty, 115200 8N1 raw low latency\n", rounds);
+
+    RunCase("setters",     eCase_Setters, rounds);
+    RunCase("config",      eCase_Config,  rounds);
+    RunCase("config+skip", eCase_Skip,    rounds);
+    RunOpen(rounds / 20);
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include "benchUtil.h"
+#include "roboteqCom.h"
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+// Consumer that spends workUs on every reply, like ROS publish + log
+class SlowListener : public IEventListener<const IEventArgs>
+{
+    public:
+        SlowListener(long workUs) : _workUs(workUs), _count(0) {}
+
+        virtual void OnMsgEvent(const IEventArgs&)
+        {
+            usleep(_workUs);
+            ++_count;
+        }
+
+        long            _workUs;
+        volatile long   _count;
+};
+
+// Bytes sitting in kernel receive queue not yet read by reader thread
+static int  KernelBacklog(const RoboteqCom& com)
+{
+    int pending(0);
+
+    if( ::ioctl(com.Port().fd(), FIONREAD, &pending) != 0 )
+        return 0;
+
+    return pending;
+}
+
+static void RunCase(bool ring, long telemetryMs, long workUs, long seconds)
+{
+    PtyPair         pty;
+    FakeController  ctl(pty.Master());
+    NullLogger      log;
+    SlowListener    listener(workUs);
+    RoboteqCom      com(log, listener);
+
+    if( ring )
+        com.SetReplyQueue();
+
+    ctl.Start();
+    com.Open(RoboteqCom::eSerial, pty.SlavePath());
+    ctl.SetTelemetry(telemetryMs);
+
+    uint64_t    end = NowNs() + seconds * 1000000000ULL;
+    int         maxBacklog(0);
+
+    while( NowNs() < end )
+    {
+        if( ring == false || com.DrainReplies(1) == 0 )
+            usleep(1000);
+
+        int backlog = KernelBacklog(com);
+
+        if( backlog > maxBacklog )
+            maxBacklog = backlog;
+    }
+
+    RoboteqReplyRing::Stats stats;
+
+    bool hasStats = com.GetReplyQueueStats(stats);
+
+    com.Close();
+    ctl.Stop();
+
+    printf("%-6s  consumed %5ld  max kernel backlog %6d B", ring ? "ring" : "direct", listener._count, maxBacklog);
+
+    if( hasStats )
+        printf("  pushed %5lu  dropped %5lu  high water %3u/%u", stats.pushed, stats.dropped, stats.highWater, stats.capacity);
+
+    printf("\n");
+}
+
+int     BenchRing(int argc, char* argv[])
+{
+    long telemetryMs = ArgLong(argc, argv, 1, 1);
+    long workUs      = ArgLong(argc, argv, 2, 3000);
+    long seconds     = ArgLong(argc, argv, 3, 3);
+
+    printf("telemetry every %ld ms, consumer work %ld us per reply, %ld s\n", telemetryMs, workUs, seconds);
+
+    RunCase(false, telemetryMs, workUs, seconds);
+    RunCase(true,  telemetryMs, workUs, seconds);
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include "benchUtil.h"
+#include "serialPort.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+// Telemetry mix as produced by "?S", "?A", "?V" with "# 10"
+static const char* gTelemetry[] =
+{
+    "S=1234:-1234\r",
+    "A=125:-37\r",
+    "V=120:245:5000\r",
+};
+
+struct FeedArgs
+{
+    int     fd;
+    long    frames;
+};
+
+static void* FeedTelemetry(void* ptr)
+{
+    FeedArgs* pArgs = (FeedArgs*)ptr;
+    string    chunk;
+    long      sent(0);
+
+    while( sent < pArgs->frames )
+    {
+        chunk.clear();
+
+        for( int Idx(0); Idx < 32 && sent < pArgs->frames; Idx++, sent++ )
+            chunk += gTelemetry[sent % 3];
+
+        if( WriteAll(pArgs->fd, chunk.c_str(), chunk.size()) == false )
+            break;
+    }
+
+    return 0L;
+}
+
+// The way RoboteqCom::ReadReply used to do it. One read() per byte
+static int  LegacyReadReply(SerialPort& port, string& reply)
+{
+    char byte;
+
+    reply.clear();
+
+    while(true)
+    {
+        if( port.read(&byte, 1) <= 0 )
+            break;
+
+        if( byte == '\r' )
+        {
+            if( reply.size() == 0 )
+                continue;
+
+            return reply.length();
+        }
+
+        reply.append(&byte, 1);
+    }
+
+    return 0;
+}
+
+static void RunCase(const char* name, bool buffered, long frames)
+{
+    PtyPair     pty;
+    NullLogger  log;
+    SerialPort  port(log);
+
+    port.canonical(SerialPort::eCanonical_Disable);
+    port.baud(115200);
+    port.connect(pty.SlavePath());
+
+    FeedArgs    args = { pty.Master(), frames };
+    pthread_t   feeder;
+
+    uint64_t    wall0 = NowNs();
+    uint64_t    cpu0  = ThreadCpuNs();
+
+    if( ::pthread_create(&feeder, NULL, FeedTelemetry, &args) != 0 )
+        THROW_RUNTIME_ERROR("BenchRx - failed to start feeder");
+
+    string      reply;
+    long        received(0);
+
+    while( received < frames )
+    {
+        int len = buffered ? port.readFrame(reply, '\r') : LegacyReadReply(port, reply);
+
+        if( len <= 0 )
+            break;
+
+        ++received;
+    }
+
+    uint64_t    cpu  = ThreadCpuNs() - cpu0;
+    uint64_t    wall = NowNs() - wall0;
+
+    ::pthread_join(feeder, NULL);
+
+    unsigned long reads = port.rxReadCount();
+
+    port.disconnect(false);
+
+    printf("%-10s frames %8ld  read() %9lu  read()/frame %7.3f  cpu ns/frame %8.1f  wall ms %8.1f\n",
+           name, received, reads, (double)reads / received,
+           (double)cpu / received, wall / 1e6);
+}
+
+int     BenchRx(int argc, char* argv[])
+{
+    long frames = ArgLong(argc, argv, 1, 200000);
+
+    printf("Reader thread cost of framing %ld telemetry replies from a pty\n", frames);
+
+    RunCase("per-byte", false, frames);
+    RunCase("buffered", true,  frames);
+
+    return 0;
+}
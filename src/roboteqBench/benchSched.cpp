@@ -0,0 +1,107 @@
+#include "benchUtil.h"
+#include "roboteqCom.h"
+#include <stdio.h>
+#include <unistd.h>
+
+class NullListener : public IEventListener<const IEventArgs>
+{
+    public:
+        virtual void OnMsgEvent(const IEventArgs&) {}
+};
+
+static const char* gClassNames[RoboteqCom::ePriority_Count] = { "safety", "motion", "query", "config" };
+
+// Config dump of "lines" commands is queued in one go, motion runs at
+// 100 Hz and "!EX" is issued half way through the dump. Reports how long
+// the emergency stop waits before it can reach the wire
+static void RunCase(bool scheduler, long lines)
+{
+    PtyPair         pty;
+    FakeController  ctl(pty.Master());
+    NullLogger      log;
+    NullListener    listener;
+    RoboteqCom      com(log, listener);
+    char            args[32];
+
+    ctl.SetTelemetry(20);
+    ctl.Start();
+
+    com.Open(RoboteqCom::eSerial, pty.SlavePath());
+    com.SetScheduler(scheduler);
+
+    uint64_t    period = 10000000ULL;
+    uint64_t    next   = NowNs();
+    uint64_t    stopLatency(0);
+    long        Idx(0);
+
+    for( ; Idx < lines; Idx++ )
+    {
+        snprintf(args, sizeof(args), "%ld %ld", Idx % 2 + 1, Idx);
+        com.IssueCommand("^MXRPM", args);
+    }
+
+    for( long tick(0); tick < 50; tick++ )
+    {
+        snprintf(args, sizeof(args), "1 %ld", tick * 10);
+        com.IssueCommand("!G", args);
+
+        if( tick == 5 )
+        {
+            uint64_t start = NowNs();
+
+            com.IssueCommand("!EX");
+
+            // Legacy FIFO: stop sits behind whole backlog. Scheduler:
+            // wait until safety class leaves queue, then add what is ahead
+            RoboteqCom::SchedulerStats stats;
+
+            do
+            {
+                com.GetSchedulerStats(stats);
+            }
+            while( scheduler && stats.classes[RoboteqCom::ePriority_Safety].sent == 0 );
+
+            stopLatency = NowNs() - start + com.TxBacklogNs();
+        }
+
+        next += period;
+
+        uint64_t now = NowNs();
+
+        if( next > now )
+            usleep((next - now) / 1000);
+    }
+
+    RoboteqCom::SchedulerStats stats;
+    com.GetSchedulerStats(stats);
+
+    com.Close();
+    ctl.Stop();
+
+    printf("%-9s  !EX to wire ms %8.2f  link %u B/s\n", scheduler ? "scheduler" : "fifo",
+           stopLatency / 1e6, stats.bytesPerSec);
+
+    if( scheduler == false )
+        return;
+
+    for( int cls(0); cls < RoboteqCom::ePriority_Count; cls++ )
+    {
+        const RoboteqCom::ClassStats& cs = stats.classes[cls];
+
+        printf("   %-7s sent %5lu  dropped %4lu  max depth %5lu  avg delay ms %8.2f  max delay ms %8.2f\n",
+               gClassNames[cls], cs.sent, cs.dropped, cs.maxDepth,
+               cs.sent ? cs.totalDelayNs / 1e6 / cs.sent : 0.0, cs.maxDelayNs / 1e6);
+    }
+}
+
+int     BenchSched(int argc, char* argv[])
+{
+    long lines = ArgLong(argc, argv, 1, 200);
+
+    printf("config dump of %ld lines, motion at 100 Hz, !EX mid dump, 115200 baud link model\n", lines);
+
+    RunCase(false, lines);
+    RunCase(true,  lines);
+
+    return 0;
+}
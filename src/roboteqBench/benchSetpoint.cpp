@@ -0,0 +1,93 @@
+#include "benchUtil.h"
+#include "roboteqCom.h"
+#include <stdio.h>
+#include <unistd.h>
+
+class NullListener : public IEventListener<const IEventArgs>
+{
+    public:
+        virtual void OnMsgEvent(const IEventArgs&) {}
+};
+
+// cmd_vel flood against the 115200 baud link model. Legacy path writes
+// every six command line. Setpoint path keeps only newest value per slot
+static void RunCase(bool coalesce, long rateHz, long seconds)
+{
+    PtyPair         pty;
+    FakeController  ctl(pty.Master());
+    NullLogger      log;
+    NullListener    listener;
+    RoboteqCom      com(log, listener);
+
+    ctl.SetTelemetry(20);
+    ctl.Start();
+
+    com.Open(RoboteqCom::eCAN, pty.SlavePath());
+
+    uint64_t    period   = 1000000000ULL / rateHz;
+    uint64_t    end      = NowNs() + seconds * 1000000000ULL;
+    uint64_t    next     = NowNs();
+    uint64_t    maxLag(0);
+    long        ticks(0);
+    char        line[160];
+
+    while( NowNs() < end )
+    {
+        int value = (int)(ticks % 2000) - 1000;
+
+        if( coalesce )
+        {
+            for( unsigned int node(1); node <= 3; node++ )
+            {
+                com.SetMotorSetpoint(node, 1, value, false);
+                com.SetMotorSetpoint(node, 2, -value, node == 3);
+            }
+        }
+        else
+        {
+            snprintf(line, sizeof(line), "@01!G 1 %d_@01!G 2 %d_@02!G 1 %d_@02!G 2 %d_@03!G 1 %d_@03!G 2 %d",
+                     value, -value, value, -value, value, -value);
+            com.IssueCommand(line);
+        }
+
+        // Newest command can not reach the wire before backlog drains
+        uint64_t lag = com.TxBacklogNs();
+
+        if( lag > maxLag )
+            maxLag = lag;
+
+        ++ticks;
+        next += period;
+
+        uint64_t now = NowNs();
+
+        if( next > now )
+            usleep((next - now) / 1000);
+    }
+
+    RoboteqCom::SetpointStats stats;
+    com.GetSetpointStats(stats);
+
+    com.Close();
+    ctl.Stop();
+
+    if( coalesce )
+        printf("coalesce  cmd_vel %6ld  setpoints %7lu  sent %6lu  coalesced %7lu  dropped %4lu  writes %5lu  max lag ms %8.1f\n",
+               ticks, stats.submitted, stats.sent, stats.coalesced, stats.dropped, stats.writes, maxLag / 1e6);
+    else
+        printf("legacy    cmd_vel %6ld  setpoints %7ld  sent %6ld  coalesced %7d  dropped %4d  writes %5ld  max lag ms %8.1f\n",
+               ticks, ticks * 6, ticks * 6, 0, 0, ticks, maxLag / 1e6);
+}
+
+int     BenchSetpoint(int argc, char* argv[])
+{
+    long rateHz  = ArgLong(argc, argv, 1, 1000);
+    long seconds = ArgLong(argc, argv, 2, 2);
+
+    printf("cmd_vel at %ld Hz for %ld s, CAN fan-out to 3 nodes, 115200 baud link model\n", rateHz, seconds);
+
+    RunCase(false, rateHz, seconds);
+    RunCase(true,  rateHz, seconds);
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include "benchUtil.h"
+#include "roboteqComEventArgs.h"
+#include "roboteqTelemetry.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char* gReplies[] =
+{
+    "S=1250:-1248\r",
+    "A=125:131\r",
+    "V=135:241:4980\r",
+    "T=31:33\r",
+    "CR=-12:15\r",
+    "BA=40:42\r",
+    "FF=0\r",
+    "C=102400:-99812\r",
+};
+
+static const int gReplyCount = sizeof(gReplies) / sizeof(gReplies[0]);
+
+// Old RosRoboteqDrv path. IEventArgs copy plus erase, find '=' and ':'
+// then NUL through const_cast and atoi
+class LegacyArgs
+{
+    public:
+        LegacyArgs(const string& reply) : _reply(reply)
+        {
+            if( isalpha( _reply[0] ) == 0 )
+                _reply = _reply.erase(0, 1);
+        }
+
+        inline const string& Reply(void) const { return _reply; }
+
+    private:
+        string _reply;
+};
+
+static long LegacyParse(const string& frame)
+{
+    LegacyArgs evt(frame);
+    LegacyArgs copy(evt);
+
+    string::size_type idx = copy.Reply().find_first_of('=');
+
+    if( idx == string::npos )
+        return 0;
+
+    string::size_type idy = copy.Reply().find_first_of(':', idx);
+
+    if( idy == string::npos )
+        return atoi( copy.Reply().c_str() + idx + 1 );
+
+    char* pVal1 = (char*)(copy.Reply().c_str() + idx + 1);
+    char* pVal2 = (char*)(copy.Reply().c_str() + idy);
+
+    *pVal2 = 0L;
+    pVal2++;
+
+    return atoi( pVal1 ) + atoi( pVal2 );
+}
+
+static long TableParse(const string& frame)
+{
+    IEventArgs              evt(frame);
+    RoboteqTelemetry::Reply reply;
+
+    if( RoboteqTelemetry::Parse(evt.Data(), evt.Length(), reply) == false )
+        return 0;
+
+    long sum(0);
+
+    for( unsigned int Idx(0); Idx < reply.count; Idx++ )
+        sum += reply.values[Idx];
+
+    return sum;
+}
+
+int     BenchTelemetry(int argc, char* argv[])
+{
+    long    iterations = ArgLong(argc, argv, 1, 2000000);
+    string  frames[gReplyCount];
+
+    // Reader hands out frames without terminator
+    for( int Idx(0); Idx < gReplyCount; Idx++ )
+    {
+        frames[Idx] = gReplies[Idx];
+        frames[Idx].resize( frames[Idx].size() - 1 );
+    }
+
+    printf("%ld replies, %d reply kinds\n", iterations, gReplyCount);
+
+    volatile long sink(0);
+    uint64_t      start = NowNs();
+
+    for( long Idx(0); Idx < iterations; Idx++ )
+        sink += LegacyParse( frames[Idx % gReplyCount] );
+
+    uint64_t legacyNs = NowNs() - start;
+
+    start = NowNs();
+
+    for( long Idx(0); Idx < iterations; Idx++ )
+        sink += TableParse( frames[Idx % gReplyCount] );
+
+    uint64_t tableNs = NowNs() - start;
+
+    printf("legacy  ns/reply %6.1f\n", (double)legacyNs / iterations);
+    printf("table   ns/reply %6.1f\n", (double)tableNs  / iterations);
+
+    return 0;
+}
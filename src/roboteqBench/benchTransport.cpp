@@ -0,0 +1,156 @@
+#include "benchUtil.h"
+#include "serialPort.h"
+#include "serialNetPort.h"
+#include "serialPtyPort.h"
+#include "serialReplayPort.h"
+#include "serialException.h"
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+
+struct FeedArgs
+{
+    int             fd;
+    const string*   pData;
+};
+
+// Same telemetry stream for every link, written in 4 KB chunks
+static string   MakeTelemetry(long frames)
+{
+    static const char* telemetry[] = { "S=1234:-1234\r", "A=125:-37\r", "V=120:245:5000\r" };
+
+    string data;
+
+    for( long Idx(0); Idx < frames; Idx++ )
+        data += telemetry[Idx % 3];
+
+    return data;
+}
+
+static void*    Feed(void* ptr)
+{
+    FeedArgs* pArgs = (FeedArgs*)ptr;
+
+    for( string::size_type off(0); off < pArgs->pData->size(); off += 4096 )
+    {
+        unsigned int len = pArgs->pData->size() - off < 4096 ? pArgs->pData->size() - off : 4096;
+
+        if( WriteAll(pArgs->fd, pArgs->pData->data() + off, len) == false )
+            break;
+    }
+
+    return 0L;
+}
+
+// Framing through SerialPort exactly as RoboteqCom reader does it.
+// writeFd < 0 means link feeds itself (replay)
+static void     RunCase(const char* name, SerialPort& port, int writeFd, const string& data, long frames)
+{
+    FeedArgs    args = { writeFd, &data };
+    pthread_t   feeder;
+
+    uint64_t    wall0 = NowNs();
+    uint64_t    cpu0  = ThreadCpuNs();
+
+    if( writeFd >= 0 && ::pthread_create(&feeder, NULL, Feed, &args) != 0 )
+        THROW_RUNTIME_ERROR("BenchTransport - failed to start feeder");
+
+    string      reply;
+    long        received(0);
+
+    while( received < frames )
+    {
+        if( port.readFrame(reply, '\r') <= 0 )
+            break;
+
+        ++received;
+    }
+
+    uint64_t    cpu  = ThreadCpuNs() - cpu0;
+    uint64_t    wall = NowNs() - wall0;
+
+    if( writeFd >= 0 )
+        ::pthread_join(feeder, NULL);
+
+    printf("%-8s frames %8ld  frames/s %10.0f  read()/frame %6.3f  cpu ns/frame %7.1f\n",
+           name, received, received / (wall / 1e9),
+           (double)port.rxReadCount() / received, (double)cpu / received);
+
+    port.disconnect(false);
+}
+
+int     BenchTransport(int argc, char* argv[])
+{
+    long        frames = ArgLong(argc, argv, 1, 200000);
+    string      data   = MakeTelemetry(frames);
+    NullLogger  log;
+
+    printf("%ld telemetry replies framed by SerialPort over each transport\n", frames);
+
+    {
+        PtyPair     pty;
+        SerialPort  port(log);
+
+        port.connect(pty.SlavePath());
+        RunCase("tty", port, pty.Master(), data, frames);
+    }
+
+    {
+        SerialPtyPort   link(log);
+        SerialPort      port(log);
+
+        port.transport(&link);
+        port.connect("");
+
+        int slave = ::open(link.SlavePath().c_str(), O_RDWR | O_NOCTTY);
+
+        if( slave < 0 )
+            THROW_RUNTIME_ERROR("BenchTransport - failed to open " << link.SlavePath());
+
+        RunCase("pty", port, slave, data, frames);
+        ::close(slave);
+    }
+
+    {
+        SerialNetPort   link(log);
+        SerialPort      port(log);
+        sockaddr_in     addr = sockaddr_in();
+        socklen_t       len  = sizeof(addr);
+        int             server = ::socket(AF_INET, SOCK_STREAM, 0);
+
+        addr.sin_family      = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        if( ::bind(server, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+            ::listen(server, 1) != 0 ||
+            ::getsockname(server, (sockaddr*)&addr, &len) != 0 )
+            THROW_RUNTIME_ERROR("BenchTransport - loopback listen failed. errno: " << errno);
+
+        char address[32];
+        snprintf(address, sizeof(address), "127.0.0.1:%u", ntohs(addr.sin_port));
+
+        port.transport(&link);
+        port.connect(address);
+
+        int client = ::accept(server, 0L, 0L);
+
+        RunCase("tcp", port, client, data, frames);
+        ::close(client);
+        ::close(server);
+    }
+
+    {
+        SerialReplayPort    link(log);
+        SerialPort          port(log);
+
+        link.setData(data);
+        port.transport(&link);
+        port.connect("");
+        RunCase("replay", port, -1, data, frames);
+    }
+
+    return 0;
+}
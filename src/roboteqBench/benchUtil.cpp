@@ -0,0 +1,261 @@
+#include "benchUtil.h"
+#include "serialException.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+
+PtyPair::PtyPair(void)
+ : _master(-1)
+{
+    _master = ::posix_openpt(O_RDWR | O_NOCTTY);
+
+    if( _master < 0 )
+        THROW_RUNTIME_ERROR("PtyPair - posix_openpt failed. errno: " << errno);
+
+    if( ::grantpt(_master) != 0 || ::unlockpt(_master) != 0 )
+    {
+        ::close(_master);
+        THROW_RUNTIME_ERROR("PtyPair - failed to unlock pty. errno: " << errno);
+    }
+
+    _slave = ::ptsname(_master);
+}
+
+PtyPair::~PtyPair(void)
+{
+    if( _master >= 0 )
+        ::close(_master);
+}
+
+static uint64_t ClockNs(clockid_t id)
+{
+    timespec ts;
+    ::clock_gettime(id, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+uint64_t    NowNs(void)         { return ClockNs(CLOCK_MONOTONIC); }
+uint64_t    ThreadCpuNs(void)   { return ClockNs(CLOCK_THREAD_CPUTIME_ID); }
+uint64_t    ProcessCpuNs(void)  { return ClockNs(CLOCK_PROCESS_CPUTIME_ID); }
+
+bool        WriteAll(int fd, const char* pBuffer, unsigned int size)
+{
+    while( size > 0 )
+    {
+        int count = ::write(fd, pBuffer, size);
+
+        if( count < 0 )
+        {
+            if( errno == EINTR || errno == EAGAIN )
+                continue;
+
+            return false;
+        }
+
+        pBuffer += count;
+        size    -= count;
+    }
+
+    return true;
+}
+
+long        ArgLong(int argc, char* argv[], int idx, long def)
+{
+    if( idx < argc )
+        return ::atol(argv[idx]);
+
+    return def;
+}
+
+FakeController::FakeController(int fd)
+ : _fd(fd), _stop(false), _running(false), _telemetryMs(0), _latencyUs(0),
+   _dropEvery(0), _acked(0),
+   _lines(0), _commands(0), _bytes(0)
+{
+}
+
+FakeController::~FakeController(void)
+{
+    Stop();
+}
+
+void    FakeController::Start(void)
+{
+    _stop = false;
+
+    if( ::pthread_create(&_thread, NULL, ThreadFn, this) != 0 )
+        THROW_RUNTIME_ERROR("FakeController - failed to start thread");
+
+    _running = true;
+}
+
+void    FakeController::Stop(void)
+{
+    if( _running )
+    {
+        _stop = true;
+        ::pthread_join(_thread, NULL);
+        _running = false;
+    }
+}
+
+void*   FakeController::ThreadFn(void* ptr)
+{
+    ((FakeController*)ptr)->Loop();
+    return 0L;
+}
+
+void    FakeController::Loop(void)
+{
+    char    buffer[4096];
+    string  line;
+    pollfd  pfd;
+
+    pfd.fd     = _fd;
+    pfd.events = POLLIN;
+
+    uint64_t nextTelemetry = NowNs();
+
+    while( _stop == false )
+    {
+        if( _telemetryMs != 0 && NowNs() >= nextTelemetry )
+        {
+            WriteAll(_fd, "S=0:0\r", 6);
+            nextTelemetry = NowNs() + _telemetryMs * 1000000ULL;
+        }
+
+        FlushDue();
+
+        int timeoutMs = _telemetryMs != 0 ? _telemetryMs : 20;
+
+        if( _delayed.empty() == false )
+        {
+            uint64_t now = NowNs();
+            uint64_t due = _delayed.front().first;
+
+            timeoutMs = due > now ? (int)((due - now + 999999) / 1000000) : 0;
+        }
+
+        if( ::poll(&pfd, 1, timeoutMs) <= 0 )
+            continue;
+
+        int count = ::read(_fd, buffer, sizeof(buffer));
+
+        if( count < 0 && errno == EIO )
+        {
+            // Slave side closed. Wait for it to be opened again
+            line.clear();
+            ::usleep(1000);
+            continue;
+        }
+
+        if( count <= 0 )
+            break;
+
+        _bytes = _bytes + count;
+
+        for( int Idx(0); Idx < count; Idx++ )
+        {
+            if( buffer[Idx] == '\r' )
+            {
+                if( line.empty() == false )
+                    Answer(line);
+
+                line.clear();
+            }
+            else
+                line += buffer[Idx];
+        }
+    }
+}
+
+void    FakeController::Reply(const char* pData, unsigned int len)
+{
+    if( _latencyUs == 0 )
+    {
+        WriteAll(_fd, pData, len);
+        return;
+    }
+
+    _delayed.push_back( make_pair(NowNs() + _latencyUs * 1000ULL, string(pData, len)) );
+}
+
+void    FakeController::FlushDue(void)
+{
+    uint64_t now = NowNs();
+
+    while( _delayed.empty() == false && _delayed.front().first <= now )
+    {
+        WriteAll(_fd, _delayed.front().second.data(), _delayed.front().second.size());
+        _delayed.pop_front();
+    }
+}
+
+void    FakeController::Answer(const string& line)
+{
+    _lines = _lines + 1;
+
+    if( line == "?$1E" )
+    {
+        Reply("FID=Roboteq bench\r", 18);
+        _commands = _commands + 1;
+        return;
+    }
+
+    if( line == "?$1F" )
+    {
+        Reply("TRN=:BENCH\r", 11);
+        _commands = _commands + 1;
+        return;
+    }
+
+    string::size_type start(0);
+
+    while( start <= line.size() )
+    {
+        string::size_type end = line.find('_', start);
+
+        if( end == string::npos )
+            end = line.size();
+
+        // Skip CAN "@NN" address
+        string::size_type cmd = start;
+
+        if( line[cmd] == '@' && cmd + 3 <= end )
+            cmd += 3;
+
+        if( cmd < end && (line[cmd] == '!' || line[cmd] == '^') )
+        {
+            ++_acked;
+
+            if( end >= cmd + 5 && line.compare(end - 5, 5, "99999") == 0 )
+                Reply("-\r", 2);
+            else if( _dropEvery == 0 || _acked % _dropEvery != 0 )
+                Reply("+\r", 2);
+        }
+        else if( cmd + 1 < end && line[cmd] == '?' )
+        {
+            char              answer[64];
+            string::size_type keyEnd = line.find(' ', cmd);
+
+            if( keyEnd == string::npos || keyEnd > end )
+                keyEnd = end;
+
+            string key = line.substr(cmd + 1, keyEnd - cmd - 1);
+            string node = line.substr(start, cmd - start);
+
+            int len = snprintf(answer, sizeof(answer), "%s%s=%lu:%lu\r", node.c_str(), key.c_str(),
+                               (unsigned long)_commands, (unsigned long)_commands);
+
+            Reply(answer, len);
+        }
+
+        _commands = _commands + 1;
+        start = end + 1;
+    }
+}
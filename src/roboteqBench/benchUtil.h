@@ -0,0 +1,113 @@
+#ifndef __BENCH_UTIL_H__
+#define __BENCH_UTIL_H__
+
+#include "serialLogger.h"
+#include <string>
+#include <deque>
+#include <utility>
+#include <stdint.h>
+#include <pthread.h>
+
+// Roboteq Benchmark helpers
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details at
+// http://www.gnu.org/copyleft/gpl.html
+
+using namespace std;
+using namespace oxoocoffee;
+
+// Pseudo terminal pair. Slave side is what SerialPort connects to,
+// master side plays the Roboteq controller
+class PtyPair
+{
+    public:
+                 PtyPair(void);
+                ~PtyPair(void);
+
+        inline int           Master(void)    const { return _master; }
+        inline const string& SlavePath(void) const { return _slave; }
+
+    private:
+        int     _master;
+        string  _slave;
+};
+
+// Minimal controller on pty master side. Enough for RoboteqCom::Open
+// ("^" and "!" get "+", ?$1E / ?$1F get version and model) and counts
+// what arrives. Each '_' separated command counts once. Other queries
+// "[@NN]?KEY" are answered "[@NN]KEY=n:n" with n the command count
+class FakeController
+{
+    public:
+                 FakeController(int fd);
+                ~FakeController(void);
+
+        void    Start(void);
+        void    Stop(void);
+
+                // Streams "S=0:0" every ms milliseconds like "# ms" would
+        inline void          SetTelemetry(unsigned int ms) { _telemetryMs = ms; }
+                // Every reply leaves us this long after its command came
+                // in (controller turnaround plus USB latency). Replies to
+                // back to back commands overlap, like on real link
+        inline void          SetReplyLatency(unsigned int us) { _latencyUs = us; }
+                // Every n-th "!" / "^" command is lost (no "+"). Commands
+                // with out of range value 99999 get "-"
+        inline void          SetDropEvery(unsigned int n) { _dropEvery = n; }
+
+        inline unsigned long Lines(void)    const { return _lines; }
+        inline unsigned long Commands(void) const { return _commands; }
+        inline unsigned long Bytes(void)    const { return _bytes; }
+
+    private:
+        static void* ThreadFn(void* ptr);
+        void         Loop(void);
+        void         Answer(const string& line);
+        void         Reply(const char* pData, unsigned int len);
+        void         FlushDue(void);
+
+    private:
+        int                     _fd;
+        pthread_t               _thread;
+        volatile bool           _stop;
+        bool                    _running;
+        unsigned int            _telemetryMs;
+        volatile unsigned int   _latencyUs;
+        volatile unsigned int   _dropEvery;
+        unsigned long           _acked;
+        deque< pair<uint64_t, string> > _delayed;
+        volatile unsigned long  _lines;
+        volatile unsigned long  _commands;
+        volatile unsigned long  _bytes;
+};
+
+// Logger that swallows everything
+class NullLogger : public SerialLogger
+{
+    public:
+        virtual bool    IsLogOpen(void) const { return false; }
+        virtual void    LogLine(const char*, unsigned int) {}
+        virtual void    LogLine(const std::string&) {}
+        virtual void    Log(const char*, unsigned int) {}
+        virtual void    Log(const std::string&) {}
+};
+
+uint64_t    NowNs(void);            // CLOCK_MONOTONIC
+uint64_t    ThreadCpuNs(void);      // CLOCK_THREAD_CPUTIME_ID
+uint64_t    ProcessCpuNs(void);     // CLOCK_PROCESS_CPUTIME_ID
+
+// Write all bytes, retrying on partial writes
+bool        WriteAll(int fd, const char* pBuffer, unsigned int size);
+
+// Numeric command line argument with default
+long        ArgLong(int argc, char* argv[], int idx, long def);
+
+#endif // __BENCH_UTIL_H__
@@ -0,0 +1,163 @@
+#include "benchUtil.h"
+#include "roboteqCom.h"
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+
+class NullListener : public IEventListener<const IEventArgs>
+{
+    public:
+        virtual void OnMsgEvent(const IEventArgs&) {}
+};
+
+// Counts completions coming back from writer thread
+class DoneCounter : public ICommandDone
+{
+    public:
+        DoneCounter(void) : _ok(0), _failed(0) {}
+
+        virtual void OnCommandDone(uint64_t, int result)
+        {
+            if( result > 0 )
+                ++_ok;
+            else
+                ++_failed;
+        }
+
+        volatile unsigned long _ok;
+        volatile unsigned long _failed;
+};
+
+struct Producer
+{
+    RoboteqCom*     pCom;
+    DoneCounter*    pDone;
+    bool            queued;
+    long            commands;
+    uint64_t        totalNs;
+    uint64_t        maxNs;
+    long            rejected;       // Submit retries on full queue
+    pthread_t       thread;
+};
+
+static void* ProducerFn(void* ptr)
+{
+    Producer&   p = *(Producer*)ptr;
+    char        args[32];
+
+    for( long Idx(0); Idx < p.commands; Idx++ )
+    {
+        snprintf(args, sizeof(args), "1 %ld", Idx % 1000);
+
+        uint64_t start = NowNs();
+
+        if( p.queued )
+        {
+            // Queue full. Back off and retry so every command goes out
+            while( p.pCom->Submit("!G", args, p.pDone) == 0 )
+            {
+                ++p.rejected;
+                sched_yield();
+            }
+        }
+        else
+            p.pCom->IssueCommand("!G", args);
+
+        uint64_t took = NowNs() - start;
+
+        p.totalNs += took;
+
+        if( took > p.maxNs )
+            p.maxNs = took;
+    }
+
+    return 0L;
+}
+
+static void RunCase(bool queued, int producers, long commands)
+{
+    PtyPair         pty;
+    FakeController  ctl(pty.Master());
+    NullLogger      log;
+    NullListener    listener;
+    DoneCounter     done;
+    RoboteqCom      com(log, listener);
+    Producer        prod[16];
+
+    if( queued )
+        com.SetWriter(4096);
+
+    ctl.SetTelemetry(20);
+    ctl.Start();
+
+    com.Open(RoboteqCom::eSerial, pty.SlavePath());
+
+    unsigned long writesBefore = com.Port().txWriteCount();
+    uint64_t      start        = NowNs();
+
+    for( int Idx(0); Idx < producers; Idx++ )
+    {
+        Producer& p = prod[Idx];
+
+        p.pCom     = &com;
+        p.pDone    = &done;
+        p.queued   = queued;
+        p.commands = commands;
+        p.totalNs  = 0;
+        p.maxNs    = 0;
+        p.rejected = 0;
+
+        pthread_create(&p.thread, 0L, ProducerFn, &p);
+    }
+
+    uint64_t totalNs(0);
+    uint64_t maxNs(0);
+    long     rejected(0);
+
+    for( int Idx(0); Idx < producers; Idx++ )
+    {
+        pthread_join(prod[Idx].thread, 0L);
+
+        totalNs  += prod[Idx].totalNs;
+        rejected += prod[Idx].rejected;
+
+        if( prod[Idx].maxNs > maxNs )
+            maxNs = prod[Idx].maxNs;
+    }
+
+    // Queued commands are done once writer drained them
+    while( queued && done._ok + done._failed < (unsigned long)(producers * commands) )
+        usleep(100);
+
+    uint64_t      elapsed = NowNs() - start;
+    unsigned long writes  = com.Port().txWriteCount() - writesBefore;
+
+    com.Close();
+    ctl.Stop();
+
+    long total = producers * commands;
+
+    printf("%-7s producers %2d  call ns avg %7.0f max %9.0f  write() %6lu  cmds/s %8.0f  full %ld\n",
+           queued ? "queued" : "locked", producers, (double)totalNs / total, (double)maxNs,
+           writes, total / (elapsed / 1e9), rejected);
+}
+
+int     BenchWriter(int argc, char* argv[])
+{
+    long commands  = ArgLong(argc, argv, 1, 20000);
+    long producers = ArgLong(argc, argv, 2, 8);
+
+    if( producers > 16 )
+        producers = 16;
+
+    printf("%ld commands per producer thread\n", commands);
+
+    for( int count(1); count <= producers; count *= 2 )
+    {
+        RunCase(false, count, commands);
+        RunCase(true,  count, commands);
+    }
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <iostream>
+#include <string.h>
+#include "benchUtil.h"
+
+// Every benchmark takes its own argv (argv[0] is benchmark name)
+typedef int (*TBenchFn)(int argc, char* argv[]);
+
+int     BenchRx(int argc, char* argv[]);
+int     BenchEngine(int argc, char* argv[]);
+int     BenchBatch(int argc, char* argv[]);
+int     BenchSetpoint(int argc, char* argv[]);
+int     BenchSched(int argc, char* argv[]);
+int     BenchTelemetry(int argc, char* argv[]);
+int     BenchRing(int argc, char* argv[]);
+int     BenchWriter(int argc, char* argv[]);
+int     BenchQuery(int argc, char* argv[]);
+int     BenchAck(int argc, char* argv[]);
+int     BenchHist(int argc, char* argv[]);
+int     BenchProfile(int argc, char* argv[]);
+int     BenchReconnect(int argc, char* argv[]);
+int     BenchTransport(int argc, char* argv[]);
+int     BenchCapture(int argc, char* argv[]);
+int     BenchLogger(int argc, char* argv[]);
+int     BenchLogLevel(int argc, char* argv[]);
+int     BenchCmdLine(int argc, char* argv[]);
+
+struct BenchEntry
+{
+    const char* name;
+    TBenchFn    fn;
+    const char* help;
+};
+
+static const BenchEntry gBenches[] =
+{
+    { "rx",     BenchRx,    "rx [frames]            - per byte vs buffered ReadReply over pty" },
+    { "engine", BenchEngine,"engine [hz] [sec] [max]- epoll engine scaling from 1 to max pty ports" },
+    { "batch",  BenchBatch, "batch [ticks] [us]     - IssueCommand batching window vs one write per command" },
+    { "setpoint", BenchSetpoint, "setpoint [hz] [sec]    - cmd_vel flood, latest wins setpoints vs full line per message" },
+    { "sched",  BenchSched, "sched [lines]          - priority scheduler, !EX latency behind a config dump" },
+    { "telemetry", BenchTelemetry, "telemetry [n]          - table driven reply parser vs find/atoi, ns per reply" },
+    { "ring",   BenchRing,  "ring [ms] [us] [sec]   - slow consumer on reader thread vs SPSC reply handoff" },
+    { "writer", BenchWriter,"writer [cmds] [thr]    - producer contention, locked IssueCommand vs MPSC writer thread" },
+    { "query",  BenchQuery, "query [rounds] [us]    - serial vs pipelined queries with query futures" },
+    { "ack",    BenchAck,   "ack [drop] [n] [retry] - tracked commands on lossy link, per command ack latency" },
+    { "hist",   BenchHist,  "hist [n] [rounds] [ms] - histogram record cost, live ack / query / telemetry percentiles" },
+    { "profile", BenchProfile, "profile [n] [us]       - paced frames, receive latency and read() count per SerialPort profile" },
+    { "reconnect", BenchReconnect, "reconnect [n]          - reconnect cost, per setter tcsetattr vs one Config vs skip when tty matches" },
+    { "transport", BenchTransport, "transport [frames]     - same framing over tty, pty, TCP loopback and replay transports" },
+    { "capture", BenchCapture, "capture [frames]       - SerialPort capture tee cost, capture replayed fast and in real time" },
+    { "logger",  BenchLogger,  "logger [lines] [thr]   - LogLine cost, mutex + flush per line vs async ring logger" },
+    { "loglevel", BenchLogLevel, "loglevel [n]           - cmd_vel trace cost, always formatted vs SERIAL_LOG_DEBUG off / on / stripped" },
+    { "cmdline", BenchCmdLine, "cmdline [n]            - cmd_vel line build, stringstream / snprintf vs RoboteqCmdLine / typed / template" },
+};
+
+static const int gBenchCount = sizeof(gBenches) / sizeof(gBenches[0]);
+
+void    PrintHelp(string progName);
+
+int main(int argc, char* argv[])
+{
+    if( argc < 2 )
+    {
+        PrintHelp(argv[0]);
+        return 0;
+    }
+
+    for( int Idx(0); Idx < gBenchCount; Idx++ )
+    {
+        if( strcmp(argv[1], gBenches[Idx].name) == 0 )
+        {
+            try
+            {
+                return gBenches[Idx].fn(argc - 1, argv + 1);
+            }
+            catch(std::exception& ex)
+            {
+                cout << "Exception: " << ex.what() << endl;
+                return -2;
+            }
+        }
+    }
+
+    cout << "Error: unknown benchmark " << argv[1] << endl;
+    PrintHelp(argv[0]);
+
+    return -1;
+}
+
+void    PrintHelp(string progName)
+{
+    string::size_type Idx = progName.find_last_of("\\/");
+
+    if( Idx != string::npos )
+        progName = progName.substr( Idx + 1 );
+
+    cout << endl;
+    cout << "Usage: " << progName << " <benchmark> [args]" << endl;
+
+    for( int Idx(0); Idx < gBenchCount; Idx++ )
+        cout << "   " << gBenches[Idx].help << endl;
+}
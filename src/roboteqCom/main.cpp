@@ -1,40 +1,14 @@
 #include <iostream>
-#include <fstream>
 #include <vector>
 #include <unistd.h>
 #include <signal.h>
 #include "roboteqCom.h"
+#include "serialAsyncLogger.h"
 
 using namespace oxoocoffee;
 
 #define LOG_FILE_NAME       "roboteqCom.log"
 
-class RoboteqLogger : public SerialLogger
-{
-    public:
-        RoboteqLogger(void);
-
-        bool    Open(const string& filePath, bool threded);
-        void    Close(void);
-
-        virtual void    LogLine(const char* pBuffer, unsigned int len);
-        virtual void    LogLine(const std::string& message);
-		
-		// DO NOT Write new line at end
-        virtual void    Log(const char* pBuffer, unsigned int len);
-        virtual void    Log(const std::string& message);
-
-        virtual bool    IsLogOpen(void) const
-        {
-            return _file.is_open();
-        }
-
-    private:
-        ofstream        _file;
-        bool            _threaded;
-        pthread_mutex_t _mx;
-};
-
 class RoboteqTest : public IEventListener<const IEventArgs>
 {
     public:
@@ -50,10 +24,10 @@ class RoboteqTest : public IEventListener<const IEventArgs>
         virtual void OnMsgEvent(const IEventArgs& evt);
 
     private:
-        RoboteqLogger   _logger;
-        RoboteqCom      _comunicator;
-        RoboMutex       _mutex;            // Optionally used if RoboteqCom setup in threaded mode
-        string          _device;
+        SerialAsyncLogger   _logger;
+        RoboteqCom          _comunicator;
+        RoboMutex           _mutex;            // Optionally used if RoboteqCom setup in threaded mode
+        string              _device;
 };
 
 RoboteqTest app;
@@ -168,15 +142,18 @@ bool    RoboteqTest::Initialize(int argc, char* argv[])
         return false;
     }
 
-    if( _logger.Open(LOG_FILE_NAME, _comunicator.IsThreaded() ) == false )
+    // Our process, so log tail may be saved on a crash
+    SerialAsyncLogger::InstallCrashHandler();
+
+    if( _logger.Open(LOG_FILE_NAME) == false )
         THROW_RUNTIME_ERROR(string("Failed to open ") + LOG_FILE_NAME);
 
     _comunicator.Open( mode, _device );
 
-    _comunicator.IssueCommand("^ECHOF 1");
-    _comunicator.IssueCommand("?S");    // Query for speed and enters this speed
-                                        // request into telemetry system
-    _comunicator.IssueCommand("# 500"); // auto message responce is 200ms
+    _comunicator.IssueCommand(RoboteqCmd::Cmd<RoboteqCmd::Echo>(0, 1));
+    _comunicator.IssueCommand(RoboteqCmd::Cmd<RoboteqCmd::ReadSpeed>(0));           // Query for speed and enters this speed
+                                                                                    // request into telemetry system
+    _comunicator.IssueCommand(RoboteqCmd::Cmd<RoboteqCmd::TelemetryEvery>(0, 500)); // auto message responce is 200ms
 
     return true;
 }
@@ -200,97 +177,3 @@ void RoboteqTest::OnMsgEvent(const IEventArgs& evt)
     cout << "> : " << evt.Reply() << endl;
     _logger.LogLine("> : " + evt.Reply());
 }
-
-RoboteqLogger::RoboteqLogger(void)
-{
-     pthread_mutex_init(&_mx, NULL);
-}
-
-bool    RoboteqLogger::Open(const string& filePath, bool threded)
-{
-    _threaded = threded;
-
-    Close();
-
-    _file.open( filePath.c_str(), ios_base::out | ios_base::app );
-
-    if( _file.is_open() )
-    {
-        _file << "+++++++++ Opened ++++++++" << endl;
-        return true;
-    }
-    else
-        return false;
-}
-
-void    RoboteqLogger::Close(void)
-{
-    if( _file.is_open() )
-    {
-        _file << "--------- Closed --------" << endl;
-        _file.close();
-    }
-}
-
-void    RoboteqLogger::LogLine(const char* pBuffer, unsigned int len)
-{
-    if( _file.is_open() )
-    {
-        if( _threaded )
-            pthread_mutex_lock(&_mx);
-
-        _file.write(pBuffer, len) << std::endl;
-        _file.flush();
-
-        if( _threaded )
-            pthread_mutex_unlock(&_mx);
-    }
-}
-
-void    RoboteqLogger::LogLine(const std::string& message)
-{
-    if( _file.is_open() )
-    {
-        if( _threaded )
-            pthread_mutex_lock(&_mx);
-
-        _file << message << std::endl;
-        _file.flush();
-
-        if( _threaded )
-            pthread_mutex_unlock(&_mx);
-    }
-}
-
-// DO NOT Write new line at end
-void    RoboteqLogger::Log(const char* pBuffer, unsigned int len)
-{
-    if( _file.is_open() )
-    {
-        if( _threaded )
-            pthread_mutex_lock(&_mx);
-
-        _file.write(pBuffer, len);
-        _file.flush();
-    
-        if( _threaded )
-            pthread_mutex_unlock(&_mx);
-    }
-}
-
-void    RoboteqLogger::Log(const std::string& message)
-{
-    if( _file.is_open() )
-    {
-         if( _threaded )
-            pthread_mutex_lock(&_mx);
-
-        _file << message;
-        _file.flush();
-
-        if( _threaded )
-            pthread_mutex_unlock(&_mx);
-    }
-}
-
-
@@ -0,0 +1,70 @@
+#include "roboteqAck.h"
+#include "roboteqCom.h"
+
+namespace oxoocoffee
+{
+
+RoboteqAck::RoboteqAck(void)
+ : _status(eStatus_Idle), _finished(true), _timeoutMs(0), _retries(0), _attempts(0),
+   _latencyNs(0), _pDone(0L), _pCom(0L), _pNext(0L)
+{
+    pthread_mutex_init(&_mx, NULL);
+    pthread_cond_init(&_cond, NULL);
+}
+
+RoboteqAck::~RoboteqAck(void)
+{
+    pthread_mutex_lock(&_mx);
+    bool finished = _finished;
+    pthread_mutex_unlock(&_mx);
+
+    // Status turns final before callback runs. Reader may still be
+    // inside Complete, so wait for _finished, not for status
+    if( finished == false && _pCom != 0L && _pCom->Cancel(*this) == false )
+        Wait();
+
+    pthread_cond_destroy(&_cond);
+    pthread_mutex_destroy(&_mx);
+}
+
+bool    RoboteqAck::Wait(void)
+{
+    pthread_mutex_lock(&_mx);
+
+    while( _finished == false )
+        pthread_cond_wait(&_cond, &_mx);
+
+    bool accepted = (_status == eStatus_Accepted);
+
+    pthread_mutex_unlock(&_mx);
+
+    return accepted;
+}
+
+RoboteqAck::eStatus RoboteqAck::Status(void) const
+{
+    pthread_mutex_lock(&_mx);
+    eStatus status = _status;
+    pthread_mutex_unlock(&_mx);
+
+    return status;
+}
+
+// Caller already dropped it from ack window. Waiter is
+// released only after callback returns
+void    RoboteqAck::Complete(eStatus status)
+{
+    pthread_mutex_lock(&_mx);
+    _status = status;
+    pthread_mutex_unlock(&_mx);
+
+    if( _pDone != 0L )
+        _pDone->OnAckDone(*this);
+
+    pthread_mutex_lock(&_mx);
+    _finished = true;
+    pthread_cond_broadcast(&_cond);
+    pthread_mutex_unlock(&_mx);
+}
+
+}   // End of oxoocoffee namespace
@@ -0,0 +1,138 @@
+#include "roboteqCmdLine.h"
+
+namespace oxoocoffee
+{
+
+static const char gDigitPairs[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+char*   RoboteqCmdLine::FormatUInt(char* pOut, uint32_t value)
+{
+    char    tmp[10];
+    char*   p = tmp + sizeof(tmp);
+
+    while( value >= 100 )
+    {
+        unsigned int Idx = (value % 100) * 2;
+
+        value /= 100;
+        *--p = gDigitPairs[Idx + 1];
+        *--p = gDigitPairs[Idx];
+    }
+
+    if( value >= 10 )
+    {
+        *--p = gDigitPairs[value * 2 + 1];
+        *--p = gDigitPairs[value * 2];
+    }
+    else
+        *--p = (char)('0' + value);
+
+    unsigned int len = tmp + sizeof(tmp) - p;
+
+    memcpy(pOut, p, len);
+
+    return pOut + len;
+}
+
+char*   RoboteqCmdLine::FormatInt(char* pOut, int value)
+{
+    uint32_t magnitude = (uint32_t)value;
+
+    if( value < 0 )
+    {
+        *pOut++   = '-';
+        magnitude = 0u - magnitude;     // INT_MIN safe
+    }
+
+    return FormatUInt(pOut, magnitude);
+}
+
+RoboteqCmdLine& RoboteqCmdLine::Next(unsigned int node)
+{
+    if( _count++ != 0 )
+        Append('_');
+
+    if( node != 0 )
+    {
+        Append('@');
+
+        if( node < 10 )
+            Append('0');
+
+        Append(node);
+    }
+
+    return *this;
+}
+
+RoboteqCmdLine& RoboteqCmdLine::Command(unsigned int node, const char* pName,
+                                        unsigned int channel, int value)
+{
+    Next(node).Append(pName).Append(' ');
+
+    // Both numbers fit, skip per call checks
+    if( _len + 22 <= MAX_LINE )
+    {
+        char* p = FormatUInt(_buf + _len, channel);
+
+        *p++ = ' ';
+        _len = FormatInt(p, value) - _buf;
+
+        return *this;
+    }
+
+    return Append(channel).Append(' ').Append(value);
+}
+
+RoboteqCmdLine& RoboteqCmdLine::Append(const char* pText, unsigned int len)
+{
+    if( _len + len > MAX_LINE )
+    {
+        _overflow = true;
+        len       = _len < MAX_LINE ? MAX_LINE - _len : 0;
+    }
+
+    memcpy(_buf + _len, pText, len);
+    _len += len;
+
+    return *this;
+}
+
+RoboteqCmdLine& RoboteqCmdLine::Append(int value)
+{
+    if( _len + 11 <= MAX_LINE )
+        _len = FormatInt(_buf + _len, value) - _buf;
+    else
+    {
+        char tmp[11];
+        Append(tmp, FormatInt(tmp, value) - tmp);
+    }
+
+    return *this;
+}
+
+RoboteqCmdLine& RoboteqCmdLine::Append(unsigned int value)
+{
+    if( _len + 10 <= MAX_LINE )
+        _len = FormatUInt(_buf + _len, value) - _buf;
+    else
+    {
+        char tmp[10];
+        Append(tmp, FormatUInt(tmp, value) - tmp);
+    }
+
+    return *this;
+}
+
+void    RoboteqCmdLine::Terminate(void)
+{
+    if( _len <= MAX_LINE )
+        _buf[_len++] = '\r';    // Spare byte past MAX_LINE
+}
+
+}   // End of oxoocoffee namespace
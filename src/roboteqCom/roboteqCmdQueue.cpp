@@ -0,0 +1,104 @@
+#include "roboteqCmdQueue.h"
+#include "serialException.h"
+#include <string.h>
+
+namespace oxoocoffee
+{
+
+RoboteqCmdQueue::RoboteqCmdQueue(unsigned int slots)
+ : _slots(0L), _mask(0), _enqueuePos(0), _dequeuePos(0)
+{
+    if( slots == 0 )
+        THROW_INVALID_ARG("RoboteqCmdQueue - slots must not be 0");
+
+    unsigned int capacity(1);
+
+    while( capacity < slots )
+        capacity <<= 1;
+
+    _mask  = capacity - 1;
+    _slots = new Slot[capacity];
+
+    // Slot n is free for position n
+    for( unsigned int Idx(0); Idx < capacity; Idx++ )
+        _slots[Idx].sequence.store(Idx, std::memory_order_relaxed);
+}
+
+RoboteqCmdQueue::~RoboteqCmdQueue(void)
+{
+    delete [] _slots;
+}
+
+uint64_t RoboteqCmdQueue::Push(const char* pData, unsigned int len, ICommandDone* pDone)
+{
+    if( len > ROBO_CMDQ_SLOT_BYTES )
+        return 0;
+
+    uint64_t pos = _enqueuePos.load(std::memory_order_relaxed);
+    Slot*    pSlot;
+
+    // Claim position. Slot is free when its sequence equals position
+    while( true )
+    {
+        pSlot = &_slots[pos & _mask];
+
+        uint64_t seq = pSlot->sequence.load(std::memory_order_acquire);
+        int64_t  dif = (int64_t)seq - (int64_t)pos;
+
+        if( dif == 0 )
+        {
+            if( _enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed) )
+                break;
+        }
+        else if( dif < 0 )
+            return 0;       // Full. Writer has not released this slot yet
+        else
+            pos = _enqueuePos.load(std::memory_order_relaxed);
+    }
+
+    memcpy(pSlot->data, pData, len);
+    pSlot->length = len;
+    pSlot->pDone  = pDone;
+
+    // Publish to writer
+    pSlot->sequence.store(pos + 1, std::memory_order_release);
+
+    return pos + 1;
+}
+
+bool    RoboteqCmdQueue::Peek(const char*& pData, unsigned int& len,
+                              ICommandDone*& pDone, uint64_t& ticket) const
+{
+    uint64_t    pos  = _dequeuePos.load(std::memory_order_relaxed);
+    const Slot& slot = _slots[pos & _mask];
+
+    if( slot.sequence.load(std::memory_order_acquire) != pos + 1 )
+        return false;
+
+    pData  = slot.data;
+    len    = slot.length;
+    pDone  = slot.pDone;
+    ticket = pos + 1;
+
+    return true;
+}
+
+void    RoboteqCmdQueue::Release(void)
+{
+    uint64_t pos  = _dequeuePos.load(std::memory_order_relaxed);
+    Slot&    slot = _slots[pos & _mask];
+
+    // Free for position one lap ahead
+    slot.sequence.store(pos + _mask + 1, std::memory_order_release);
+    _dequeuePos.store(pos + 1, std::memory_order_release);
+}
+
+unsigned int RoboteqCmdQueue::Size(void) const
+{
+    uint64_t tail = _dequeuePos.load(std::memory_order_acquire);
+    uint64_t head = _enqueuePos.load(std::memory_order_acquire);
+
+    return head > tail ? (unsigned int)(head - tail) : 0;
+}
+
+}   // End of oxoocoffee namespace
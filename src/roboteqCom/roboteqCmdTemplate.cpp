@@ -0,0 +1,80 @@
+#include "roboteqCmdTemplate.h"
+
+namespace oxoocoffee
+{
+
+void    RoboteqCmdTemplate::Clear(void)
+{
+    _len      = 0;
+    _count    = 0;
+    _overflow = false;
+    _buf[0]   = '\r';
+}
+
+unsigned int RoboteqCmdTemplate::AddSlot(const char* pCmd, unsigned int len)
+{
+    // Separator, command, ' ', "0"
+    unsigned int need = (_count != 0 ? 1 : 0) + len + 2;
+
+    if( _count == MAX_SLOTS || _len + need > MAX_LINE )
+    {
+        _overflow = true;
+        return MAX_SLOTS;
+    }
+
+    if( _count != 0 )
+        _buf[_len++] = '_';
+
+    memcpy(_buf + _len, pCmd, len);
+    _len += len;
+    _buf[_len++] = ' ';
+
+    Slot& slot = _slots[_count];
+
+    slot.offset  = _len;
+    slot.len     = 1;
+    slot.value   = 0;
+    _buf[_len++] = '0';
+    _buf[_len]   = '\r';
+
+    return _count++;
+}
+
+void    RoboteqCmdTemplate::Set(unsigned int slot, int value)
+{
+    if( slot >= _count )
+        return;
+
+    Slot& s = _slots[slot];
+
+    if( s.value == value )
+        return;
+
+    char            digits[11];
+    unsigned int    len = RoboteqCmdLine::FormatInt(digits, value) - digits;
+
+    if( len != s.len )
+    {
+        if( _len + len - s.len > MAX_LINE )
+        {
+            _overflow = true;
+            return;
+        }
+
+        // Shift rest of the line, terminator included
+        unsigned int tail = s.offset + s.len;
+
+        memmove(_buf + s.offset + len, _buf + tail, _len + 1 - tail);
+
+        for( unsigned int Idx(slot + 1); Idx < _count; Idx++ )
+            _slots[Idx].offset += len - s.len;
+
+        _len += len - s.len;
+        s.len = len;
+    }
+
+    memcpy(_buf + s.offset, digits, len);
+    s.value = value;
+}
+
+}   // End of oxoocoffee namespace
@@ -1,13 +1,19 @@
 #include "roboteqCom.h"
+#include "roboteqEngine.h"
 #include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 #include <string.h> // For strtok
+#include <ctype.h>
+#include <stdlib.h>
+#include <stdio.h>
 #include <iomanip>
 
 namespace oxoocoffee
 {
 
-#define     ROBO_TERMINATOR		'\r'
-#define	    ROBO_MSG_MAX		1024
+#define     ROBO_TIMEOUT_MS     500     // Default per handshake step
 
 string ToHex(const string& s, bool upper_case /* = true */)
 {
@@ -20,256 +26,1902 @@ string ToHex(const string& s, bool upper_case /* = true */)
 }
 
 RoboteqCom::RoboteqCom(SerialLogger& log)
- : _port(log), _mode(eSerial), _event(_dummyEvent), _thread(*this)
+ : _port(log), _mode(eSerial), _event(_dummyEvent), _thread(*this), _engine(0L),
+   _writerRunner(*this), _writerThread(_writerRunner)
 {
     // This is just to shut up compiler warning
     // of _dummyEvent not used
-    IEventArgs dummy("");
+    string     empty;
+    IEventArgs dummy(empty);
     _dummyEvent.OnMsgEvent( dummy );
 
     CTorInit();
 }
 
 RoboteqCom::RoboteqCom(SerialLogger& log, IRoboteqEvent& event)
- : _port(log), _mode(eSerial), _event(event), _thread(*this)
+ : _port(log), _mode(eSerial), _event(event), _thread(*this), _engine(0L),
+   _writerRunner(*this), _writerThread(_writerRunner)
 {
     CTorInit();
 }
 
+RoboteqCom::RoboteqCom(SerialLogger& log, IRoboteqEvent& event, RoboteqEngine& engine)
+ : _port(log), _mode(eSerial), _event(event), _thread(*this), _engine(&engine),
+   _writerRunner(*this), _writerThread(_writerRunner)
+{
+    CTorInit();
+}
+
+RoboteqCom::~RoboteqCom(void)
+{
+    StopWriter();
+
+    // Engine must not call back into us once we are gone
+    if( _engine != 0L )
+        _engine->Remove(_port);
+
+    delete _replies;
+    delete _commands;
+
+    if( _writerWake != -1 )
+        ::close(_writerWake);
+}
+
 void    RoboteqCom::CTorInit(void)
 {
+    _replies        = 0L;
+    _commands       = 0L;
+    _writerWake     = -1;
+    _writerStop     = false;
+    _writerIdle.store(false);
+    _writerSubmitted.store(0);
+    _writerWritten.store(0);
+    _writerFailed.store(0);
+    _writerWrites.store(0);
+    _queryHead      = 0L;
+    _queryTail      = 0L;
+    _queryCount.store(0);
+
+    _ackEnabled     = false;
+    _ackTimeoutNs   = (uint64_t)ROBO_ACK_TIMEOUT_MS * 1000000;
+    _ackHead        = 0;
+    _ackCount       = 0;
+    _ackNext        = 0L;
+    _ackOrphans     = 0L;
+    _ackTypeCount   = 0;
+    _lastTelemetryNs = 0;
+
+    memset(_ackTypes, 0, sizeof(_ackTypes));
+    _writerRejected.store(0);
+    _writerMaxDepth.store(0);
+    _timeoutMs      = ROBO_TIMEOUT_MS;
+    _portConfig.baud    = 115200;
+    _portConfig.profile = SerialPort::eProfile_LowLatency;
+    _batchWindowNs  = 0;
+    _batchMaxBytes  = ROBO_BATCH_MAX;
+    _batchStartNs   = 0;
+    _batchCount     = 0;
+
+    memset(&_batchStats, 0, sizeof(_batchStats));
+
+    _timedService     = false;
+    _txBusyUntilNs    = 0;
+    _setpointsPending = 0;
+    _spTemplateMask   = 0;
+
+    memset(_setpoints, 0, sizeof(_setpoints));
+    memset(&_setpointStats, 0, sizeof(_setpointStats));
+
+    _schedEnabled     = false;
+    _schedSlackNs     = (uint64_t)ROBO_SCHED_SLACK_US * 1000;
+    _queued           = 0;
+
+    memset(_classStats, 0, sizeof(_classStats));
 }
 
 void    RoboteqCom::Open(eMode mode, const string& device)
 {
     _mode = mode;
 
-    if( mode == eSerial )
-        _port.logLine("RoboteqCom - connecting [SERIAL]");
-    else
-        _port.logLine("RoboteqCom - connecting [CAN]");
-
-    _port.canonical(SerialPort::eCanonical_Disable);
-    _port.baud(115200);
-    _port.dateSize(SerialPort::eDataSize_8Bit);
-    _port.stopBit(SerialPort::eStopBit_1);
-    _port.parity(SerialPort::eParity_None);
-    _port.flowControl(SerialPort::eFlow_None);
+    SERIAL_LOG_INFO(_port.logger(), "RoboteqCom - connecting " << (mode == eSerial ? "[SERIAL]" : "[CAN]"));
 
-    _port.connect( device );
+    _port.connect( device, _portConfig );
 
-    _port.logLine("RoboteqCom - connected");
+    SERIAL_LOG_INFO(_port.logger(), "RoboteqCom - connected");
 
-    if( IssueCommand("#") <= 0 )
+    if( IssueCommand(RoboteqCmd::Cmd<RoboteqCmd::TelemetryStop>(0)) <= 0 )
     {
-         _port.log("RoboteqCom - Clears out auto message responce FAILED ");
+         SERIAL_LOG_ERROR(_port.logger(), "RoboteqCom - Clears out auto message responce FAILED");
          throw std::runtime_error("RoboteqCom - Clears out auto message responce FAILED ");
     }
 
-    if( IssueCommand("# C") <= 0 )
+    if( IssueCommand(RoboteqCmd::Cmd<RoboteqCmd::TelemetryClear>(0)) <= 0 )
     {
-         _port.log("RoboteqCom - Clears out telemetry strings FAILED ");
+         SERIAL_LOG_ERROR(_port.logger(), "RoboteqCom - Clears out telemetry strings FAILED");
          throw std::runtime_error("RoboteqCom - Clears out telemetry strings FAILED ");
     }
 
-    if( IssueCommand("^ECHOF 1") <= 0)
+    if( IssueCommand(RoboteqCmd::Cmd<RoboteqCmd::Echo>(0, 1)) <= 0)
     {
-         _port.log("RoboteqCom - ECHO OFF send FAILED ");
+         SERIAL_LOG_ERROR(_port.logger(), "RoboteqCom - ECHO OFF send FAILED");
          throw std::runtime_error("RoboteqCom - ECHO OFF Send FAILED ");
     }
 
-    if( Synchronize( ) == false )
+    if( Synchronize( SerialClock::DeadlineIn(_timeoutMs) ) == false )
     {
-        _port.log("RoboteqCom - RoboteqCom - Synchronization Failed ^ECHOF 1");
+        SERIAL_LOG_ERROR(_port.logger(), "RoboteqCom - Synchronization Failed ^ECHOF 1");
         throw std::runtime_error("RoboteqCom - RoboteqCom - Synchronization Failed ^ECHOF 1");
     }
 
     if( _port.isOpen() == false )
         throw std::runtime_error("RoboteqCom - Synchronization Failed");
 
-    if( IssueCommand("?$1E") > 0 )
+    if( IssueCommand(RoboteqCmd::Cmd<RoboteqCmd::ReadFirmware>(0)) > 0 )
     {
-        _port.log("RoboteqCom - ver: ");
-    
-        if( ReadReply( _version ) > 0 )
+        if( ReadReply( _version, SerialClock::DeadlineIn(_timeoutMs) ) > 0 )
         {
             string::size_type Idx = _version.find_first_of("=");
 
             if( Idx != string::npos)
                 _version = _version.substr( Idx + 1, _version.size() - (Idx + 2));  // Strip '\r'
 
-            _port.logLine(_version);
+            SERIAL_LOG_INFO(_port.logger(), "RoboteqCom - ver: " << _version);
 
-            if( IssueCommand("?$1F") > 0 )
+            if( IssueCommand(RoboteqCmd::Cmd<RoboteqCmd::ReadModel>(0)) > 0 )
             {
-                _port.log("RoboteqCom - mod: ");
-    
-                if( ReadReply( _model ) > 0 )
+                if( ReadReply( _model, SerialClock::DeadlineIn(_timeoutMs) ) > 0 )
                 {
                     string::size_type Idx = _model.find_first_of(":");
                     
                     if( Idx != string::npos)
                         _model = _model.substr( Idx + 1, _model.size() - (Idx + 2));    // Strip '\r'
 
-                    _port.logLine(_model);
+                    SERIAL_LOG_INFO(_port.logger(), "RoboteqCom - mod: " << _model);
                 }
                 else
-                {
-                    ostringstream i2a; i2a << "RoboteqCom - ERROR Model: errno " << errno;
-                    _port.logLine(i2a.str());
-                }
+                    SERIAL_LOG_ERROR(_port.logger(), "RoboteqCom - ERROR Model: " << (errno == ETIMEDOUT ? "timed out" : "errno ") << errno);
             }
             else
             {
-                _port.log("RoboteqCom - checking model FAILED ");
+                SERIAL_LOG_ERROR(_port.logger(), "RoboteqCom - checking model FAILED");
                 throw std::runtime_error("RoboteqCom - checking model FAILED ");
             }
         }
         else
-        {
-            ostringstream i2a; i2a << "RoboteqCom - ERROR Version: errno " << errno;
-            _port.logLine(i2a.str());
-        }
+            SERIAL_LOG_ERROR(_port.logger(), "RoboteqCom - ERROR Version: " << (errno == ETIMEDOUT ? "timed out" : "errno ") << errno);
 
-        _port.logLine("RoboteqCom - login ok");
+        SERIAL_LOG_INFO(_port.logger(), "RoboteqCom - login ok");
     }
     else
     {
-        _port.log("RoboteqCom - checking version FAILED ");
+        SERIAL_LOG_ERROR(_port.logger(), "RoboteqCom - checking version FAILED");
         throw std::runtime_error("RoboteqCom - checking version FAILED ");
     }
 
-    if( _event.Type() == IRoboteqEvent::eReal )
+    if( _engine != 0L )
+    {
+        // Engine thread reads for us
+        _engine->Add(_port, _event, this);
+        SERIAL_LOG_INFO(_port.logger(), "RoboteqCom - attached to engine");
+    }
+    else if( _event.Type() == IRoboteqEvent::eReal )
     {
         // Running in threading mode
         _thread.Start();
-        _port.logLine("RoboteqCom - reader started");
+        SERIAL_LOG_INFO(_port.logger(), "RoboteqCom - reader started");
+    }
+
+    if( _commands != 0L )
+    {
+        _writerStop = false;
+        _writerThread.Start();
     }
 }
 
 void    RoboteqCom::Close(void)
 {
+    // Queued commands go out before anything else is torn down
+    StopWriter();
+
+    // Engine must forget the port before fd goes away
+    if( _engine != 0L )
+        _engine->Remove(_port);
+
     _mtx.Lock();
-    if( _port.isOpen() )
-        _port.disconnect();
+    if( _port.isOpen() && _batch.empty() == false )
+        FlushLocked();
+
+    // Stale motor commands are not worth sending on the way out
+    if( _setpointsPending != 0 )
+    {
+        _setpointStats.dropped += _setpointsPending;
+        _setpointsPending = 0;
+        memset(_setpoints, 0, sizeof(_setpoints));
+    }
+
+    // Safety commands still go out. Rest of scheduler queues is dropped
+    while( _port.isOpen() && _queues[ePriority_Safety].empty() == false )
+        SendQueuedLocked(ePriority_Safety, SerialClock::NowNs());
+
+    for( int cls(ePriority_Safety); cls < ePriority_Count; cls++ )
+    {
+        _classStats[cls].dropped += _queues[cls].size();
+        _queues[cls].clear();
+    }
+
+    _queued = 0;
     _mtx.UnLock();
 
-    if( _event.Type() == IRoboteqEvent::eReal )
+    // Reader leaves its poll through stop signal. fd is closed only
+    // after it is gone so it never reads a closed or reused fd
+    if( _engine == 0L && _event.Type() == IRoboteqEvent::eReal )
     {
-        _port.logLine("RoboteqCom - joining reader");
+        SERIAL_LOG_INFO(_port.logger(), "RoboteqCom - joining reader");
+        _port.interrupt();
         _thread.Join();
-        _port.logLine("RoboteqCom - joining reader done");
+        SERIAL_LOG_INFO(_port.logger(), "RoboteqCom - joining reader done");
     }
+
+    _mtx.Lock();
+    if( _port.isOpen() )
+        _port.disconnect();
+    _mtx.UnLock();
+
+    // Nobody left to answer them
+    FailQueries();
+    FailAcks();
+}
+
+bool    RoboteqCom::IsThreadRunning(void) const
+{
+    if( _engine != 0L )
+        return _engine->IsRunning() && _port.isOpen();
+
+    return _thread.IsRunning();
 }
 
 int     RoboteqCom::IssueCommand(const char* buffer, int size)
 {
-    return IssueCommand( string(buffer, size) );
+    if( _schedEnabled && IsThreadRunning() )
+        return IssueCommand( string(buffer, size) );
+
+    RoboteqCmdLine line;
+
+    line.Append(buffer, size);
+
+    return IssueCommand(line);
 }
 
 int     RoboteqCom::IssueCommand(const string&  command,
                                  const string&  args)
 {
-    if( _thread.IsRunning() )
+    if( _schedEnabled && IsThreadRunning() )
+        return Enqueue(Classify(command), command, args);
+
+    RoboteqCmdLine line;
+
+    line.Append(command);
+
+    if( args.empty() == false )
+        line.Append(' ').Append(args);
+
+    return IssueCommand(line);
+}
+
+int     RoboteqCom::IssueCommand(RoboteqCmdLine& line)
+{
+    if( line.Overflow() )
+        THROW_INVALID_ARG("RoboteqCom - command line over " << RoboteqCmdLine::MAX_LINE << " bytes");
+
+    // Scheduler queues own their lines
+    if( _schedEnabled && IsThreadRunning() )
     {
-        //RoboScopedMutex lock(_mtx);
-	
-        if(args == "")
-            return _port.write(command + ROBO_TERMINATOR);
-        else
-            return _port.write(command + " " + args + ROBO_TERMINATOR);
+        string command = line.Str();
+        return Enqueue(Classify(command), command, "");
     }
-    else
+
+    if( _batchWindowNs != 0 && IsThreadRunning() )
+        return Batch(line.Data(), line.Size());
+
+    if( _commands != 0L && _writerThread.IsRunning() )
     {
-        if(args == "")
-            return _port.write(command + ROBO_TERMINATOR);
-        else
-            return _port.write(command + " " + args + ROBO_TERMINATOR);
+        if( SubmitLine(line, 0L) == 0 )
+            return -1;
+
+        return line.Size();
     }
+
+    RoboScopedMutex lock(_mtx);
+
+    line.Terminate();
+
+    return WriteLocked(line.Data(), line.Size());
 }
 
-int    RoboteqCom::ReadReply(string& reply)
+int     RoboteqCom::IssueCommand(ePriority      priority,
+                                 const string&  command,
+                                 const string&  args)
 {
-    reply.clear();
+    if( priority < ePriority_Safety || priority >= ePriority_Count )
+        THROW_INVALID_ARG("RoboteqCom - invalid priority " << priority);
 
-    if( _port.Canonical() == SerialPort::eCanonical_Enable )
+    if( _schedEnabled && IsThreadRunning() )
+        return Enqueue(priority, command, args);
+
+    return IssueCommand(command, args);
+}
+
+RoboteqCom::ePriority RoboteqCom::Classify(const string& command)
+{
+    string::size_type Idx(0);
+
+    // Skip CAN "@NN" address
+    if( command.size() > 3 && command[0] == '@' )
+        Idx = 3;
+
+    if( Idx >= command.size() )
+        return ePriority_Config;
+
+    switch( command[Idx] )
     {
-        char buf[ROBO_MSG_MAX + 1];
-        int  countRcv(0);
+        case '!':
+            if( command.compare(Idx, 3, "!EX") == 0 ||
+                command.compare(Idx, 3, "!MG") == 0 ||
+                command.compare(Idx, 3, "!MS") == 0 )
+                return ePriority_Safety;
 
-        if( (countRcv = _port.read(buf, ROBO_MSG_MAX)) <= 0 )
-            return 0;
+            return ePriority_Motion;
 
-        buf[countRcv] = 0;
-        reply.append(buf, countRcv);
+        case '?':
+        case '#':
+            return ePriority_Query;
 
-        return reply.length();
+        default:
+            return ePriority_Config;
+    }
+}
+
+void    RoboteqCom::SetScheduler(bool enable, unsigned int slackUs)
+{
+    RoboScopedMutex lock(_mtx);
+
+    _schedSlackNs = (uint64_t)slackUs * 1000;
+    _schedEnabled = enable;
+
+    if( enable )
+        EnableTimedService();
+    else if( _port.isOpen() )
+    {
+        // Nothing may stay stranded in queues
+        while( _queued != 0 )
+        {
+            for( int cls(ePriority_Safety); cls < ePriority_Count; cls++ )
+            {
+                if( _queues[cls].empty() == false )
+                {
+                    SendQueuedLocked((ePriority)cls, SerialClock::NowNs());
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void    RoboteqCom::GetSchedulerStats(SchedulerStats& stats)
+{
+    RoboScopedMutex lock(_mtx);
+
+    memcpy(stats.classes, _classStats, sizeof(_classStats));
+    stats.bytesPerSec = _port.baudRate() / _port.bitsPerChar();
+}
+
+void    RoboteqCom::ResetSchedulerStats(void)
+{
+    RoboScopedMutex lock(_mtx);
+    memset(_classStats, 0, sizeof(_classStats));
+}
+
+void    RoboteqCom::SetWriter(unsigned int slots)
+{
+    if( _writerThread.IsRunning() )
+        THROW_RUNTIME_ERROR("RoboteqCom - set writer before Open");
+
+    delete _commands;
+    _commands = 0L;
+
+    if( _writerWake != -1 )
+    {
+        ::close(_writerWake);
+        _writerWake = -1;
+    }
+
+    if( slots == 0 )
+        return;
+
+    _writerWake = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if( _writerWake == -1 )
+        THROW_RUNTIME_ERROR("RoboteqCom - writer eventfd failed. errno " << errno);
+
+    _commands = new RoboteqCmdQueue(slots);
+}
+
+uint64_t RoboteqCom::Submit(const string& command, const string& args, ICommandDone* pDone)
+{
+    if( _commands == 0L || _writerThread.IsRunning() == false )
+        return 0;
+
+    RoboteqCmdLine line;
+
+    line.Append(command);
+
+    if( args.empty() == false )
+        line.Append(' ').Append(args);
+
+    return SubmitLine(line, pDone);
+}
+
+// Writer queue must exist. Terminates line
+uint64_t RoboteqCom::SubmitLine(RoboteqCmdLine& line, ICommandDone* pDone)
+{
+    line.Terminate();
+
+    if( line.Overflow() || line.Size() > ROBO_CMDQ_SLOT_BYTES )
+    {
+        _writerRejected.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+
+    uint64_t ticket = _commands->Push(line.Data(), line.Size(), pDone);
+
+    if( ticket == 0 )
+    {
+        _writerRejected.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+
+    _writerSubmitted.fetch_add(1, std::memory_order_relaxed);
+
+    unsigned int depth = _commands->Size();
+
+    if( depth > _writerMaxDepth.load(std::memory_order_relaxed) )
+        _writerMaxDepth.store(depth, std::memory_order_relaxed);
+
+    // Only pay for wake up syscall when writer is parked. Fence pairs
+    // with one in WriterRun: push above is seen by writer's recheck or
+    // writer's idle flag is seen here (push CAS is relaxed)
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if( _writerIdle.exchange(false) )
+    {
+        uint64_t one(1);
+        ssize_t  ret = ::write(_writerWake, &one, sizeof(one));
+        (void)ret;
+    }
+
+    return ticket;
+}
+
+void    RoboteqCom::GetWriterStats(WriterStats& stats) const
+{
+    stats.submitted = _writerSubmitted.load(std::memory_order_relaxed);
+    stats.rejected  = _writerRejected.load(std::memory_order_relaxed);
+    stats.maxDepth  = _writerMaxDepth.load(std::memory_order_relaxed);
+    stats.written   = _writerWritten.load(std::memory_order_relaxed);
+    stats.failed    = _writerFailed.load(std::memory_order_relaxed);
+    stats.writes    = _writerWrites.load(std::memory_order_relaxed);
+}
+
+// Writer thread. Everything queued (up to buffer and batch limits)
+// goes out in one write
+unsigned int RoboteqCom::DrainCommands(void)
+{
+    const char*     pData;
+    unsigned int    len;
+    ICommandDone*   pDone;
+    uint64_t        ticket;
+    unsigned int    used(0);
+    unsigned int    count(0);
+
+    while( count < ROBO_WRITER_BATCH &&
+           _commands->Peek(pData, len, pDone, ticket) &&
+           used + len <= sizeof(_writerBuf) )
+    {
+        memcpy(_writerBuf + used, pData, len);
+        used += len;
+
+        _writerDone[count].pDone  = pDone;
+        _writerDone[count].ticket = ticket;
+        _writerDone[count].length = len;
+        ++count;
+
+        _commands->Release();
+    }
+
+    if( count == 0 )
+        return 0;
+
+    int ret(-1);
+
+    {
+        RoboScopedMutex lock(_mtx);
+
+        if( _port.isOpen() )
+            ret = WriteLocked(_writerBuf, used);
     }
+
+    _writerWrites.fetch_add(1, std::memory_order_relaxed);
+
+    if( ret > 0 )
+        _writerWritten.fetch_add(count, std::memory_order_relaxed);
     else
+        _writerFailed.fetch_add(count, std::memory_order_relaxed);
+
+    for( unsigned int Idx(0); Idx < count; Idx++ )
     {
-        char byte;
+        if( _writerDone[Idx].pDone != 0L )
+            _writerDone[Idx].pDone->OnCommandDone(_writerDone[Idx].ticket,
+                                                  ret > 0 ? (int)_writerDone[Idx].length : -1);
+    }
+
+    return count;
+}
+
+void    RoboteqCom::WriterRun(void)
+{
+    SERIAL_LOG_INFO(_port.logger(), "RoboteqCom - writer running");
+
+    pollfd  pfd;
 
-        while(true)
+    pfd.fd     = _writerWake;
+    pfd.events = POLLIN;
+
+    try
+    {
+        while( true )
         {
-            if( _port.read(&byte, 1) <= 0 )
+            if( DrainCommands() != 0 )
+                continue;
+
+            if( _writerStop )
                 break;
 
-            if( byte == ROBO_TERMINATOR )
+            // Park. Producer that sees idle flag signals eventfd.
+            // Recheck after raising flag so a push racing with it
+            // is not missed
+            _writerIdle.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if( _commands->Size() != 0 || _writerStop )
             {
-                if( reply.size() == 0 )
-                    continue;
+                _writerIdle.store(false);
+                continue;
+            }
 
-                return reply.length();
-            } 
+            pfd.revents = 0;
 
-            reply.append(&byte, 1);
-        }
+            if( ::poll(&pfd, 1, -1) > 0 )
+            {
+                uint64_t count;
+                ssize_t  ret = ::read(_writerWake, &count, sizeof(count));
+                (void)ret;
+            }
 
-        return 0;
+            _writerIdle.store(false);
+        }
+    }
+    catch(...)
+    {
+        SERIAL_LOG_ERROR(_port.logger(), "RoboteqCom - writer exiting EXCEPTION");
     }
+
+    SERIAL_LOG_INFO(_port.logger(), "RoboteqCom - writer exiting");
 }
 
-bool    RoboteqCom::Synchronize(void)
+// Writer sends what is queued, then exits. Lines pushed after
+// that fail with -1
+void    RoboteqCom::StopWriter(void)
 {
-    char byte;
+    if( _writerThread.IsRunning() == false )
+        return;
+
+    _writerStop = true;
+
+    uint64_t one(1);
+    ssize_t  ret = ::write(_writerWake, &one, sizeof(one));
+    (void)ret;
+
+    _writerThread.Join();
 
-    while(true)
+    const char*     pData;
+    unsigned int    len;
+    ICommandDone*   pDone;
+    uint64_t        ticket;
+
+    while( _commands->Peek(pData, len, pDone, ticket) )
     {
-        if( _port.read(&byte, 1) <= 0 )
-            break;
+        _commands->Release();
+        _writerFailed.fetch_add(1, std::memory_order_relaxed);
 
-        if( byte == '+' )
-            return true;
+        if( pDone != 0L )
+            pDone->OnCommandDone(ticket, -1);
     }
+}
+
+// Reply names for numeric query keys
+static const char* QueryAlias(const char* pKey, unsigned int len)
+{
+    if( len == 3 && memcmp(pKey, "$1E", 3) == 0 )
+        return "FID";
 
-    return false;
+    if( len == 3 && memcmp(pKey, "$1F", 3) == 0 )
+        return "TRN";
+
+    return 0L;
 }
 
-// This methods runs on seperate thread
-void    RoboteqCom::Run(void)
+bool    RoboteqCom::Query(RoboteqQuery& query, const string& command,
+                          unsigned int timeoutMs, IQueryDone* pDone)
 {
-    string buffer;
+    if( query.Status() == RoboteqQuery::eStatus_Pending )
+        THROW_INVALID_ARG("RoboteqCom - query already pending: " << command);
 
-    try
+    // Engine dispatches replies straight to listener, none reach MatchQuery
+    if( _engine != 0L )
+        THROW_RUNTIME_ERROR("RoboteqCom - queries not supported with RoboteqEngine");
+
+    const char*  pCmd = command.c_str();
+    unsigned int size = command.size();
+    unsigned int Idx(0);
+    unsigned int node(0);
+
+    // CAN "@NN" address
+    if( size > 3 && pCmd[0] == '@' )
+    {
+        if( isdigit((unsigned char)pCmd[1]) == 0 || isdigit((unsigned char)pCmd[2]) == 0 )
+            THROW_INVALID_ARG("RoboteqCom - bad CAN address: " << command);
+
+        node = (pCmd[1] - '0') * 10 + (pCmd[2] - '0');
+        Idx  = 3;
+    }
+
+    if( Idx >= size || pCmd[Idx] != '?' )
+        THROW_INVALID_ARG("RoboteqCom - not a query: " << command);
+
+    const char*  pKey = pCmd + Idx + 1;
+    const char*  pEnd = (const char*)memchr(pKey, ' ', pCmd + size - pKey);
+    unsigned int keyLen = (pEnd != 0L ? pEnd : pCmd + size) - pKey;
+
+    if( keyLen == 0 )
+        THROW_INVALID_ARG("RoboteqCom - query without key: " << command);
+
+    if( pKey[0] == '$' )
+    {
+        pKey = QueryAlias(pKey, keyLen);
+
+        if( pKey == 0L )
+            THROW_INVALID_ARG("RoboteqCom - use named query instead of " << command);
+
+        keyLen = strlen(pKey);
+    }
+
+    if( keyLen > RoboteqQuery::MAX_KEY_LEN )
+        THROW_INVALID_ARG("RoboteqCom - query key too long: " << command);
+
+    memcpy(query._key, pKey, keyLen);
+    query._keyLen = keyLen;
+
+    uint64_t now = SerialClock::NowNs();
+
+    query._node       = node;
+    query._reply.clear();
+    query._status     = RoboteqQuery::eStatus_Pending;
+    query._finished   = false;
+    query._sentNs     = now;
+    query._deadlineNs = now + (uint64_t)timeoutMs * 1000000;
+    query._latencyNs  = 0;
+    query._pDone      = pDone;
+    query._pCom       = this;
+    query._pNext      = 0L;
+
+    if( _thread.IsRunning() == false )
+    {
+        SERIAL_LOG_WARN(_port.logger(), "RoboteqCom - query " << command << " failed, reader not running");
+        query.Complete(RoboteqQuery::eStatus_Failed);
+        return false;
+    }
+
+    {
+        RoboScopedMutex lock(_queryMtx);
+
+        if( _queryTail != 0L )
+            _queryTail->_pNext = &query;
+        else
+            _queryHead = &query;
+
+        _queryTail = &query;
+        ++_queryCount;
+    }
+
+    // Reader has to wake up for timeouts
+    EnableTimedService();
+
+    if( IssueCommand(ePriority_Query, command) <= 0 )
+    {
+        Cancel(query);
+        return false;
+    }
+
+    return true;
+}
+
+bool    RoboteqCom::Cancel(RoboteqQuery& query)
+{
     {
-        while( _port.isOpen() )
+        RoboScopedMutex lock(_queryMtx);
+
+        RoboteqQuery* pPrev(0L);
+        RoboteqQuery* pCur(_queryHead);
+
+        while( pCur != 0L && pCur != &query )
         {
-            if( ReadReply(buffer) > 0 && buffer.size() > 0 )
-            {
-                if(buffer[0] != '+')
-                {
-                    IEventArgs evt( buffer);
-                    _event.OnMsgEvent( evt );
+            pPrev = pCur;
+            pCur  = pCur->_pNext;
+        }
+
+        if( pCur == 0L )
+            return false;
+
+        if( pPrev != 0L )
+            pPrev->_pNext = pCur->_pNext;
+        else
+            _queryHead = pCur->_pNext;
+
+        if( _queryTail == pCur )
+            _queryTail = pPrev;
+
+        --_queryCount;
+    }
+
+    query.Complete(RoboteqQuery::eStatus_Failed);
+
+    return true;
+}
+
+// Reader thread. true when reply belonged to a pending query
+bool    RoboteqCom::MatchQuery(const string& reply)
+{
+    const char*  pCur = reply.c_str();
+    const char*  pEnd = pCur + reply.size();
+    unsigned int node(0);
+
+    if( *pCur == '@' && pEnd - pCur > 3 )
+    {
+        node  = (pCur[1] - '0') * 10 + (pCur[2] - '0');
+        pCur += 3;
+
+        while( pCur < pEnd && *pCur == ' ' )
+            ++pCur;
+    }
+    else if( isalpha( (unsigned char)*pCur ) == 0 )
+        ++pCur;     // Echo byte
+
+    const char* pEq = (const char*)memchr(pCur, '=', pEnd - pCur);
+
+    if( pEq == 0L || pEq == pCur )
+        return false;
+
+    unsigned int  keyLen = pEq - pCur;
+    RoboteqQuery* pFound(0L);
+
+    {
+        RoboScopedMutex lock(_queryMtx);
+
+        RoboteqQuery* pPrev(0L);
+        RoboteqQuery* pQuery(_queryHead);
+
+        while( pQuery != 0L )
+        {
+            if( pQuery->_node == node &&
+                pQuery->_keyLen == keyLen &&
+                memcmp(pQuery->_key, pCur, keyLen) == 0 )
+                break;
+
+            pPrev  = pQuery;
+            pQuery = pQuery->_pNext;
+        }
+
+        if( pQuery == 0L )
+            return false;
+
+        if( pPrev != 0L )
+            pPrev->_pNext = pQuery->_pNext;
+        else
+            _queryHead = pQuery->_pNext;
+
+        if( _queryTail == pQuery )
+            _queryTail = pPrev;
+
+        --_queryCount;
+        pFound = pQuery;
+    }
+
+    pFound->_reply.assign(pCur, pEnd - pCur);
+    pFound->_latencyNs = SerialClock::NowNs() - pFound->_sentNs;
+    _latency[eLatency_Query].Record(pFound->_latencyNs);
+    pFound->Complete(RoboteqQuery::eStatus_Done);
+
+    return true;
+}
+
+// Reader thread
+void    RoboteqCom::ExpireQueries(uint64_t now)
+{
+    if( _queryCount.load() == 0 )
+        return;
+
+    RoboteqQuery* pExpired(0L);
+
+    {
+        RoboScopedMutex lock(_queryMtx);
+
+        RoboteqQuery* pPrev(0L);
+        RoboteqQuery* pQuery(_queryHead);
+
+        while( pQuery != 0L )
+        {
+            RoboteqQuery* pNext = pQuery->_pNext;
+
+            if( pQuery->_deadlineNs <= now )
+            {
+                if( pPrev != 0L )
+                    pPrev->_pNext = pNext;
+                else
+                    _queryHead = pNext;
+
+                if( _queryTail == pQuery )
+                    _queryTail = pPrev;
+
+                --_queryCount;
+
+                pQuery->_pNext = pExpired;
+                pExpired = pQuery;
+            }
+            else
+                pPrev = pQuery;
+
+            pQuery = pNext;
+        }
+    }
+
+    while( pExpired != 0L )
+    {
+        RoboteqQuery* pNext = pExpired->_pNext;
+
+        pExpired->_latencyNs = now - pExpired->_sentNs;
+        pExpired->Complete(RoboteqQuery::eStatus_Timeout);
+        pExpired = pNext;
+    }
+}
+
+void    RoboteqCom::FailQueries(void)
+{
+    RoboteqQuery* pQuery;
+
+    {
+        RoboScopedMutex lock(_queryMtx);
+
+        pQuery     = _queryHead;
+        _queryHead = 0L;
+        _queryTail = 0L;
+        _queryCount.store(0);
+    }
+
+    while( pQuery != 0L )
+    {
+        RoboteqQuery* pNext = pQuery->_pNext;
+
+        pQuery->Complete(RoboteqQuery::eStatus_Failed);
+        pQuery = pNext;
+    }
+}
+
+// Earliest query deadline. 0 if none pending
+uint64_t RoboteqCom::QueryDueNs(void)
+{
+    if( _queryCount.load() == 0 )
+        return 0;
+
+    RoboScopedMutex lock(_queryMtx);
+
+    uint64_t due(0);
+
+    for( RoboteqQuery* pQuery(_queryHead); pQuery != 0L; pQuery = pQuery->_pNext )
+    {
+        if( due == 0 || pQuery->_deadlineNs < due )
+            due = pQuery->_deadlineNs;
+    }
+
+    return due;
+}
+
+void    RoboteqCom::SetAckTracking(bool enable, unsigned int timeoutMs)
+{
+    // Engine drops "+" / "-" before they could be paired
+    if( enable && _engine != 0L )
+        THROW_RUNTIME_ERROR("RoboteqCom - ack tracking not supported with RoboteqEngine");
+
+    if( enable == false )
+        FailAcks();
+
+    RoboScopedMutex lock(_mtx);
+
+    _ackTimeoutNs = (uint64_t)timeoutMs * 1000000;
+    _ackHead      = 0;
+    _ackCount     = 0;
+    _ackEnabled   = enable;
+
+    // Reader has to wake up for lost answers
+    if( enable )
+        EnableTimedService();
+}
+
+bool    RoboteqCom::IsIdempotent(const string& command)
+{
+    string::size_type Idx(0);
+
+    if( command.size() > 3 && command[0] == '@' )
+        Idx = 3;
+
+    if( Idx >= command.size() || command[Idx] == '%' )
+        return false;
+
+    // "!R" restarts MicroBasic script
+    if( command.compare(Idx, 2, "!R") == 0 &&
+        (command.size() == Idx + 2 || command[Idx + 2] == ' ') )
+        return false;
+
+    return true;
+}
+
+bool    RoboteqCom::IssueTracked(RoboteqAck& ack, const string& command, const string& args,
+                                 unsigned int timeoutMs, unsigned int retries, IAckDone* pDone)
+{
+    if( ack.Status() == RoboteqAck::eStatus_Pending )
+        THROW_INVALID_ARG("RoboteqCom - ack already pending: " << command);
+
+    ack._line = command;
+
+    if( args.empty() == false )
+    {
+        ack._line += ' ';
+        ack._line += args;
+    }
+
+    ack._line     += ROBO_TERMINATOR;
+    ack._status    = RoboteqAck::eStatus_Pending;
+    ack._finished  = false;
+    ack._timeoutMs = timeoutMs;
+    ack._retries   = IsIdempotent(command) ? retries : 0;
+    ack._attempts  = 1;
+    ack._latencyNs = 0;
+    ack._pDone     = pDone;
+    ack._pCom      = this;
+    ack._pNext     = 0L;
+
+    int ret(-1);
+
+    if( _ackEnabled && _thread.IsRunning() )
+    {
+        RoboScopedMutex lock(_mtx);
+
+        if( _port.isOpen() )
+        {
+            _ackNext = &ack;
+            ret = WriteLocked(ack._line);
+
+            // Write failed or line carried no "!", "^" or "%" command
+            if( _ackNext != 0L )
+            {
+                _ackNext = 0L;
+                ret      = -1;
+            }
+        }
+    }
+
+    if( ret <= 0 )
+    {
+        ack.Complete(RoboteqAck::eStatus_Failed);
+        return false;
+    }
+
+    return true;
+}
+
+bool    RoboteqCom::Cancel(RoboteqAck& ack)
+{
+    {
+        RoboScopedMutex lock(_mtx);
+
+        unsigned int Idx(0);
+
+        for( ; Idx < _ackCount; Idx++ )
+        {
+            AckEntry& entry = _ackWindow[(_ackHead + Idx) % ROBO_ACK_WINDOW];
+
+            // Slot stays so following answers still line up
+            if( entry.pAck == &ack )
+            {
+                entry.pAck = 0L;
+                break;
+            }
+        }
+
+        if( Idx == _ackCount )
+        {
+            // Pushed out of full window, waiting for ExpireAcks
+            RoboteqAck* pPrev(0L);
+            RoboteqAck* pCur(_ackOrphans);
+
+            while( pCur != 0L && pCur != &ack )
+            {
+                pPrev = pCur;
+                pCur  = pCur->_pNext;
+            }
+
+            if( pCur == 0L )
+                return false;
+
+            if( pPrev != 0L )
+                pPrev->_pNext = pCur->_pNext;
+            else
+                _ackOrphans = pCur->_pNext;
+        }
+    }
+
+    ack.Complete(RoboteqAck::eStatus_Failed);
+
+    return true;
+}
+
+unsigned int RoboteqCom::GetAckStats(AckTypeStats* pStats, unsigned int maxCount)
+{
+    RoboScopedMutex lock(_mtx);
+
+    unsigned int count = _ackTypeCount < maxCount ? _ackTypeCount : maxCount;
+
+    memcpy(pStats, _ackTypes, count * sizeof(AckTypeStats));
+
+    return count;
+}
+
+void    RoboteqCom::ResetAckStats(void)
+{
+    RoboScopedMutex lock(_mtx);
+
+    memset(_ackTypes, 0, sizeof(_ackTypes));
+    _ackTypeCount = 0;
+}
+
+void    RoboteqCom::GetLatency(eLatency which, RoboteqHistogram::Snapshot& snap) const
+{
+    if( which >= eLatency_Count )
+        THROW_INVALID_ARG("RoboteqCom - invalid histogram " << which);
+
+    _latency[which].GetSnapshot(snap);
+}
+
+void    RoboteqCom::ResetLatency(eLatency which)
+{
+    if( which >= eLatency_Count )
+        THROW_INVALID_ARG("RoboteqCom - invalid histogram " << which);
+
+    _latency[which].Reset();
+}
+
+// _mtx must be held. Last slot collects names once table is full
+unsigned int RoboteqCom::AckTypeLocked(const char* pName, unsigned int len)
+{
+    if( len >= sizeof(_ackTypes[0].name) )
+        len = sizeof(_ackTypes[0].name) - 1;
+
+    for( unsigned int Idx(0); Idx < _ackTypeCount; Idx++ )
+    {
+        if( strncmp(_ackTypes[Idx].name, pName, len) == 0 && _ackTypes[Idx].name[len] == 0 )
+            return Idx;
+    }
+
+    if( _ackTypeCount == ROBO_ACK_TYPES )
+        return ROBO_ACK_TYPES - 1;
+
+    AckTypeStats& type = _ackTypes[_ackTypeCount];
+
+    memset(&type, 0, sizeof(type));
+
+    if( _ackTypeCount == ROBO_ACK_TYPES - 1 )
+        strcpy(type.name, "*");
+    else
+        memcpy(type.name, pName, len);
+
+    return _ackTypeCount++;
+}
+
+// _mtx must be held. One window entry per answer producing
+// command on line, in order controller will answer them
+void    RoboteqCom::TrackLineLocked(const char* pLine, unsigned int len, uint64_t now)
+{
+    const char* pCur = pLine;
+    const char* pEnd = pLine + len;
+
+    while( pCur < pEnd )
+    {
+        const char* pCmd = pCur;
+
+        // Skip CAN "@NN" address
+        if( *pCmd == '@' && pEnd - pCmd > 3 )
+            pCmd += 3;
+
+        const char* pNameEnd = pCmd;
+
+        while( pNameEnd < pEnd && *pNameEnd != ' ' && *pNameEnd != ROBO_CMD_SEPARATOR &&
+               *pNameEnd != ROBO_TERMINATOR )
+            ++pNameEnd;
+
+        if( pCmd < pEnd && (*pCmd == '!' || *pCmd == '^' || *pCmd == '%') )
+        {
+            if( _ackCount == ROBO_ACK_WINDOW )
+            {
+                // Controller is not answering. Oldest counts as lost
+                AckEntry& old = _ackWindow[_ackHead];
+
+                _ackTypes[old.type].lost++;
+
+                if( old.pAck != 0L )
+                {
+                    old.pAck->_pNext = _ackOrphans;
+                    _ackOrphans = old.pAck;
+                }
+
+                _ackHead = (_ackHead + 1) % ROBO_ACK_WINDOW;
+                --_ackCount;
+            }
+
+            AckEntry& entry = _ackWindow[(_ackHead + _ackCount) % ROBO_ACK_WINDOW];
+
+            entry.sentNs     = now;
+            entry.pAck       = _ackNext;
+            entry.type       = AckTypeLocked(pCmd, pNameEnd - pCmd);
+            entry.deadlineNs = now + (_ackNext != 0L ? (uint64_t)_ackNext->_timeoutMs * 1000000 : _ackTimeoutNs);
+
+            _ackNext = 0L;
+            ++_ackCount;
+        }
+
+        // Next command
+        while( pNameEnd < pEnd && *pNameEnd != ROBO_CMD_SEPARATOR && *pNameEnd != ROBO_TERMINATOR )
+            ++pNameEnd;
+
+        pCur = pNameEnd + 1;
+    }
+}
+
+// Reader thread. Pairs answer with oldest command in window
+void    RoboteqCom::OnAck(bool accepted)
+{
+    RoboteqAck* pAck(0L);
+
+    {
+        RoboScopedMutex lock(_mtx);
+
+        if( _ackCount == 0 )
+            return;     // Answer to something sent before tracking
+
+        AckEntry&     entry = _ackWindow[_ackHead];
+        AckTypeStats& type  = _ackTypes[entry.type];
+        uint64_t      rtt   = SerialClock::NowNs() - entry.sentNs;
+
+        if( accepted )
+            type.accepted++;
+        else
+            type.rejected++;
+
+        type.totalNs += rtt;
+        _latency[eLatency_Ack].Record(rtt);
+
+        if( rtt > type.maxNs )
+            type.maxNs = rtt;
+
+        pAck = entry.pAck;
+
+        if( pAck != 0L )
+            pAck->_latencyNs = rtt;
+
+        _ackHead = (_ackHead + 1) % ROBO_ACK_WINDOW;
+        --_ackCount;
+    }
+
+    if( pAck != 0L )
+        pAck->Complete(accepted ? RoboteqAck::eStatus_Accepted : RoboteqAck::eStatus_Rejected);
+}
+
+// Reader thread. Oldest command without answer past its deadline
+// is taken as lost. Tracked idempotent ones go out again
+void    RoboteqCom::ExpireAcks(uint64_t now)
+{
+    if( _ackEnabled == false )
+        return;
+
+    RoboteqAck* pLost(0L);
+
+    {
+        RoboScopedMutex lock(_mtx);
+
+        pLost       = _ackOrphans;
+        _ackOrphans = 0L;
+
+        while( _ackCount != 0 && _ackWindow[_ackHead].deadlineNs <= now )
+        {
+            AckEntry    entry = _ackWindow[_ackHead];
+            RoboteqAck* pAck  = entry.pAck;
+
+            _ackTypes[entry.type].lost++;
+            _ackHead = (_ackHead + 1) % ROBO_ACK_WINDOW;
+            --_ackCount;
+
+            if( pAck == 0L )
+                continue;
+
+            if( pAck->_retries != 0 && _port.isOpen() )
+            {
+                pAck->_retries--;
+                pAck->_attempts++;
+                _ackTypes[entry.type].retransmits++;
+
+                _ackNext = pAck;
+                WriteLocked(pAck->_line);
+
+                if( _ackNext == 0L )
+                    continue;   // Back in window
+
+                _ackNext = 0L;
+            }
+
+            pAck->_latencyNs = now - entry.sentNs;
+            pAck->_pNext = pLost;
+            pLost = pAck;
+        }
+    }
+
+    while( pLost != 0L )
+    {
+        RoboteqAck* pNext = pLost->_pNext;
+
+        pLost->Complete(RoboteqAck::eStatus_Timeout);
+        pLost = pNext;
+    }
+}
+
+void    RoboteqCom::FailAcks(void)
+{
+    RoboteqAck* pFailed(0L);
+
+    {
+        RoboScopedMutex lock(_mtx);
+
+        pFailed     = _ackOrphans;
+        _ackOrphans = 0L;
+
+        for( ; _ackCount != 0; --_ackCount )
+        {
+            RoboteqAck* pAck = _ackWindow[_ackHead].pAck;
+
+            _ackHead = (_ackHead + 1) % ROBO_ACK_WINDOW;
+
+            if( pAck != 0L )
+            {
+                pAck->_pNext = pFailed;
+                pFailed = pAck;
+            }
+        }
+    }
+
+    while( pFailed != 0L )
+    {
+        RoboteqAck* pNext = pFailed->_pNext;
+
+        pFailed->Complete(RoboteqAck::eStatus_Failed);
+        pFailed = pNext;
+    }
+}
+
+void    RoboteqCom::SetReplyQueue(unsigned int slots)
+{
+    if( IsThreadRunning() )
+        THROW_RUNTIME_ERROR("RoboteqCom - set reply queue before Open");
+
+    if( _engine != 0L )
+        THROW_RUNTIME_ERROR("RoboteqCom - reply queue not supported with RoboteqEngine");
+
+    delete _replies;
+    _replies = 0L;
+
+    if( slots != 0 )
+        _replies = new RoboteqReplyRing(slots, ROBO_MSG_MAX);
+}
+
+// Consumer thread only
+unsigned int RoboteqCom::DrainReplies(unsigned int maxCount)
+{
+    if( _replies == 0L )
+        return 0;
+
+    const char*  pData;
+    unsigned int len;
+    RxStamp      stamp;
+    unsigned int count(0);
+
+    while( count < maxCount && _replies->Peek(pData, len, stamp) )
+    {
+        {
+            IEventArgs evt(pData, len, stamp);
+            _event.OnMsgEvent( evt );
+        }
+
+        _replies->Release();
+        ++count;
+    }
+
+    return count;
+}
+
+bool    RoboteqCom::GetReplyQueueStats(RoboteqReplyRing::Stats& stats) const
+{
+    if( _replies == 0L )
+        return false;
+
+    _replies->GetStats(stats);
+    return true;
+}
+
+int     RoboteqCom::Enqueue(ePriority priority, const string& command, const string& args)
+{
+    RoboScopedMutex lock(_mtx);
+
+    Queued item;
+
+    item.line = command;
+
+    if( args.empty() == false )
+    {
+        item.line += ' ';
+        item.line += args;
+    }
+
+    item.enqueuedNs = SerialClock::NowNs();
+
+    TQueue& queue = _queues[priority];
+
+    queue.push_back(item);
+    ++_queued;
+
+    if( queue.size() > _classStats[priority].maxDepth )
+        _classStats[priority].maxDepth = queue.size();
+
+    PumpLocked();
+
+    return item.line.size() + 1;
+}
+
+// _mtx must be held. Writes while modeled backlog is under slack.
+// Setpoint slots rank right after safety class
+void    RoboteqCom::PumpLocked(void)
+{
+    uint64_t now = SerialClock::NowNs();
+
+    while( _port.isOpen() && _txBusyUntilNs <= now + _schedSlackNs )
+    {
+        if( _queues[ePriority_Safety].empty() == false )
+            SendQueuedLocked(ePriority_Safety, now);
+        else if( _setpointsPending != 0 )
+            FlushSetpointsLocked();
+        else
+        {
+            int cls(ePriority_Motion);
+
+            while( cls < ePriority_Count && _queues[cls].empty() )
+                ++cls;
+
+            if( cls == ePriority_Count )
+                break;
+
+            SendQueuedLocked((ePriority)cls, now);
+        }
+
+        now = SerialClock::NowNs();
+    }
+}
+
+// _mtx must be held. With batching on, following lines
+// of same class ride along up to batch byte budget
+void    RoboteqCom::SendQueuedLocked(ePriority priority, uint64_t now)
+{
+    TQueue&     queue = _queues[priority];
+    ClassStats& stats = _classStats[priority];
+
+    _schedLine.clear();
+
+    do
+    {
+        const Queued& item  = queue.front();
+        uint64_t      delay = now - item.enqueuedNs;
+
+        if( _schedLine.empty() == false )
+            _schedLine += ROBO_CMD_SEPARATOR;
+
+        _schedLine += item.line;
+
+        stats.sent++;
+        stats.totalDelayNs += delay;
+        _latency[eLatency_Queue].Record(delay);
+
+        if( delay > stats.maxDelayNs )
+            stats.maxDelayNs = delay;
+
+        queue.pop_front();
+        --_queued;
+    }
+    while( _batchWindowNs != 0 && queue.empty() == false &&
+           _schedLine.size() + 1 + queue.front().line.size() + 1 <= _batchMaxBytes );
+
+    _schedLine += ROBO_TERMINATOR;
+
+    WriteLocked(_schedLine);
+}
+
+void    RoboteqCom::SetBatching(unsigned int windowUs, unsigned int maxBytes)
+{
+    RoboScopedMutex lock(_mtx);
+
+    if( _batch.empty() == false && _port.isOpen() )
+        FlushLocked();
+
+    _batchWindowNs = (uint64_t)windowUs * 1000;
+    _batchMaxBytes = maxBytes;
+
+    if( windowUs != 0 )
+        EnableTimedService();
+}
+
+int     RoboteqCom::Flush(void)
+{
+    RoboScopedMutex lock(_mtx);
+
+    if( _batch.empty() )
+        return 0;
+
+    return FlushLocked();
+}
+
+void    RoboteqCom::GetBatchStats(BatchStats& stats)
+{
+    RoboScopedMutex lock(_mtx);
+    stats = _batchStats;
+}
+
+void    RoboteqCom::ResetBatchStats(void)
+{
+    RoboScopedMutex lock(_mtx);
+    memset(&_batchStats, 0, sizeof(_batchStats));
+}
+
+int     RoboteqCom::Batch(const char* pLine, unsigned int size)
+{
+    RoboScopedMutex lock(_mtx);
+
+    // Would not fit. Send what we have and start over
+    if( _batch.empty() == false && _batch.size() + 1 + size + 1 > _batchMaxBytes )
+        FlushLocked();
+
+    if( _batch.empty() )
+        _batchStartNs = SerialClock::NowNs();
+    else
+        _batch += ROBO_CMD_SEPARATOR;
+
+    _batch.append(pLine, size);
+
+    ++_batchCount;
+
+    if( _batch.size() + 1 >= _batchMaxBytes ||
+        SerialClock::NowNs() - _batchStartNs >= _batchWindowNs )
+    {
+        if( FlushLocked() <= 0 )
+            return 0;
+    }
+
+    return size + 1;
+}
+
+// _mtx must be held
+int     RoboteqCom::FlushLocked(void)
+{
+    _batch += ROBO_TERMINATOR;
+
+    int ret = WriteLocked(_batch);
+
+    _batchStats.batches++;
+    _batchStats.commands += _batchCount;
+    _batchStats.bytes    += _batch.size();
+    _batchStats.sizes[ _batchCount < ROBO_BATCH_HIST ? _batchCount : ROBO_BATCH_HIST ]++;
+
+    _batch.clear();
+    _batchCount = 0;
+
+    return ret;
+}
+
+void    RoboteqCom::SetMotorSetpoint(unsigned int node, unsigned int channel, int value, bool send)
+{
+    if( node >= ROBO_SP_NODES || channel == 0 || channel >= ROBO_SP_CHANNELS )
+        THROW_INVALID_ARG("RoboteqCom - invalid setpoint node " << node << " channel " << channel);
+
+    RoboScopedMutex lock(_mtx);
+
+    Setpoint& sp = _setpoints[node][channel];
+
+    _setpointStats.submitted++;
+
+    if( sp.pending )
+        _setpointStats.coalesced++;
+    else
+    {
+        sp.pending = true;
+        ++_setpointsPending;
+    }
+
+    sp.value = value;
+    EnableTimedService();
+
+    if( send && _port.isOpen() )
+    {
+        if( _schedEnabled )
+            PumpLocked();
+        else if( LinkBusyLocked( SerialClock::NowNs() ) == false )
+            FlushSetpointsLocked();
+    }
+}
+
+void    RoboteqCom::GetSetpointStats(SetpointStats& stats)
+{
+    RoboScopedMutex lock(_mtx);
+    stats = _setpointStats;
+}
+
+void    RoboteqCom::ResetSetpointStats(void)
+{
+    RoboScopedMutex lock(_mtx);
+    memset(&_setpointStats, 0, sizeof(_setpointStats));
+}
+
+uint64_t RoboteqCom::TxBacklogNs(void)
+{
+    RoboScopedMutex lock(_mtx);
+
+    uint64_t now = SerialClock::NowNs();
+
+    return _txBusyUntilNs > now ? _txBusyUntilNs - now : 0;
+}
+
+// _mtx must be held
+int     RoboteqCom::WriteLocked(const string& line)
+{
+    return WriteLocked(line.data(), line.size());
+}
+
+// _mtx must be held. Every write goes through here
+// so link model sees all bytes
+int     RoboteqCom::WriteLocked(const char* pLine, unsigned int len)
+{
+    // Stalled adapter fails the write instead of holding _mtx forever
+    int ret = _port.writeAll(pLine, len, SerialClock::DeadlineIn(_timeoutMs));
+
+    SERIAL_LOG_DEBUG(_port.logger(), "RoboteqCom - TX " << ret << " " << string(pLine, len));
+
+    if( ret > 0 )
+    {
+        uint64_t now = SerialClock::NowNs();
+
+        if( _ackEnabled )
+            TrackLineLocked(pLine, len, now);
+
+        if( _txBusyUntilNs < now )
+            _txBusyUntilNs = now;
+
+        _txBusyUntilNs += _port.wireTimeNs(ret);
+    }
+
+    return ret;
+}
+
+// _mtx must be held
+bool    RoboteqCom::LinkBusyLocked(uint64_t now)
+{
+    if( _txBusyUntilNs > now )
+        return true;
+
+    // Model says idle. Trust driver if it knows better
+    return _port.pendingOutput() > 0;
+}
+
+// _mtx must be held
+int     RoboteqCom::FlushSetpointsLocked(void)
+{
+    uint64_t mask(0);
+
+    for( unsigned int node(0); node < ROBO_SP_NODES; node++ )
+    {
+        for( unsigned int channel(1); channel < ROBO_SP_CHANNELS; channel++ )
+        {
+            if( _setpoints[node][channel].pending )
+                mask |= 1ULL << (node * ROBO_SP_CHANNELS + channel);
+        }
+    }
+
+    _setpointsPending = 0;
+
+    if( mask == 0 )
+        return 0;
+
+    // cmd_vel fan-out hits same slots every time. Line is compiled
+    // once for them and later flushes only rewrite the digits
+    if( mask != _spTemplateMask )
+    {
+        _spTemplate.Clear();
+
+        for( unsigned int node(0); node < ROBO_SP_NODES; node++ )
+        {
+            for( unsigned int channel(1); channel < ROBO_SP_CHANNELS; channel++ )
+            {
+                if( _setpoints[node][channel].pending )
+                    _spTemplate.Add<RoboteqCmd::Go>(node, channel);
+            }
+        }
+
+        _spTemplateMask = mask;
+    }
+
+    unsigned int slot(0);
+
+    for( unsigned int node(0); node < ROBO_SP_NODES; node++ )
+    {
+        for( unsigned int channel(1); channel < ROBO_SP_CHANNELS; channel++ )
+        {
+            Setpoint& sp = _setpoints[node][channel];
+
+            if( sp.pending == false )
+                continue;
+
+            _spTemplate.Set(slot++, sp.value);
+            sp.pending = false;
+        }
+    }
+
+    unsigned int count = _spTemplate.Count();
+
+    int ret = WriteLocked(_spTemplate.Data(), _spTemplate.Size());
+
+    if( ret > 0 )
+    {
+        _setpointStats.sent += count;
+        _setpointStats.writes++;
+    }
+    else
+        _setpointStats.dropped += count;
+
+    return ret;
+}
+
+// Earliest time reader has something to do. 0 if nothing
+uint64_t RoboteqCom::NextDueNs(void)
+{
+    RoboScopedMutex lock(_mtx);
+
+    uint64_t due(0);
+
+    if( _batch.empty() == false )
+        due = _batchStartNs + _batchWindowNs;
+
+    if( _setpointsPending != 0 && (due == 0 || _txBusyUntilNs < due) )
+        due = _txBusyUntilNs;
+
+    if( _ackCount != 0 && (due == 0 || _ackWindow[_ackHead].deadlineNs < due) )
+        due = _ackWindow[_ackHead].deadlineNs;
+
+    if( _queued != 0 )
+    {
+        uint64_t ready = _txBusyUntilNs > _schedSlackNs ? _txBusyUntilNs - _schedSlackNs : 0;
+
+        if( due == 0 || ready < due )
+            due = ready;
+    }
+
+    return due;
+}
+
+// Reader or engine may be parked in an untimed wait when timed work
+// first shows up. From then on it comes round every ROBO_SERVICE_MS
+void    RoboteqCom::EnableTimedService(void)
+{
+    if( _timedService.exchange(true) )
+        return;
+
+    if( _engine != 0L )
+        _engine->Wake();
+    else if( _port.isOpen() )
+        _port.wake();
+}
+
+// Absolute time reader / engine has to come round by, 0 if nothing is timed
+uint64_t RoboteqCom::ServiceDueNs(void)
+{
+    if( _timedService == false )
+        return 0;
+
+    uint64_t now   = SerialClock::NowNs();
+    uint64_t due   = now + ROBO_SERVICE_MS * 1000000ULL;
+    uint64_t next  = NextDueNs();
+    uint64_t query = QueryDueNs();
+
+    if( next != 0 && next < due )
+        due = next;
+
+    if( query != 0 && query < due )
+        due = query;
+
+    // Driver still draining although model says idle
+    if( due < now + 1000000ULL )
+        due = now + 1000000ULL;
+
+    return due;
+}
+
+// Timed work done by reader or engine thread
+void    RoboteqCom::Service(void)
+{
+    ExpireQueries( SerialClock::NowNs() );
+    ExpireAcks( SerialClock::NowNs() );
+
+    RoboScopedMutex lock(_mtx);
+
+    if( _port.isOpen() == false )
+        return;
+
+    uint64_t now = SerialClock::NowNs();
+
+    if( _batch.empty() == false && now - _batchStartNs >= _batchWindowNs )
+        FlushLocked();
+
+    if( _schedEnabled )
+        PumpLocked();
+    else if( _setpointsPending != 0 && LinkBusyLocked(now) == false )
+        FlushSetpointsLocked();
+}
+
+int    RoboteqCom::ReadReply(string& reply)
+{
+    reply.clear();
+
+    if( _port.Canonical() == SerialPort::eCanonical_Enable )
+    {
+        char buf[ROBO_MSG_MAX + 1];
+        int  countRcv(0);
+
+        if( (countRcv = _port.read(buf, ROBO_MSG_MAX)) <= 0 )
+            return countRcv;
+
+        buf[countRcv] = 0;
+        reply.append(buf, countRcv);
+
+        return reply.length();
+    }
+    else
+        return _port.readFrame(reply, ROBO_TERMINATOR);
+}
+
+int    RoboteqCom::ReadReply(string& reply, const timespec& deadline)
+{
+    reply.clear();
+
+    if( _port.Canonical() == SerialPort::eCanonical_Enable )
+    {
+        char buf[ROBO_MSG_MAX + 1];
+        int  countRcv(0);
+
+        if( (countRcv = _port.read(buf, ROBO_MSG_MAX, deadline)) <= 0 )
+            return countRcv;
+
+        reply.append(buf, countRcv);
+
+        return reply.length();
+    }
+    else
+        return _port.readFrame(reply, ROBO_TERMINATOR, deadline);
+}
+
+bool    RoboteqCom::Synchronize(const timespec& deadline)
+{
+    return _port.skipUntil('+', deadline);
+}
+
+// This methods runs on seperate thread
+void    RoboteqCom::Run(void)
+{
+    string buffer;
+
+    try
+    {
+        while( _port.isOpen() && _port.interrupted() == false )
+        {
+            int len;
+
+            // Wake up in time to flush pending batch and setpoints
+            uint64_t due = ServiceDueNs();
+
+            if( due != 0 )
+            {
+                len = ReadReply(buffer, SerialClock::FromNs(due));
+                Service();
+            }
+            else
+                len = ReadReply(buffer);
+
+            // Link gone (peer closed, adapter unplugged). Polling
+            // again would only spin
+            if( len < 0 && _port.interrupted() == false )
+            {
+                SERIAL_LOG_ERROR(_port.logger(), "RoboteqCom - read failed, reader exiting. errno: " << errno);
+                break;
+            }
+
+            if( len > 0 && buffer.size() > 0 )
+            {
+                SERIAL_LOG_DEBUG(_port.logger(), "RoboteqCom - RX " << buffer);
+
+                if( _ackEnabled && (buffer[0] == '+' || buffer[0] == '-') )
+                    OnAck(buffer[0] == '+');
+                else if(buffer[0] != '+')
+                {
+                    if( _queryCount.load() != 0 && MatchQuery(buffer) )
+                        ;   // Completed its query
+                    else
+                    {
+                        const RxStamp& stamp = _port.frameStamp();
+
+                        if( stamp.lastNs != 0 )
+                        {
+                            if( _lastTelemetryNs != 0 && stamp.lastNs > _lastTelemetryNs )
+                                _latency[eLatency_Telemetry].Record(stamp.lastNs - _lastTelemetryNs);
+
+                            _lastTelemetryNs = stamp.lastNs;
+                        }
+
+                        if( _replies != 0L )
+                            _replies->Push(buffer.data(), buffer.size(), stamp);
+                        else
+                        {
+                            IEventArgs evt( buffer, stamp );
+                            _event.OnMsgEvent( evt );
+                        }
+                    }
                 }
             }
         }
     }
     catch(...)
     {
-        _port.logLine("RoboteqCom - reader exiting EXCEPTION");
+        SERIAL_LOG_ERROR(_port.logger(), "RoboteqCom - reader exiting EXCEPTION");
     }
 
-    _port.logLine("RoboteqCom - reader exiting");
+    SERIAL_LOG_INFO(_port.logger(), "RoboteqCom - reader exiting");
 }
 
 }   // End of oxoocoffee namespace
@@ -6,7 +6,22 @@ CONFIG -= qt
 SOURCES += main.cpp \
     roboteqCom.cpp \
     roboteqThread.cpp \
-    ../serialConnector/serialPort.cpp
+    roboteqEngine.cpp \
+    roboteqHistogram.cpp \
+    roboteqAck.cpp \
+    roboteqQuery.cpp \
+    roboteqCmdQueue.cpp \
+    roboteqReplyRing.cpp \
+    roboteqTelemetry.cpp \
+    roboteqCmdLine.cpp \
+    roboteqCmdTemplate.cpp \
+    ../serialConnector/serialPort.cpp \
+    ../serialConnector/serialBaud.cpp \
+    ../serialConnector/serialNetPort.cpp \
+    ../serialConnector/serialPtyPort.cpp \
+    ../serialConnector/serialReplayPort.cpp \
+    ../serialConnector/serialCapture.cpp \
+    ../serialConnector/serialAsyncLogger.cpp
 
 include(deployment.pri)
 qtcAddDeployment()
@@ -16,13 +31,30 @@ INCLUDEPATH += $$PWD/../../include/
 HEADERS += \
     serialException.h \
     ../../include/serialLogger.h \
+    ../../include/serialTransport.h \
     ../../include/serialNetPort.h \
+    ../../include/serialPtyPort.h \
+    ../../include/serialReplayPort.h \
+    ../../include/serialCapture.h \
+    ../../include/serialAsyncLogger.h \
     ../../include/serialPort.h \
+    ../../include/serialBaud.h \
     ../../include/roboteqCom.h \
     ../../include/roboteqComEvent.h \
     ../../include/roboteqMutex.h \
     ../../include/roboteqThread.h \
-    ../../include/serialException.h
+    ../../include/roboteqEngine.h \
+    ../../include/roboteqHistogram.h \
+    ../../include/roboteqAck.h \
+    ../../include/roboteqQuery.h \
+    ../../include/roboteqCmdQueue.h \
+    ../../include/roboteqReplyRing.h \
+    ../../include/roboteqTelemetry.h \
+    ../../include/roboteqCmdLine.h \
+    ../../include/roboteqCmdTable.h \
+    ../../include/roboteqCmdTemplate.h \
+    ../../include/serialException.h \
+    ../../include/serialClock.h
 
 QMAKE_CXXFLAGS += -m64 -std=c++11
 QMAKE_CFLAGS += -m64 -std=c++11
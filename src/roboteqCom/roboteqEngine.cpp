@@ -0,0 +1,294 @@
+#include "roboteqEngine.h"
+#include "roboteqCom.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+
+namespace oxoocoffee
+{
+
+RoboteqEngine::RoboteqEngine(SerialLogger& log)
+ : _logger(log), _epfd(-1), _wakeFd(-1), _entries(0L), _dead(0L),
+   _count(0), _stop(false), _thread(*this)
+{
+    _epfd = ::epoll_create1(EPOLL_CLOEXEC);
+
+    if( _epfd < 0 )
+        THROW_RUNTIME_ERROR("RoboteqEngine - epoll_create failed. errno: " << errno);
+
+    _wakeFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    if( _wakeFd < 0 )
+    {
+        ::close(_epfd);
+        THROW_RUNTIME_ERROR("RoboteqEngine - eventfd failed. errno: " << errno);
+    }
+
+    epoll_event ev;
+
+    ev.events   = EPOLLIN;
+    ev.data.ptr = 0L;      // NULL marks wake up event
+
+    if( ::epoll_ctl(_epfd, EPOLL_CTL_ADD, _wakeFd, &ev) != 0 )
+    {
+        ::close(_wakeFd);
+        ::close(_epfd);
+        THROW_RUNTIME_ERROR("RoboteqEngine - failed to register wake fd. errno: " << errno);
+    }
+}
+
+RoboteqEngine::~RoboteqEngine(void)
+{
+    Stop();
+
+    while( _entries != 0L )
+    {
+        Entry* pEntry = _entries;
+        _entries = pEntry->next;
+        delete pEntry;
+    }
+
+    while( _dead != 0L )
+    {
+        Entry* pEntry = _dead;
+        _dead = pEntry->next;
+        delete pEntry;
+    }
+
+    ::close(_wakeFd);
+    ::close(_epfd);
+}
+
+void    RoboteqEngine::Add(SerialPort& port, IRoboteqEvent& event, IEngineService* pService)
+{
+    if( port.isOpen() == false )
+        THROW_INVALID_ARG("RoboteqEngine - port is not connected");
+
+    Entry* pEntry = new Entry;
+
+    pEntry->port    = &port;
+    pEntry->event   = &event;
+    pEntry->service = pService;
+    pEntry->dueNs   = 0;
+    pEntry->next    = 0L;
+
+    epoll_event ev;
+
+    ev.events   = EPOLLIN;
+    ev.data.ptr = pEntry;
+
+    RoboScopedMutex lock(_mtx);
+
+    if( ::epoll_ctl(_epfd, EPOLL_CTL_ADD, port.fd(), &ev) != 0 )
+    {
+        delete pEntry;
+        THROW_RUNTIME_ERROR("RoboteqEngine - failed to register port. errno: " << errno);
+    }
+
+    pEntry->next = _entries;
+    _entries     = pEntry;
+    ++_count;
+}
+
+void    RoboteqEngine::Remove(SerialPort& port)
+{
+    RoboScopedMutex lock(_mtx);
+
+    for( Entry* pEntry = _entries; pEntry != 0L; pEntry = pEntry->next )
+    {
+        if( pEntry->port == &port )
+        {
+            Unlink(pEntry);
+            break;
+        }
+    }
+}
+
+void    RoboteqEngine::Start(void)
+{
+    _stop = false;
+    _thread.Start();
+}
+
+void    RoboteqEngine::Stop(void)
+{
+    if( _thread.IsRunning() )
+    {
+        _stop = true;
+        Wake();
+        _thread.Join();
+    }
+}
+
+void    RoboteqEngine::Wake(void)
+{
+    uint64_t one(1);
+
+    if( ::write(_wakeFd, &one, sizeof(one)) != sizeof(one) && errno != EAGAIN )
+        SERIAL_LOG_ERROR(_logger, "RoboteqEngine - wake up failed");
+}
+
+int     RoboteqEngine::Poll(int timeoutMs)
+{
+    epoll_event events[MAX_EVENTS];
+
+    int ready = ::epoll_wait(_epfd, events, MAX_EVENTS, ServiceWaitMs(timeoutMs));
+
+    if( ready < 0 )
+    {
+        if( errno == EINTR )
+            return 0;
+
+        THROW_RUNTIME_ERROR("RoboteqEngine - epoll_wait failed. errno: " << errno);
+    }
+
+    RoboScopedMutex lock(_mtx);
+
+    int dispatched(0);
+
+    for( int Idx(0); Idx < ready; Idx++ )
+    {
+        Entry* pEntry = (Entry*)events[Idx].data.ptr;
+
+        if( pEntry == 0L )
+        {
+            uint64_t count;
+
+            if( ::read(_wakeFd, &count, sizeof(count)) < 0 && errno != EAGAIN )
+                SERIAL_LOG_ERROR(_logger, "RoboteqEngine - wake fd read failed");
+
+            continue;
+        }
+
+        // Removed while we were waiting. Its event is stale
+        if( pEntry->port == 0L )
+            continue;
+
+        dispatched += Dispatch(pEntry);
+    }
+
+    RunServices();
+
+    // No event returned by this pass can point at them any more
+    while( _dead != 0L )
+    {
+        Entry* pEntry = _dead;
+        _dead = pEntry->next;
+        delete pEntry;
+    }
+
+    return dispatched;
+}
+
+// Shorter of timeoutMs and time to earliest service due
+int     RoboteqEngine::ServiceWaitMs(int timeoutMs)
+{
+    RoboScopedMutex lock(_mtx);
+
+    uint64_t now = SerialClock::NowNs();
+
+    for( Entry* pEntry = _entries; pEntry != 0L; pEntry = pEntry->next )
+    {
+        if( pEntry->service == 0L )
+            continue;
+
+        uint64_t due = pEntry->service->ServiceDueNs();
+
+        pEntry->dueNs = due;
+
+        if( due == 0 )
+            continue;
+
+        // Round up, waking early only costs an empty pass
+        int ms = due > now ? (int)((due - now + 999999) / 1000000) : 0;
+
+        if( timeoutMs < 0 || ms < timeoutMs )
+            timeoutMs = ms;
+    }
+
+    return timeoutMs;
+}
+
+// Called with _mtx held. Due times are the ones wait was cut
+// short for, asking again would only give a later one
+void    RoboteqEngine::RunServices(void)
+{
+    uint64_t now = SerialClock::NowNs();
+
+    for( Entry* pEntry = _entries; pEntry != 0L; pEntry = pEntry->next )
+    {
+        if( pEntry->service == 0L || pEntry->dueNs == 0 || pEntry->dueNs > now )
+            continue;
+
+        pEntry->dueNs = 0;
+        pEntry->service->Service();
+    }
+}
+
+void    RoboteqEngine::Run(void)
+{
+    try
+    {
+        while( _stop == false )
+            Poll(-1);
+    }
+    catch(...)
+    {
+        SERIAL_LOG_ERROR(_logger, "RoboteqEngine - exiting EXCEPTION");
+    }
+
+    SERIAL_LOG_INFO(_logger, "RoboteqEngine - exiting");
+}
+
+int     RoboteqEngine::Dispatch(Entry* pEntry)
+{
+    SerialPort& port = *pEntry->port;
+
+    if( port.receive() <= 0 )
+    {
+        SERIAL_LOG_WARN(_logger, "RoboteqEngine - port read failed. dropping it");
+
+        Unlink(pEntry);
+        return 0;
+    }
+
+    int dispatched(0);
+
+    while( port.popFrame(pEntry->frame, ROBO_TERMINATOR) )
+    {
+        if( pEntry->frame[0] != '+' )
+        {
+            IEventArgs evt( pEntry->frame, port.frameStamp() );
+            pEntry->event->OnMsgEvent( evt );
+            ++dispatched;
+        }
+    }
+
+    return dispatched;
+}
+
+// Called with _mtx held. Entry is parked on _dead list
+// until end of current Poll since epoll_wait may
+// already have handed out a pointer to it
+void    RoboteqEngine::Unlink(Entry* pEntry)
+{
+    if( pEntry->port->isOpen() )
+        ::epoll_ctl(_epfd, EPOLL_CTL_DEL, pEntry->port->fd(), 0L);
+
+    Entry** ppLink = &_entries;
+
+    while( *ppLink != pEntry )
+        ppLink = &(*ppLink)->next;
+
+    *ppLink = pEntry->next;
+
+    pEntry->port  = 0L;
+    pEntry->event = 0L;
+    pEntry->next  = _dead;
+    _dead         = pEntry;
+
+    --_count;
+}
+
+}   // End of oxoocoffee namespace
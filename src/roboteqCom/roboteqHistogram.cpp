@@ -0,0 +1,85 @@
+#include "roboteqHistogram.h"
+
+namespace oxoocoffee
+{
+
+RoboteqHistogram::RoboteqHistogram(void)
+{
+    Reset();
+}
+
+void    RoboteqHistogram::Reset(void)
+{
+    for( unsigned int Idx(0); Idx < BUCKETS; Idx++ )
+        _counts[Idx].store(0, std::memory_order_relaxed);
+
+    _sum.store(0, std::memory_order_relaxed);
+    _min.store(~0ULL, std::memory_order_relaxed);
+    _max.store(0, std::memory_order_relaxed);
+}
+
+void    RoboteqHistogram::GetSnapshot(Snapshot& snap) const
+{
+    snap.total = 0;
+
+    for( unsigned int Idx(0); Idx < BUCKETS; Idx++ )
+    {
+        snap.counts[Idx] = _counts[Idx].load(std::memory_order_relaxed);
+        snap.total      += snap.counts[Idx];
+    }
+
+    snap.sum = _sum.load(std::memory_order_relaxed);
+    snap.min = _min.load(std::memory_order_relaxed);
+    snap.max = _max.load(std::memory_order_relaxed);
+
+    if( snap.total == 0 )
+        snap.min = 0;
+}
+
+uint64_t RoboteqHistogram::UpperEdge(unsigned int index)
+{
+    if( index < SUB_COUNT )
+        return index;
+
+    unsigned int shift = index / SUB_COUNT - 1;
+    uint64_t     lower = (uint64_t)(index % SUB_COUNT + SUB_COUNT) << shift;
+
+    return lower + (1ULL << shift) - 1;
+}
+
+uint64_t RoboteqHistogram::Snapshot::Percentile(double pct) const
+{
+    if( total == 0 )
+        return 0;
+
+    uint64_t rank = (uint64_t)(pct / 100.0 * total + 0.5);
+
+    if( rank == 0 )
+        rank = 1;
+
+    if( rank > total )
+        rank = total;
+
+    uint64_t seen(0);
+
+    for( unsigned int Idx(0); Idx < BUCKETS; Idx++ )
+    {
+        seen += counts[Idx];
+
+        if( seen >= rank )
+        {
+            uint64_t edge = UpperEdge(Idx);
+
+            return edge > max ? max : edge;
+        }
+    }
+
+    return max;
+}
+
+double  RoboteqHistogram::Snapshot::Mean(void) const
+{
+    return total ? (double)sum / total : 0.0;
+}
+
+}   // End of oxoocoffee namespace
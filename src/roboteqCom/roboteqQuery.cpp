@@ -0,0 +1,80 @@
+#include "roboteqQuery.h"
+#include "roboteqCom.h"
+
+namespace oxoocoffee
+{
+
+RoboteqQuery::RoboteqQuery(void)
+ : _status(eStatus_Idle), _finished(true), _keyLen(0), _node(0), _sentNs(0), _deadlineNs(0), _latencyNs(0),
+   _pDone(0L), _pCom(0L), _pNext(0L)
+{
+    pthread_mutex_init(&_mx, NULL);
+    pthread_cond_init(&_cond, NULL);
+}
+
+RoboteqQuery::~RoboteqQuery(void)
+{
+    pthread_mutex_lock(&_mx);
+    bool finished = _finished;
+    pthread_mutex_unlock(&_mx);
+
+    // Status turns final before callback runs. Reader may still be
+    // inside Complete, so wait for _finished, not for status
+    if( finished == false && _pCom != 0L && _pCom->Cancel(*this) == false )
+        Wait();
+
+    pthread_cond_destroy(&_cond);
+    pthread_mutex_destroy(&_mx);
+}
+
+bool    RoboteqQuery::Wait(void)
+{
+    pthread_mutex_lock(&_mx);
+
+    while( _finished == false )
+        pthread_cond_wait(&_cond, &_mx);
+
+    bool done = (_status == eStatus_Done);
+
+    pthread_mutex_unlock(&_mx);
+
+    return done;
+}
+
+RoboteqQuery::eStatus RoboteqQuery::Status(void) const
+{
+    pthread_mutex_lock(&_mx);
+    eStatus status = _status;
+    pthread_mutex_unlock(&_mx);
+
+    return status;
+}
+
+string  RoboteqQuery::Value(void) const
+{
+    string::size_type Idx = _reply.find('=');
+
+    if( Idx == string::npos )
+        return "";
+
+    return _reply.substr(Idx + 1);
+}
+
+// Caller already unlinked query from RoboteqCom. Waiter is
+// released only after callback returns
+void    RoboteqQuery::Complete(eStatus status)
+{
+    pthread_mutex_lock(&_mx);
+    _status = status;
+    pthread_mutex_unlock(&_mx);
+
+    if( _pDone != 0L )
+        _pDone->OnQueryDone(*this);
+
+    pthread_mutex_lock(&_mx);
+    _finished = true;
+    pthread_cond_broadcast(&_cond);
+    pthread_mutex_unlock(&_mx);
+}
+
+}   // End of oxoocoffee namespace
@@ -0,0 +1,120 @@
+#include "roboteqReplyRing.h"
+#include "serialException.h"
+#include <string.h>
+
+namespace oxoocoffee
+{
+
+RoboteqReplyRing::RoboteqReplyRing(unsigned int slots, unsigned int slotBytes)
+ : _data(0L), _lengths(0L), _stamps(0L), _mask(0), _slotBytes(slotBytes),
+   _head(0), _cachedTail(0), _pushed(0), _dropped(0), _highWater(0),
+   _tail(0), _popped(0)
+{
+    if( slots == 0 || slotBytes == 0 )
+        THROW_INVALID_ARG("RoboteqReplyRing - slots and slotBytes must not be 0");
+
+    unsigned int capacity(1);
+
+    while( capacity < slots )
+        capacity <<= 1;
+
+    _mask    = capacity - 1;
+    _data    = new char[capacity * slotBytes];
+    _lengths = new unsigned int[capacity];
+    _stamps  = new RxStamp[capacity];
+}
+
+RoboteqReplyRing::~RoboteqReplyRing(void)
+{
+    delete [] _data;
+    delete [] _lengths;
+    delete [] _stamps;
+}
+
+bool    RoboteqReplyRing::Push(const char* pData, unsigned int len,
+                               const RxStamp& stamp)
+{
+    unsigned int head = _head.load(std::memory_order_relaxed);
+
+    // Refresh consumer index only when ring looks full
+    if( head - _cachedTail > _mask )
+        _cachedTail = _tail.load(std::memory_order_acquire);
+
+    if( head - _cachedTail > _mask || len > _slotBytes )
+    {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    unsigned int slot = head & _mask;
+
+    memcpy(_data + (size_t)slot * _slotBytes, pData, len);
+    _lengths[slot] = len;
+    _stamps[slot]  = stamp;
+
+    _head.store(head + 1, std::memory_order_release);
+    _pushed.fetch_add(1, std::memory_order_relaxed);
+
+    unsigned int used = head + 1 - _cachedTail;
+
+    if( used > _highWater.load(std::memory_order_relaxed) )
+        _highWater.store(used, std::memory_order_relaxed);
+
+    return true;
+}
+
+bool    RoboteqReplyRing::Peek(const char*& pData, unsigned int& len) const
+{
+    unsigned int tail = _tail.load(std::memory_order_relaxed);
+
+    if( tail == _head.load(std::memory_order_acquire) )
+        return false;
+
+    unsigned int slot = tail & _mask;
+
+    pData = _data + (size_t)slot * _slotBytes;
+    len   = _lengths[slot];
+
+    return true;
+}
+
+bool    RoboteqReplyRing::Peek(const char*& pData, unsigned int& len, RxStamp& stamp) const
+{
+    if( Peek(pData, len) == false )
+        return false;
+
+    stamp = _stamps[_tail.load(std::memory_order_relaxed) & _mask];
+
+    return true;
+}
+
+void    RoboteqReplyRing::Release(void)
+{
+    _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    _popped.fetch_add(1, std::memory_order_relaxed);
+}
+
+unsigned int RoboteqReplyRing::Size(void) const
+{
+    return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+}
+
+void    RoboteqReplyRing::GetStats(Stats& stats) const
+{
+    stats.pushed    = _pushed.load(std::memory_order_relaxed);
+    stats.popped    = _popped.load(std::memory_order_relaxed);
+    stats.dropped   = _dropped.load(std::memory_order_relaxed);
+    stats.highWater = _highWater.load(std::memory_order_relaxed);
+    stats.capacity  = _mask + 1;
+}
+
+// Racy against running producer. Counters only, indexes are untouched
+void    RoboteqReplyRing::ResetStats(void)
+{
+    _pushed.store(0, std::memory_order_relaxed);
+    _popped.store(0, std::memory_order_relaxed);
+    _dropped.store(0, std::memory_order_relaxed);
+    _highWater.store(0, std::memory_order_relaxed);
+}
+
+}   // End of oxoocoffee namespace
@@ -0,0 +1,107 @@
+#include "roboteqTelemetry.h"
+#include <ctype.h>
+
+namespace oxoocoffee
+{
+
+struct KeyEntry
+{
+    const char*                 name;
+    unsigned int                length;
+    RoboteqTelemetry::eKey      key;
+};
+
+static const KeyEntry gKeys[] =
+{
+    { "S",  1, RoboteqTelemetry::eKey_S  },
+    { "A",  1, RoboteqTelemetry::eKey_A  },
+    { "V",  1, RoboteqTelemetry::eKey_V  },
+    { "T",  1, RoboteqTelemetry::eKey_T  },
+    { "CR", 2, RoboteqTelemetry::eKey_CR },
+    { "C",  1, RoboteqTelemetry::eKey_C  },
+    { "BA", 2, RoboteqTelemetry::eKey_BA },
+    { "FF", 2, RoboteqTelemetry::eKey_FF },
+    { "P",  1, RoboteqTelemetry::eKey_P  },
+};
+
+static const unsigned int gKeyCount = sizeof(gKeys) / sizeof(gKeys[0]);
+
+bool    RoboteqTelemetry::Parse(const char* pReply, unsigned int len, Reply& reply)
+{
+    reply.key   = eKey_Unknown;
+    reply.count = 0;
+
+    const char* pEnd = pReply + len;
+
+    // Echo or prompt byte in front
+    if( pReply < pEnd && isalpha( (unsigned char)*pReply ) == 0 )
+        ++pReply;
+
+    while( pEnd > pReply && (pEnd[-1] == '\r' || pEnd[-1] == '\n') )
+        --pEnd;
+
+    const KeyEntry* pKey(0L);
+
+    for( unsigned int Idx(0); Idx < gKeyCount; Idx++ )
+    {
+        const KeyEntry& entry = gKeys[Idx];
+
+        if( pEnd - pReply > (long)entry.length &&
+            pReply[entry.length] == '=' &&
+            pReply[0] == entry.name[0] &&
+            (entry.length == 1 || pReply[1] == entry.name[1]) )
+        {
+            pKey = &entry;
+            break;
+        }
+    }
+
+    if( pKey == 0L )
+        return false;
+
+    const char* pCur = pReply + pKey->length + 1;
+
+    for( ;; )
+    {
+        if( reply.count == MAX_VALUES )
+            return false;
+
+        bool negative(false);
+
+        if( pCur < pEnd && (*pCur == '-' || *pCur == '+') )
+            negative = (*pCur++ == '-');
+
+        if( pCur == pEnd || (unsigned char)(*pCur - '0') > 9 )
+            return false;
+
+        long value(0);
+
+        while( pCur < pEnd && (unsigned char)(*pCur - '0') <= 9 )
+            value = value * 10 + (*pCur++ - '0');
+
+        reply.values[reply.count++] = negative ? -value : value;
+
+        if( pCur == pEnd )
+            break;
+
+        if( *pCur++ != ':' )
+            return false;
+    }
+
+    reply.key = pKey->key;
+
+    return true;
+}
+
+const char* RoboteqTelemetry::KeyName(eKey key)
+{
+    for( unsigned int Idx(0); Idx < gKeyCount; Idx++ )
+    {
+        if( gKeys[Idx].key == key )
+            return gKeys[Idx].name;
+    }
+
+    return "?";
+}
+
+}   // End of oxoocoffee namespace
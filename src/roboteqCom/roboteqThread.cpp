@@ -39,10 +39,11 @@ void    RoboteqThread::Join(void)
 {
     if( _running )
     {
-        _running = false;
-
+        // IsRunning stays true until thread is really gone
         if( ::pthread_join(_thread, NULL) != 0 )
             THROW_RUNTIME_ERROR("Couldn't join thread");
+
+        _running = false;
     }
 }
 
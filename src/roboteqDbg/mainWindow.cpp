@@ -171,7 +171,10 @@ bool    MainWindow::Initialize(int argc, char* argv[])
     if( _commands.size() == 0 )
         CreateBottomWindow();
 
-    if( _logger.Open(LOG_FILE_NAME, _comunicator.IsThreaded() ) == false )
+    // Our process, so log tail may be saved on a crash
+    SerialAsyncLogger::InstallCrashHandler();
+
+    if( _logger.Open(LOG_FILE_NAME) == false )
         THROW_RUNTIME_ERROR(string("Failed to open ") + LOG_FILE_NAME);
 
     if( _mode == RoboteqCom::eSerial )
@@ -285,7 +288,7 @@ void    MainWindow::EnterInterectiveMode(void)
                     {
                         slk_set(KEY_F2, "F2 Log Y",   LABEL_CENTER);
 
-                        if( _logger.Open(LOG_FILE_NAME, _comunicator.IsThreaded() ) == false )
+                        if( _logger.Open(LOG_FILE_NAME) == false )
                             THROW_RUNTIME_ERROR(string("Failed to open ") + LOG_FILE_NAME);
                     }
                     slk_refresh();
@@ -640,41 +643,22 @@ void    MainWindow::OnMsgEvent(const IEventArgs& evt)
 {
     AppendText(_middle, eMsgDir_IN, evt.Reply().c_str() ); 
 
-    switch( evt.Reply()[0] )
-    {
-            case 'S':
-                    Process_S( evt );
-            break;
+    RoboteqTelemetry::Reply reply;
 
-            case 'N':
-                    Process_N( evt );
-            break;
+    if( RoboteqTelemetry::Parse(evt.Data(), evt.Length(), reply) )
+    {
+        if( reply.key == RoboteqTelemetry::eKey_S )
+            Process_S( reply );
 
-            default:
-            break;
+        return;
     }
+
+    if( evt.Length() > 0 && evt.Data()[0] == 'N' )
+        Process_N( evt );
 }
 
-void    MainWindow::Process_S(const IEventArgs& evt)
+void    MainWindow::Process_S(const RoboteqTelemetry::Reply& reply)
 {
-        string::size_type idx = evt.Reply().find_first_of('=');
-
-        if( idx != string::npos )
-        {
-                string::size_type idy = evt.Reply().find_first_of(':', idx);
-
-                if( idy != string::npos )
-                {
-                        //char* pVal1 = (char*)(evt.Request().c_str() + idx + 1);
-                        //char* pVal2 = (char*)(evt.Request().c_str() + idy);
-
-                        //*pVal2 = 0L;
-                        //pVal2++;
-
-                        //int firstVal  = atoi( pVal1 );
-                        //int secondVal = atoi( pVal2 );
-                }
-        }
 }
 
 void    MainWindow::Process_N(const IEventArgs& evt)
@@ -4,7 +4,8 @@
 #include <ncurses.h>
 #include <vector>
 #include "roboteqCom.h"
-#include "roboteqLogger.h"
+#include "roboteqTelemetry.h"
+#include "serialAsyncLogger.h"
 
 // ncurses roboteq Dbg 
 // Robert J. Gebis (oxoocoffee) <rjgebis@yahoo.com>
@@ -79,11 +80,11 @@ class MainWindow : public IEventListener<const IEventArgs>
         // RoboteqCom Events
         virtual void OnMsgEvent(const IEventArgs& evt);
 
-        void    Process_S(const IEventArgs& evt);
+        void    Process_S(const RoboteqTelemetry::Reply& reply);
         void    Process_N(const IEventArgs& evt);
 
     private:
-        RoboteqLogger       _logger;
+        SerialAsyncLogger   _logger;
         RoboteqCom          _comunicator;
         RoboMutex           _mutex;            // Optionally used if RoboteqCom setup in threaded mode
         string              _title;
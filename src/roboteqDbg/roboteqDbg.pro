@@ -7,10 +7,24 @@ LIBS += -lncurses
 
 SOURCES += main.cpp \
     mainWindow.cpp\
-    roboteqLogger.cpp\
     ../roboteqCom/roboteqCom.cpp\
     ../roboteqCom/roboteqThread.cpp\
-    ../serialConnector/serialPort.cpp
+    ../roboteqCom/roboteqEngine.cpp\
+    ../roboteqCom/roboteqHistogram.cpp\
+    ../roboteqCom/roboteqAck.cpp\
+    ../roboteqCom/roboteqQuery.cpp\
+    ../roboteqCom/roboteqCmdQueue.cpp\
+    ../roboteqCom/roboteqReplyRing.cpp\
+    ../roboteqCom/roboteqTelemetry.cpp\
+    ../roboteqCom/roboteqCmdLine.cpp\
+    ../roboteqCom/roboteqCmdTemplate.cpp\
+    ../serialConnector/serialPort.cpp \
+    ../serialConnector/serialBaud.cpp \
+    ../serialConnector/serialNetPort.cpp \
+    ../serialConnector/serialPtyPort.cpp \
+    ../serialConnector/serialReplayPort.cpp \
+    ../serialConnector/serialCapture.cpp \
+    ../serialConnector/serialAsyncLogger.cpp
 
 
 include(deployment.pri)
@@ -21,10 +35,25 @@ INCLUDEPATH += $$PWD/../../include/
 HEADERS += \
     ../../include/serialException.h \
     ../../include/serialLogger.h \
+    ../../include/serialTransport.h \
     ../../include/serialNetPort.h \
+    ../../include/serialPtyPort.h \
+    ../../include/serialReplayPort.h \
+    ../../include/serialCapture.h \
+    ../../include/serialAsyncLogger.h \
     ../../include/serialPort.h \
+    ../../include/serialBaud.h \
     ../../include/roboteqCom.h \
     ../../include/roboteqComEvent.h \
-    mainWindow.h \
-    roboteqLogger.h
+    ../../include/roboteqEngine.h \
+    ../../include/roboteqHistogram.h \
+    ../../include/roboteqAck.h \
+    ../../include/roboteqQuery.h \
+    ../../include/roboteqCmdQueue.h \
+    ../../include/roboteqReplyRing.h \
+    ../../include/roboteqTelemetry.h \
+    ../../include/roboteqCmdLine.h \
+    ../../include/roboteqCmdTable.h \
+    ../../include/roboteqCmdTemplate.h \
+    mainWindow.h
 
@@ -0,0 +1,176 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include "roboteqSim.h"
+#include "serialPtyPort.h"
+
+// Roboteq controller simulator
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details at
+// http://www.gnu.org/copyleft/gpl.html
+
+// Traffic goes to stdout with -v
+class ConsoleLogger : public SerialLogger
+{
+    public:
+        ConsoleLogger(void) : _verbose(false) {}
+
+        inline  void    Verbose(bool verbose) { _verbose = verbose; }
+
+        virtual bool    IsLogOpen(void) const { return _verbose; }
+        virtual void    LogLine(const char* pBuffer, unsigned int len) { cout.write(pBuffer, len) << endl; }
+        virtual void    LogLine(const std::string& message) { cout << message << endl; }
+        virtual void    Log(const char* pBuffer, unsigned int len) { cout.write(pBuffer, len); }
+        virtual void    Log(const std::string& message) { cout << message; }
+
+    private:
+        bool    _verbose;
+};
+
+static RoboteqSim*  gpSim(0L);
+
+void    PrintHelp(string progName);
+void    PrintStats(const RoboteqSim::Stats& stats);
+
+static void SigInt(int sig)
+{
+    if( sig == SIGINT && gpSim != 0L )
+        gpSim->Stop();
+}
+
+int main(int argc, char* argv[])
+{
+    RoboteqSim::Config  config;
+    ConsoleLogger       logger;
+    string              link;
+    int                 opt;
+
+    while( (opt = getopt(argc, argv, "o:l:j:t:c:M:r:d:n:g:z:s:Evh")) != -1 )
+    {
+        switch( opt )
+        {
+            case 'o': link               = optarg;       break;
+            case 'l': config.latencyUs   = atoi(optarg); break;
+            case 'j': config.jitterUs    = atoi(optarg); break;
+            case 't': config.telemetryMs = atoi(optarg); break;
+            case 'M': config.maxRpm      = atoi(optarg); break;
+            case 'r': config.rampMs      = atoi(optarg); break;
+            case 'd': config.dropPct     = atof(optarg); break;
+            case 'n': config.nackPct     = atof(optarg); break;
+            case 'g': config.corruptPct  = atof(optarg); break;
+            case 'z': config.stallMs     = atoi(optarg); break;
+            case 's': config.seed        = atoi(optarg); break;
+            case 'E': config.echo        = false;        break;
+            case 'v': logger.Verbose(true);              break;
+
+            case 'c':
+            {
+                // "1,4" puts RoboCAN nodes 1 and 4 on the bus
+                char* pNext = optarg;
+
+                config.nodes.assign(RoboteqSim::MAX_NODES, false);
+
+                while( *pNext != 0 )
+                {
+                    unsigned int node = strtoul(pNext, &pNext, 10);
+
+                    if( node < RoboteqSim::MAX_NODES )
+                        config.nodes[node] = true;
+
+                    if( *pNext == ',' )
+                        ++pNext;
+                    else if( *pNext != 0 )
+                        break;
+                }
+            }
+            break;
+
+            default:
+                PrintHelp(argv[0]);
+                return 0;
+        }
+    }
+
+    try
+    {
+        SerialPtyPort   pty(logger);
+        RoboteqSim      sim(logger, config);
+        int             fd = pty.Open("");
+
+        cout << "RoboteqSim - controller on " << pty.SlavePath() << endl;
+
+        if( link.empty() == false )
+        {
+            ::unlink(link.c_str());
+
+            if( ::symlink(pty.SlavePath().c_str(), link.c_str()) != 0 )
+                cout << "RoboteqSim - failed to link " << link << " errno: " << errno << endl;
+            else
+                cout << "RoboteqSim - linked as " << link << endl;
+        }
+
+        gpSim = &sim;
+        signal(SIGINT, SigInt);
+
+        sim.Run(fd);
+
+        gpSim = 0L;
+        pty.Close(fd);
+
+        if( link.empty() == false )
+            ::unlink(link.c_str());
+
+        PrintStats(sim.GetStats());
+    }
+    catch(std::exception& ex)
+    {
+        cout << "Exception: " << ex.what() << endl;
+    }
+
+    return 0;
+}
+
+void    PrintHelp(string progName)
+{
+    string::size_type Idx = progName.find_last_of("\\/");
+
+    if( Idx != string::npos )
+        progName = progName.substr( Idx + 1 );
+
+    cout << endl;
+    cout << "Usage: " << progName << " [options]" << endl;
+    cout << "   -o path       - symlink to pty slave, stable device path" << endl;
+    cout << "   -l us         - reply latency" << endl;
+    cout << "   -j us         - reply latency jitter" << endl;
+    cout << "   -t ms         - telemetry period, overrides \"# nn\"" << endl;
+    cout << "   -c n,n        - RoboCAN nodes present (default any)" << endl;
+    cout << "   -M rpm        - speed at !G 1000 (3000)" << endl;
+    cout << "   -r ms         - speed ramp time constant (100)" << endl;
+    cout << "   -d pct        - drop outgoing frames" << endl;
+    cout << "   -n pct        - answer commands \"-\"" << endl;
+    cout << "   -g pct        - garble one byte of outgoing frames" << endl;
+    cout << "   -z ms         - hold output this long every second" << endl;
+    cout << "   -s seed       - fault injection seed" << endl;
+    cout << "   -E            - echo off at start" << endl;
+    cout << "   -v            - print traffic" << endl;
+    cout << "   -h            - this information" << endl;
+}
+
+void    PrintStats(const RoboteqSim::Stats& stats)
+{
+    printf("\nlines %lu  commands %lu  acks %lu  nacks %lu  queries %lu  telemetry %lu\n",
+           stats.lines, stats.commands, stats.acks, stats.nacks, stats.queries, stats.telemetry);
+    printf("dropped %lu  corrupted %lu  overflow %lu  bytes in %lu  out %lu\n",
+           stats.dropped, stats.corrupted, stats.overflow, stats.bytesIn, stats.bytesOut);
+}
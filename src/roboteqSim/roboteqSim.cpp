@@ -0,0 +1,500 @@
+#include "roboteqSim.h"
+#include "serialClock.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+// Roboteq controller simulator
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details at
+// http://www.gnu.org/copyleft/gpl.html
+
+#define ENCODER_CPR     4096    // Quadrature counts per motor turn
+#define VERSION_REPLY   "Roboteq v1.3 RoboteqSim 10/17/2014"
+#define MODEL_REPLY     "SIM:SDC2130"
+
+RoboteqSim::Config::Config(void)
+ : latencyUs(0), jitterUs(0), telemetryMs(0), maxRpm(3000), rampMs(100),
+   dropPct(0), nackPct(0), corruptPct(0), stallMs(0), seed(1), echo(true)
+{
+}
+
+RoboteqSim::Stats::Stats(void)
+ : lines(0), commands(0), acks(0), nacks(0), queries(0), telemetry(0),
+   dropped(0), corrupted(0), overflow(0), bytesIn(0), bytesOut(0)
+{
+}
+
+RoboteqSim::RoboteqSim(SerialLogger& log, const Config& config)
+ : _logger(log), _config(config), _stop(false), _fd(-1), _rand(config.seed),
+   _echo(config.echo), _lastDueNs(0), _streamMs(0), _nextStreamNs(0), _startNs(0)
+{
+    memset(_nodes, 0, sizeof(_nodes));
+}
+
+void    RoboteqSim::Run(int fd)
+{
+    _fd      = fd;
+    _startNs = SerialClock::NowNs();
+
+    for( unsigned int Idx(0); Idx < MAX_NODES; Idx++ )
+        _nodes[Idx].updatedNs = _startNs;
+
+    ::fcntl(_fd, F_SETFL, ::fcntl(_fd, F_GETFL, 0) | O_NONBLOCK);
+
+    char buffer[4096];
+
+    while( _stop == false )
+    {
+        uint64_t now = SerialClock::NowNs();
+
+        Stream(now);
+        Flush(now);
+
+        // Sleep until next frame is due, bounded so Stop is noticed
+        uint64_t due  = NextDueNs(now);
+        uint64_t wait = due > now ? due - now : 0;
+
+        if( wait > 100000000ULL )
+            wait = 100000000ULL;
+
+        timespec timeout = SerialClock::FromNs(wait);
+        pollfd   pfd;
+
+        pfd.fd      = _fd;
+        pfd.events  = POLLIN | (_out.empty() ? 0 : POLLOUT);
+        pfd.revents = 0;
+
+        if( ::ppoll(&pfd, 1, &timeout, 0L) <= 0 )
+            continue;
+
+        if( pfd.revents & (POLLIN | POLLHUP | POLLERR) )
+        {
+            int count = ::read(_fd, buffer, sizeof(buffer));
+
+            if( count > 0 )
+            {
+                _stats.bytesIn += count;
+                Receive(buffer, count, SerialClock::NowNs());
+            }
+            else if( count < 0 && errno != EAGAIN && errno != EINTR )
+                ::usleep(1000);     // Peer gone, wait for next one
+        }
+    }
+}
+
+void    RoboteqSim::Receive(const char* pData, unsigned int len, uint64_t now)
+{
+    for( unsigned int Idx(0); Idx < len; Idx++ )
+    {
+        char byte = pData[Idx];
+
+        if( byte == '\r' )
+        {
+            if( _line.empty() == false )
+                Line(_line, now);
+
+            _line.clear();
+        }
+        else if( byte != '\n' )
+            _line += byte;
+    }
+}
+
+void    RoboteqSim::Line(const string& line, uint64_t now)
+{
+    ++_stats.lines;
+
+    if( _logger.IsLogOpen() )
+        _logger.LogLine("RoboteqSim - in  " + line);
+
+    // Echo always makes it out, faults only hit answers
+    if( _echo )
+    {
+        _lastDueNs = now > _lastDueNs ? now : _lastDueNs;
+        _delayed.push_back( make_pair(_lastDueNs, line + '\r') );
+    }
+
+    string::size_type start(0);
+
+    while( start <= line.size() )
+    {
+        string::size_type end = line.find('_', start);
+
+        if( end == string::npos )
+            end = line.size();
+
+        string::size_type cmd = start;
+        unsigned int      node(0);
+        bool              can(false);
+
+        // RoboCAN "@NN" address
+        if( line[cmd] == '@' && cmd + 3 <= end &&
+            isdigit((unsigned char)line[cmd + 1]) && isdigit((unsigned char)line[cmd + 2]) )
+        {
+            node = (line[cmd + 1] - '0') * 10 + (line[cmd + 2] - '0');
+            can  = true;
+            cmd += 3;
+        }
+
+        while( cmd < end && line[cmd] == ' ' )
+            ++cmd;
+
+        // Absent node behaves like CAN timeout, nothing comes back
+        bool present = _config.nodes.empty() || node == 0 ||
+                       (node < _config.nodes.size() && _config.nodes[node]);
+
+        if( cmd < end && present )
+            Command(node, can, line.substr(cmd, end - cmd), now);
+
+        start = end + 1;
+    }
+}
+
+void    RoboteqSim::Command(unsigned int node, bool can, const string& cmd, uint64_t now)
+{
+    char  type = cmd[0];
+    char  name[16] = { 0 };
+    int   arg1(0), arg2(0);
+    int   args = sscanf(cmd.c_str() + 1, "%15[A-Za-z$0-9] %d %d", name, &arg1, &arg2) - 1;
+
+    Node& state = _nodes[node];
+
+    if( type == '#' )
+    {
+        string rest = cmd.substr(1);
+
+        rest.erase(0, rest.find_first_not_of(' '));
+
+        if( rest == "C" )
+            _history.clear();
+        else if( rest.empty() )
+            _streamMs = 0;
+        else
+        {
+            _streamMs     = atoi(rest.c_str());
+            _nextStreamNs = now;
+        }
+
+        return;
+    }
+
+    if( type == '?' )
+    {
+        ++_stats.queries;
+
+        string value;
+        string key(name);
+
+        if( Answer(node, key, value, now) == false )
+        {
+            Reply(node, false, "-", now);
+            return;
+        }
+
+        // One channel only when asked "?S 1"
+        if( args >= 1 )
+        {
+            string::size_type from(0);
+
+            for( int ch(1); ch < arg1 && from != string::npos; ch++ )
+            {
+                from = value.find(':', from);
+
+                if( from != string::npos )
+                    ++from;
+            }
+
+            if( from == string::npos || arg1 < 1 )
+            {
+                Reply(node, false, "-", now);
+                return;
+            }
+
+            value = value.substr(from, value.find(':', from) - from);
+        }
+
+        Reply(node, can, key + "=" + value, now);
+
+        string entry(cmd);
+
+        if( can )
+        {
+            char address[4];
+            snprintf(address, sizeof(address), "@%02u", node);
+            entry = address + cmd;
+        }
+
+        if( _history.size() < MAX_HISTORY &&
+            std::find(_history.begin(), _history.end(), entry) == _history.end() )
+            _history.push_back(entry);
+
+        return;
+    }
+
+    ++_stats.commands;
+
+    bool ok(true);
+
+    if( type == '!' )
+    {
+        Update(state, now);
+
+        string what(name);
+        int    channel = args >= 2 ? arg1 : 1;
+        int    value   = args >= 2 ? arg2 : arg1;
+
+        if( what == "G" || what == "S" )
+        {
+            if( what == "S" && _config.maxRpm )
+                value = value * 1000 / (int)_config.maxRpm;
+
+            if( args < 1 || channel < 1 || channel > 2 || value < -1000 || value > 1000 )
+                ok = false;
+            else
+                state.motor[channel - 1].command = value;
+        }
+        else if( what == "EX" )
+        {
+            state.estop = true;
+            state.motor[0].command = 0;
+            state.motor[1].command = 0;
+        }
+        else if( what == "MG" )
+            state.estop = false;
+        else if( what == "MS" )
+        {
+            if( args >= 1 && arg1 >= 1 && arg1 <= 2 )
+                state.motor[arg1 - 1].command = 0;
+            else
+                ok = false;
+        }
+    }
+    else if( type == '^' )
+    {
+        if( strcmp(name, "ECHOF") == 0 && args >= 1 )
+            _echo = arg1 == 0;
+    }
+    else if( type != '%' )
+        ok = false;     // "~" config reads and anything else
+
+    if( ok && Chance(_config.nackPct) )
+        ok = false;
+
+    if( ok )
+        ++_stats.acks;
+    else
+        ++_stats.nacks;
+
+    Reply(node, false, ok ? "+" : "-", now);
+}
+
+bool    RoboteqSim::Answer(unsigned int node, string& key, string& value, uint64_t now)
+{
+    Node& state = _nodes[node];
+    char  text[64];
+
+    Update(state, now);
+
+    // Numbered aliases answer under their name
+    if( key == "$1E" )
+        key = "FID";
+    else if( key == "$1F" )
+        key = "TRN";
+
+    if( key == "FID" )
+        snprintf(text, sizeof(text), "%s", VERSION_REPLY);
+    else if( key == "TRN" )
+        snprintf(text, sizeof(text), "%s", MODEL_REPLY);
+    else if( key == "S" || key == "BS" )
+        snprintf(text, sizeof(text), "%d:%d", (int)state.motor[0].rpm, (int)state.motor[1].rpm);
+    else if( key == "A" )       // Amps * 10, idle draw plus load
+        snprintf(text, sizeof(text), "%d:%d", abs(state.motor[0].command) / 10 + 2,
+                                              abs(state.motor[1].command) / 10 + 2);
+    else if( key == "C" )
+        snprintf(text, sizeof(text), "%ld:%ld", (long)state.motor[0].counts, (long)state.motor[1].counts);
+    else if( key == "V" )       // Internal, battery (volts * 10), 5V out (mV)
+        snprintf(text, sizeof(text), "120:245:5000");
+    else if( key == "T" )
+        snprintf(text, sizeof(text), "30:31");
+    else if( key == "FF" )
+        snprintf(text, sizeof(text), "%d", state.estop ? 16 : 0);
+    else
+        return false;
+
+    value = text;
+
+    return true;
+}
+
+void    RoboteqSim::Update(Node& node, uint64_t now)
+{
+    double dt = (now - node.updatedNs) / 1e9;
+
+    node.updatedNs = now;
+
+    for( int Idx(0); Idx < 2; Idx++ )
+    {
+        Motor& motor  = node.motor[Idx];
+        double target = node.estop ? 0 : (double)motor.command * _config.maxRpm / 1000;
+        double alpha  = _config.rampMs ? 1 - exp(-dt * 1000 / _config.rampMs) : 1;
+
+        motor.rpm    += (target - motor.rpm) * alpha;
+        motor.counts += motor.rpm / 60 * dt * ENCODER_CPR;
+    }
+}
+
+void    RoboteqSim::Stream(uint64_t now)
+{
+    unsigned int period = _streamMs && _config.telemetryMs ? _config.telemetryMs : _streamMs;
+
+    if( period == 0 || now < _nextStreamNs )
+        return;
+
+    // Behind by more than a period, do not burst to catch up
+    _nextStreamNs += period * 1000000ULL;
+
+    if( _nextStreamNs < now )
+        _nextStreamNs = now + period * 1000000ULL;
+
+    for( vector<string>::const_iterator it = _history.begin(); it != _history.end(); ++it )
+    {
+        const string&     entry = *it;
+        unsigned int      node(0);
+        bool              can = entry[0] == '@';
+        string::size_type cmd = can ? 3 : 0;
+        string            value;
+
+        if( can )
+            node = (entry[1] - '0') * 10 + (entry[2] - '0');
+
+        char name[16] = { 0 };
+        sscanf(entry.c_str() + cmd + 1, "%15[A-Za-z$0-9]", name);
+
+        string key(name);
+
+        if( Answer(node, key, value, now) )
+        {
+            ++_stats.telemetry;
+            Reply(node, can, key + "=" + value, now);
+        }
+    }
+}
+
+void    RoboteqSim::Reply(unsigned int node, bool can, const string& text, uint64_t now)
+{
+    if( Chance(_config.dropPct) )
+    {
+        ++_stats.dropped;
+        return;
+    }
+
+    string frame;
+
+    if( can )
+    {
+        char address[4];
+        snprintf(address, sizeof(address), "@%02u", node);
+        frame = address;
+    }
+
+    frame += text;
+
+    // Garble one byte, never the terminator
+    if( Chance(_config.corruptPct) )
+    {
+        ++_stats.corrupted;
+        frame[rand_r(&_rand) % frame.size()] = 0x21 + rand_r(&_rand) % 94;
+    }
+
+    frame += '\r';
+
+    uint64_t due = now + _config.latencyUs * 1000ULL;
+
+    if( _config.jitterUs )
+        due += (rand_r(&_rand) % _config.jitterUs) * 1000ULL;
+
+    // Serial link never reorders
+    if( due < _lastDueNs )
+        due = _lastDueNs;
+
+    _lastDueNs = due;
+    _delayed.push_back( make_pair(due, frame) );
+
+    if( _logger.IsLogOpen() )
+        _logger.LogLine("RoboteqSim - out " + frame.substr(0, frame.size() - 1));
+}
+
+void    RoboteqSim::Flush(uint64_t now)
+{
+    if( Stalled(now) == false )
+    {
+        while( _delayed.empty() == false && _delayed.front().first <= now )
+        {
+            // Nobody reading, drop rather than grow without bound
+            if( _out.size() + _delayed.front().second.size() > MAX_OUTPUT )
+                ++_stats.overflow;
+            else
+                _out += _delayed.front().second;
+
+            _delayed.pop_front();
+        }
+    }
+
+    if( _out.empty() )
+        return;
+
+    int count = ::write(_fd, _out.data(), _out.size());
+
+    if( count > 0 )
+    {
+        _stats.bytesOut += count;
+        _out.erase(0, count);
+    }
+}
+
+bool    RoboteqSim::Stalled(uint64_t now) const
+{
+    return _config.stallMs && (now - _startNs) / 1000000ULL % 1000 < _config.stallMs;
+}
+
+bool    RoboteqSim::Chance(double pct)
+{
+    return pct > 0 && rand_r(&_rand) % 10000 < pct * 100;
+}
+
+uint64_t RoboteqSim::NextDueNs(uint64_t now) const
+{
+    uint64_t due = now + 100000000ULL;
+
+    if( _streamMs && _nextStreamNs < due )
+        due = _nextStreamNs;
+
+    if( _delayed.empty() == false )
+    {
+        uint64_t next = _delayed.front().first;
+
+        // Held frames go out when stall window ends
+        if( Stalled(now) )
+            next = _startNs + ((now - _startNs) / 1000000000ULL * 1000 + _config.stallMs) * 1000000ULL;
+
+        if( next < due )
+            due = next;
+    }
+
+    return due;
+}
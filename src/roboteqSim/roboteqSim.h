@@ -0,0 +1,140 @@
+#ifndef __ROBOTEQ_SIM_H__
+#define __ROBOTEQ_SIM_H__
+
+#include "serialLogger.h"
+#include <string>
+#include <deque>
+#include <vector>
+#include <utility>
+#include <stdint.h>
+
+// Roboteq controller simulator
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details at
+// http://www.gnu.org/copyleft/gpl.html
+
+using namespace std;
+using namespace oxoocoffee;
+
+// Plays a Roboteq controller (and RoboCAN nodes behind it) on pty
+// master fd. Speaks what RoboteqCom and the tools rely on:
+//
+//   ^ECHOF 1 / 0  echo off / on, every other "^" is acknowledged "+"
+//   ?$1E ?$1F     firmware id and model, ?FID ?TRN as well
+//   ?S ?BS ?A ?V ?T ?C ?FF   motor model values, unknown keys get "-"
+//   # C           query history cleared, every query is remembered
+//   # nn / #      history streamed every nn ms / streaming stopped
+//   !G ch v       motor command -1000..1000, !S ch rpm, !EX / !MG / !MS
+//   @NN           RoboCAN address prefix, replies carry it back
+//   a_b_c         '_' separated batch, every part answered on its own
+//
+// Each outgoing frame may be delayed, dropped or corrupted per Config
+class RoboteqSim
+{
+    public:
+        enum
+        {
+            MAX_NODES   = 100,      // @00 .. @99, 00 is local controller
+            MAX_HISTORY = 16,       // Queries remembered for "# nn"
+            MAX_OUTPUT  = 65536     // Unread output kept when nobody reads
+        };
+
+        struct Config
+        {
+            Config(void);
+
+            unsigned int    latencyUs;      // Command in to reply out
+            unsigned int    jitterUs;       // Uniform extra on top of latency
+            unsigned int    telemetryMs;    // Non zero overrides "# nn"
+            unsigned int    maxRpm;         // Speed at !G 1000
+            unsigned int    rampMs;         // Speed time constant
+            double          dropPct;        // Frames never sent
+            double          nackPct;        // Commands answered "-"
+            double          corruptPct;     // Frames with one byte garbled
+            unsigned int    stallMs;        // Output held this long every second
+            unsigned int    seed;
+            bool            echo;           // Echo on at power up, like real one
+            vector<bool>    nodes;          // RoboCAN nodes present, empty for all
+        };
+
+        struct Stats
+        {
+            Stats(void);
+
+            unsigned long   lines;
+            unsigned long   commands;
+            unsigned long   acks;
+            unsigned long   nacks;
+            unsigned long   queries;
+            unsigned long   telemetry;
+            unsigned long   dropped;
+            unsigned long   corrupted;
+            unsigned long   overflow;
+            unsigned long   bytesIn;
+            unsigned long   bytesOut;
+        };
+
+                 RoboteqSim(SerialLogger& log, const Config& config);
+
+                // Serves fd until Stop. fd is made non blocking
+        void    Run(int fd);
+        inline void          Stop(void) { _stop = true; }
+
+        inline const Stats&  GetStats(void) const { return _stats; }
+
+    private:
+        struct Motor
+        {
+            int     command;        // Last !G
+            double  rpm;            // Follows command with rampMs lag
+            double  counts;         // Encoder
+        };
+
+        struct Node
+        {
+            Motor   motor[2];
+            bool    estop;
+            uint64_t updatedNs;
+        };
+
+        void    Receive(const char* pData, unsigned int len, uint64_t now);
+        void    Line(const string& line, uint64_t now);
+        void    Command(unsigned int node, bool can, const string& cmd, uint64_t now);
+        bool    Answer(unsigned int node, string& key, string& value, uint64_t now);
+        void    Stream(uint64_t now);
+        void    Update(Node& node, uint64_t now);
+
+        void    Reply(unsigned int node, bool can, const string& text, uint64_t now);
+        void    Flush(uint64_t now);
+        bool    Stalled(uint64_t now) const;
+        bool    Chance(double pct);
+        uint64_t NextDueNs(uint64_t now) const;
+
+    private:
+        SerialLogger&   _logger;
+        Config          _config;
+        Stats           _stats;
+        volatile bool   _stop;
+        int             _fd;
+        unsigned int    _rand;
+        bool            _echo;
+        string          _line;
+        string          _out;
+        uint64_t        _lastDueNs;
+        deque< pair<uint64_t, string> > _delayed;
+        vector<string>  _history;
+        unsigned int    _streamMs;
+        uint64_t        _nextStreamNs;
+        uint64_t        _startNs;
+        Node            _nodes[MAX_NODES];
+};
+
+#endif // __ROBOTEQ_SIM_H__
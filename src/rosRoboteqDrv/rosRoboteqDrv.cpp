@@ -1,10 +1,13 @@
 #include "rosRoboteqDrv.h"
+#include "serialAsyncLogger.h"
+
+using namespace oxoocoffee::RoboteqCmd;
 
 typedef std::vector<std::string> TStrVec;
 void    Split(TStrVec& vec, const string& str);
 
 RosRoboteqDrv::RosRoboteqDrv(void)
- : _logEnabled(false), _comunicator(*this, *this)
+ : _logEnabled(false), _capture(), _replay(*this), _comunicator(*this, *this), _repliesDropped(0)
 {
 }
 
@@ -23,8 +26,21 @@ bool    RosRoboteqDrv::Initialize()
         std::transform(mode.begin(), mode.end(), mode.begin(), ::tolower);
 
         std::string device;
+        std::string replay;
+
+        // Optional. Capture file played back instead of a controller
+        if (ros::param::get("~replay", replay) && replay.empty() == false )
+        {
+            bool realTime(true);
 
-        if (ros::param::get("~device", device) == false )
+            ros::param::get("~replay_realtime", realTime);
+            ROS_INFO_STREAM_NAMED(NODE_NAME, "Replaying " << replay << (realTime ? " in real time" : " as fast as possible"));
+
+            _replay.setRealTime(realTime);
+            _comunicator.SetTransport(&_replay);
+            device = replay;
+        }
+        else if (ros::param::get("~device", device) == false )
         {
             ROS_FATAL_STREAM_NAMED(NODE_NAME, " Please specify device parameter");
             return false;
@@ -44,7 +60,12 @@ bool    RosRoboteqDrv::Initialize()
 
         ROS_INFO_STREAM_NAMED(NODE_NAME, "Channels Right: " << _right << ", Left: " << _left);
 
+        _leftChannel  = atoi(_left.c_str());
+        _rightChannel = atoi(_right.c_str());
+
         _pub = _nh.advertise<geometry_msgs::Twist>("current_velocity", 1); 
+        // Same velocity stamped with estimated controller sample time
+        _stampedPub = _nh.advertise<geometry_msgs::TwistStamped>("current_velocity_stamped", 1);
 
         _service = _nh.advertiseService("set_actuators", &RosRoboteqDrv::SetActuatorPosition, this); 
 //        _service = _nh.advertiseService("manual_CAN_command", &RosRoboteqDrv::ManualCANCommand, this);
@@ -53,6 +74,81 @@ bool    RosRoboteqDrv::Initialize()
         // not print diag msg from lower libs
         _logEnabled = true;
 
+        // Optional. Replies are handed off to spin thread instead of
+        // being processed on serial reader thread
+        int replySlots(0);
+
+        if (ros::param::get("~reply_queue", replySlots) && replySlots > 0 )
+        {
+            ROS_INFO_STREAM_NAMED(NODE_NAME, "Reply queue " << replySlots << " slots");
+            _comunicator.SetReplyQueue(replySlots);
+            _drainTimer = _nh.createTimer(ros::Duration(0.005), &RosRoboteqDrv::DrainTimerCallback, this);
+        }
+
+        // Optional. Callbacks only queue commands, writer thread sends them
+        int writerSlots(0);
+
+        if (ros::param::get("~writer_queue", writerSlots) && writerSlots > 0 )
+        {
+            ROS_INFO_STREAM_NAMED(NODE_NAME, "Writer queue " << writerSlots << " slots");
+            _comunicator.SetWriter(writerSlots);
+        }
+
+        // Optional. low_latency (default), throughput or default
+        std::string profile;
+
+        if (ros::param::get("~serial_profile", profile) && profile.empty() == false )
+        {
+            if( profile == "throughput" )
+                _comunicator.SetPortProfile(SerialPort::eProfile_Throughput);
+            else if( profile == "default" )
+                _comunicator.SetPortProfile(SerialPort::eProfile_Default);
+            else if( profile != "low_latency" )
+                ROS_WARN_STREAM_NAMED(NODE_NAME, "Unknown serial_profile " << profile << ", using low_latency");
+        }
+
+        // Optional. Line rate, 115200 when not given
+        int baud(0);
+
+        if (ros::param::get("~baud", baud) && baud > 0 )
+        {
+            ROS_INFO_STREAM_NAMED(NODE_NAME, "Serial baud " << baud);
+            _comunicator.SetBaud(baud);
+        }
+
+        // Optional. Fatal signal handler that puts buffered capture on
+        // disk before node dies. Off by default, signals are left alone
+        bool crashFlush(false);
+
+        if (ros::param::get("~crash_flush", crashFlush) && crashFlush )
+            SerialAsyncLogger::InstallCrashHandler();
+
+        // Optional. Every RX / TX chunk with timestamps, see SerialCapture
+        std::string capture;
+
+        if (ros::param::get("~capture", capture) && capture.empty() == false )
+        {
+            ROS_INFO_STREAM_NAMED(NODE_NAME, "Capturing serial traffic to " << capture);
+            _capture.Open(capture);
+            _comunicator.SetCapture(&_capture);
+        }
+
+        // Optional. debug, info (default), warn or error. debug traces
+        // every command and reply unless built with SERIAL_LOG_STRIP_DEBUG
+        std::string level;
+
+        if (ros::param::get("~log_level", level) && level.empty() == false )
+        {
+            if( level == "debug" )
+                SetLevel(eLevel_Debug);
+            else if( level == "warn" )
+                SetLevel(eLevel_Warn);
+            else if( level == "error" )
+                SetLevel(eLevel_Error);
+            else if( level != "info" )
+                ROS_WARN_STREAM_NAMED(NODE_NAME, "Unknown log_level " << level << ", using info");
+        }
+
         if( mode == "can" )
         	_comunicator.Open(RoboteqCom::eCAN, device);
         else
@@ -66,14 +162,38 @@ bool    RosRoboteqDrv::Initialize()
 
         if(_comunicator.IsThreadRunning() == false)
             THROW_RUNTIME_ERROR("Failed to spawn RoboReader Thread");
+
+        const SerialPort::ProfileReport& report = _comunicator.Port().profileReport();
+
+        ROS_INFO_STREAM_NAMED(NODE_NAME, "Serial profile " << report.profile
+                              << " ASYNC_LOW_LATENCY " << (report.serialInfo ? (report.lowLatency ? "on" : "off") : "n/a")
+                              << " gather " << report.gatherBytes << " bytes / " << report.gatherGapUs << " us");
+
+        // Optional. Joins commands issued within batch_us into one write
+        int batchUs(0);
+
+        if (ros::param::get("~batch_us", batchUs) && batchUs > 0 )
+        {
+            ROS_INFO_STREAM_NAMED(NODE_NAME, "Command batching window " << batchUs << " us");
+            _comunicator.SetBatching(batchUs);
+        }
+
+        // Optional. Safety commands overtake queued config and queries
+        bool scheduler(false);
+
+        if (ros::param::get("~scheduler", scheduler) && scheduler )
+        {
+            ROS_INFO_STREAM_NAMED(NODE_NAME, "Priority TX scheduler enabled");
+            _comunicator.SetScheduler(true);
+        }
         
-        _comunicator.IssueCommand("# C");   // Clears out telemetry strings
+        _comunicator.IssueCommand(Cmd<TelemetryClear>(0));      // Clears out telemetry strings
 
 	    if( _comunicator.Mode() == RoboteqCom::eSerial )
 	    {
-            _comunicator.IssueCommand("?S");    // Query for speed and enters this speed 
-                                            // request into telemetry system
-            _comunicator.IssueCommand("# 100"); // auto message response is 500ms
+            _comunicator.IssueCommand(Cmd<ReadSpeed>(0));       // Query for speed and enters this speed
+                                                                // request into telemetry system
+            _comunicator.IssueCommand(Cmd<TelemetryEvery>(0, 100)); // auto message response is 500ms
 	    }
 
         _sub = _nh.subscribe("cmd_vel", 1, &RosRoboteqDrv::CmdVelCallback, this);
@@ -95,31 +215,34 @@ void    RosRoboteqDrv::Shutdown(void)
 
 void    RosRoboteqDrv::XButtonCallback(const base_controller::Xbox_Button_Msg::ConstPtr& buttons)
 {
-    std::stringstream ss;
+    RoboteqCmdLine line;
 
     if( _comunicator.Mode() == RoboteqCom::eCAN )
     {
         if(buttons->a != 0)
         {
             ROS_INFO("--Going to DIG position--");
-            ss << "@04!G 1 900_@04!G 2 900";
+            Cmd<Go>(line, 4, 1, 900);
+            Cmd<Go>(line, 4, 2, 900);
         }
         else if(buttons->y != 0)
         {
             ROS_INFO("--Going to DUMP position--");
-            ss << "@04!G 1 -1000_@04!G 2 -1000";
+            Cmd<Go>(line, 4, 1, -1000);
+            Cmd<Go>(line, 4, 2, -1000);
         }
         else if(buttons->b != 0)
         {
             ROS_INFO("--Going to DRIVE position--");
-            ss << "@04!G 1 0_@04!G 2 0";
+            Cmd<Go>(line, 4, 1, 0);
+            Cmd<Go>(line, 4, 2, 0);
         }
     }
 
     try
     {
-        _comunicator.IssueCommand(ss.str());
-        ROS_INFO_STREAM("Actuator= " << ss.str());
+        ROS_INFO_STREAM("Actuator= " << line);
+        _comunicator.IssueCommand(line);
     }
     catch(std::exception& ex)
     {
@@ -142,63 +265,58 @@ void    RosRoboteqDrv::CmdVelCallback(const geometry_msgs::Twist::ConstPtr& twis
     float rightVelRPM = _wheelVelocity.right / RPM_TO_RAD_PER_SEC;
 
     // now round the wheel velocity to int
+    int leftCmd  = ((int)leftVelRPM)  * 100;
+    int rightCmd = ((int)rightVelRPM) * 100;
 
-    std::stringstream ss;
-
-    if( _comunicator.Mode() == RoboteqCom::eSerial )
-    {
-        ss << "!G " << _left << " " << (((int)leftVelRPM) * 100);
-        ss << "_!G " << _right << " " << (((int)rightVelRPM) * 100);
-    }
-    else
+    // Setpoint slots are latest wins. If link is still busy
+    // with previous command these replace what is not sent yet
+    try
     {
-       // ss << "@00!G " << _left << " " << (((int)leftVelRPM) * 100);
-       // ss << "_@00!G " << _right << " " << (((int)rightVelRPM) * 100);
-        
-        for( int i = 1; i <= 3; i++) // 3 is number of wheel pairs
+        if( _comunicator.Mode() == RoboteqCom::eSerial )
         {
-            if( i != 1 )
-                ss << "_";
-
-            ss <<  "@0" << i << "!G " << _left  << " " << (((int)leftVelRPM)  * 100);
-            ss << "_@0" << i << "!G " << _right << " " << (((int)rightVelRPM) * 100);
+            _comunicator.SetMotorSetpoint(0, _leftChannel,  leftCmd, false);
+            _comunicator.SetMotorSetpoint(0, _rightChannel, rightCmd);
+        }
+        else
+        {
+            for( int i = 1; i <= 3; i++) // 3 is number of wheel pairs
+            {
+                _comunicator.SetMotorSetpoint(i, _leftChannel,  leftCmd, false);
+                _comunicator.SetMotorSetpoint(i, _rightChannel, rightCmd, i == 3);
+            }
         }
-    }
 
-    try
-    {
-        _comunicator.IssueCommand(ss.str());
-        ROS_INFO_STREAM("Wheels= " << ss.str());
+        SERIAL_LOG_DEBUG(*this, "Wheels= " << leftCmd << " : " << rightCmd);
     }
     catch(std::exception& ex)
     {
-        ROS_ERROR_STREAM_NAMED(NODE_NAME,"IssueCommand : " << ex.what());
+        ROS_ERROR_STREAM_NAMED(NODE_NAME,"SetMotorSetpoint : " << ex.what());
 	    throw;
     }
     catch(...)
     {
-        ROS_ERROR_STREAM_NAMED(NODE_NAME,"IssueCommand : ?");
+        ROS_ERROR_STREAM_NAMED(NODE_NAME,"SetMotorSetpoint : ?");
 	    throw;
     }
 }
 
 bool RosRoboteqDrv::SetActuatorPosition(TSrvAct_Req &req, TSrvAct_Res &res)
 {
-    std::stringstream ss;
+    RoboteqCmdLine line;
 
     if( _comunicator.Mode() == RoboteqCom::eCAN )
     {
-        ss << "@04!G 1 " << req.actuator_position;
-        ss << "_@04!G 2 " << req.actuator_position;
+        Cmd<Go>(line, 4, 1, req.actuator_position);
+        Cmd<Go>(line, 4, 2, req.actuator_position);
 
-        // ss << "@00!G 1 " << req.actuator_position;
-        // ss << "_@00!G 2 " << req.actuator_position;
+        // Cmd<Go>(line, 0, 1, req.actuator_position);
+        // Cmd<Go>(line, 0, 2, req.actuator_position);
     }
 
     try
     {
-        _comunicator.IssueCommand(ss.str());
-        ROS_INFO_STREAM("Actr= " << ss.str());
+        ROS_INFO_STREAM("Actr= " << line);
+        _comunicator.IssueCommand(line);
     }
     catch(std::exception& ex)
     {
@@ -215,17 +333,17 @@ bool RosRoboteqDrv::SetActuatorPosition(TSrvAct_Req &req, TSrvAct_Res &res)
 
 bool RosRoboteqDrv::ManualCANCommand(TSrvCAN_Req &req, TSrvCAN_Res &res)
 {
-    std::stringstream ss;
+    RoboteqCmdLine line;
 
     if( _comunicator.Mode() == RoboteqCom::eCAN )
     {
-        ss << "@0" << req.can_id  << "!G " << req.channel << " " << req.speed;
+        Cmd<Go>(line, req.can_id, req.channel, req.speed);
     }
 
     try
     {
-        _comunicator.IssueCommand(ss.str());
-        ROS_INFO_STREAM("ManualCMD= " << ss.str());
+        ROS_INFO_STREAM("ManualCMD= " << line);
+        _comunicator.IssueCommand(line);
     }
     catch(std::exception& ex)
     {
@@ -267,15 +385,49 @@ roboteq_node::wheels_msg RosRoboteqDrv::ConvertTwistToWheelVelocity(const geomet
     return wheelVelocity;
 }
 
+void    RosRoboteqDrv::DrainTimerCallback(const ros::TimerEvent&)
+{
+    _comunicator.DrainReplies();
+
+    RoboteqReplyRing::Stats stats;
+
+    if( _comunicator.GetReplyQueueStats(stats) && stats.dropped != _repliesDropped )
+    {
+        ROS_WARN_STREAM_NAMED(NODE_NAME, "Reply queue dropped " << stats.dropped - _repliesDropped
+                              << " replies. high water " << stats.highWater << "/" << stats.capacity);
+        _repliesDropped = stats.dropped;
+    }
+}
+
 // RoboteqCom Events
 void    RosRoboteqDrv::OnMsgEvent(const IEventArgs& evt)
 {
 	ROS_DEBUG_STREAM_NAMED(NODE_NAME, "OnMsgEvent: " << evt.Reply());
 
-	switch( evt.Reply()[0] )
+	RoboteqTelemetry::Reply reply;
+
+	if( RoboteqTelemetry::Parse(evt.Data(), evt.Length(), reply) )
+	{
+		switch( reply.key )
+		{
+			case RoboteqTelemetry::eKey_S:
+				Process_S( reply, evt.Stamp() );
+			break;
+
+			default:
+			break;
+		}
+
+		return;
+	}
+
+	if( evt.Length() == 0 )
+		return;
+
+	switch( evt.Data()[0] )
 	{
 		case 'S':
-			Process_S( evt );
+			ROS_ERROR_STREAM_NAMED(NODE_NAME,"Invalid S Reply Format");
 		break;
 
 		case 'G':
@@ -288,58 +440,36 @@ void    RosRoboteqDrv::OnMsgEvent(const IEventArgs& evt)
 
 		default:
 		break;
-			
 	}
 }
 
-void	RosRoboteqDrv::Process_S(const IEventArgs& evt)
+void	RosRoboteqDrv::Process_S(const RoboteqTelemetry::Reply& reply, const RxStamp& stamp)
 {
-	try
-    {
-      	string::size_type idx = evt.Reply().find_first_of('=');
+	if( reply.count < 2 )
+	{
+		ROS_ERROR_STREAM_NAMED(NODE_NAME,"Invalid(2) S Reply Format");
+		return;
+	}
 
-        if( idx != string::npos )
-        {
-                //idx++;
-                string::size_type idy = evt.Reply().find_first_of(':', idx);
+	roboteq_node::wheels_msg wheelVelocity;
 
-                if( idy != string::npos )
-                {
-                        char* pVal1 = (char*)(evt.Reply().c_str() + idx + 1);
-                        char* pVal2 = (char*)(evt.Reply().c_str() + idy);
+	wheelVelocity.right 	= reply.values[0] * RPM_TO_RAD_PER_SEC;
+	wheelVelocity.left		= reply.values[1] * RPM_TO_RAD_PER_SEC;
 
-                        *pVal2 = 0L;
-                        pVal2++;
+	geometry_msgs::TwistStamped stamped;
 
-                        int firstVal  = atoi( pVal1 );
-                        int secondVal = atoi( pVal2 );
+	stamped.twist = RosRoboteqDrv::ConvertWheelVelocityToTwist(wheelVelocity.left, wheelVelocity.right);
+	stamped.header.stamp = ros::Time::now();
 
-			            roboteq_node::wheels_msg wheelVelocity;
+	// Move from monotonic clock to ROS time by age of sample. Unknown
+	// (0) or future stamp keeps receive time
+	uint64_t nowNs = SerialClock::NowNs();
 
-			            wheelVelocity.right 	= firstVal  * RPM_TO_RAD_PER_SEC;
-			            wheelVelocity.left		= secondVal * RPM_TO_RAD_PER_SEC;
+	if( stamp.sampleNs != 0 && stamp.sampleNs <= nowNs )
+		stamped.header.stamp = stamped.header.stamp - ros::Duration((nowNs - stamp.sampleNs) / 1e9);
 
-                        _pub.publish(RosRoboteqDrv::ConvertWheelVelocityToTwist(wheelVelocity.left, wheelVelocity.right));
-                        //ROS_INFO_STREAM("Wheel RPM's: " << firstVal << " :: " << secondVal);
-                }
-                else
-		        {
-                  	ROS_ERROR_STREAM_NAMED(NODE_NAME,"Invalid(2) S Reply Format");
-		        }
-        }
-        else
-	    {
-                ROS_ERROR_STREAM_NAMED(NODE_NAME,"Invalid(1) S Reply Format");
-	    }
-	}
-	catch(std::exception& ex)
-	{
-		ROS_ERROR_STREAM_NAMED(NODE_NAME,"Process_S : " << ex.what());
-	}
-	catch(...)
-	{
-		ROS_ERROR_STREAM_NAMED(NODE_NAME,"Process_S : ?");
-	}
+	_pub.publish(stamped.twist);
+	_stampedPub.publish(stamped);
 }
 
 void    RosRoboteqDrv::Process_G(const IEventArgs& evt)
@@ -357,6 +487,17 @@ bool    RosRoboteqDrv::IsLogOpen(void) const
     return _logEnabled;
 }
 
+void    RosRoboteqDrv::LogLineAt(eLevel level, const std::string& message)
+{
+    switch( level )
+    {
+        case eLevel_Debug:  ROS_DEBUG_STREAM_NAMED(NODE_NAME," - " << message); break;
+        case eLevel_Info:   ROS_INFO_STREAM_NAMED(NODE_NAME," - " << message);  break;
+        case eLevel_Warn:   ROS_WARN_STREAM_NAMED(NODE_NAME," - " << message);  break;
+        default:            ROS_ERROR_STREAM_NAMED(NODE_NAME," - " << message); break;
+    }
+}
+
 // RoboteqCom and app Log Messages. Do append newline
 void    RosRoboteqDrv::LogLine(const char* pBuffer, unsigned int len)
 {
@@ -2,9 +2,14 @@
 #define __ROBOTEQ_DRV_H__
 
 #include "roboteqCom.h"
+#include "roboteqTelemetry.h"
+#include "serialCapture.h"
+#include "serialReplayPort.h"
 #include "ros/ros.h"
 #include <geometry_msgs/Twist.h>    // Twist message file
+#include <geometry_msgs/TwistStamped.h>
 #include <string>
+#include <stdlib.h>
 #include <roboteq_node/wheels_msg.h>
 #include <roboteq_node/Actuators.h>
 #include <roboteq_node/SendCANCommand.h>
@@ -68,6 +73,7 @@ class RosRoboteqDrv : public SerialLogger, public IEventListener<const IEventArg
         void        Shutdown(void);
         void        CmdVelCallback(const TTwist::ConstPtr& twist_velocity);
         void        XButtonCallback(const base_controller::Xbox_Button_Msg::ConstPtr& buttons);
+        void        DrainTimerCallback(const ros::TimerEvent& event);
         bool        SetActuatorPosition(TSrvAct_Req &req,
                                         TSrvAct_Res &res);
         bool        ManualCANCommand(TSrvCAN_Req &req, 
@@ -85,6 +91,9 @@ class RosRoboteqDrv : public SerialLogger, public IEventListener<const IEventArg
 
         virtual bool    IsLogOpen(void) const;
 
+        // Maps SERIAL_LOG levels onto ROS severities
+        virtual void    LogLineAt(eLevel level, const std::string& message);
+
         // Does write new line at the end 
         virtual void    LogLine(const char* pBuffer, unsigned int len);
         virtual void    LogLine(const std::string& message);
@@ -93,20 +102,27 @@ class RosRoboteqDrv : public SerialLogger, public IEventListener<const IEventArg
         virtual void    Log(const char* pBuffer, unsigned int len);
         virtual void    Log(const std::string& message);
 
-	void    Process_S(const IEventArgs& evt);
+	void    Process_S(const RoboteqTelemetry::Reply& reply, const RxStamp& stamp);
 	void    Process_G(const IEventArgs& evt);
         void    Process_N(const IEventArgs& evt);
 
     private:
         bool                _logEnabled;
+        SerialCapture       _capture;       // Outlive _comunicator
+        SerialReplayPort    _replay;
         RoboteqCom          _comunicator;
         ros::Subscriber     _sub;
         ros::Subscriber     _buttonSub;
         ros::Publisher      _pub;
+        ros::Publisher      _stampedPub;
         ros::ServiceServer  _service;
+        ros::Timer          _drainTimer;
+        unsigned long       _repliesDropped;
         TWheelMsg           _wheelVelocity;
         std::string         _left;
         std::string         _right;
+        int                 _leftChannel;
+        int                 _rightChannel;
 };
 
 #endif // __ROBOTEQ_DRV_H__
@@ -0,0 +1,402 @@
+#include "serialAsyncLogger.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace oxoocoffee
+{
+
+#define MAX_CRASH_LOGGERS   4
+
+static const int                            gFatalSignals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+static const int                            gFatalCount = sizeof(gFatalSignals) / sizeof(gFatalSignals[0]);
+static struct sigaction                     gPrevActions[gFatalCount];
+static std::atomic<bool>                    gHandlerInstalled(false);
+static std::atomic<SerialAsyncLogger*>      gCrashLoggers[MAX_CRASH_LOGGERS];
+
+struct CrashFlush
+{
+    std::atomic<void (*)(void*)>    fn;
+    std::atomic<void*>              arg;
+};
+
+static CrashFlush                           gCrashFlushes[SerialAsyncLogger::CRASH_FLUSHES];
+
+static void     InstallSignalHandlers(void (*pHandler)(int))
+{
+    if( gHandlerInstalled.exchange(true) )
+        return;
+
+    struct sigaction action;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = pHandler;
+    sigemptyset(&action.sa_mask);
+
+    for( int Idx(0); Idx < gFatalCount; Idx++ )
+        ::sigaction(gFatalSignals[Idx], &action, &gPrevActions[Idx]);
+}
+
+// Decimal digits of value at pOut, returns end. No locale, no stdio, so
+// it is safe in the fatal signal path
+static char*    FormatULong(char* pOut, unsigned long value)
+{
+    char            digits[20];
+    unsigned int    len(0);
+
+    do
+    {
+        digits[len++] = '0' + value % 10;
+        value /= 10;
+    }
+    while( value != 0 );
+
+    while( len != 0 )
+        *pOut++ = digits[--len];
+
+    return pOut;
+}
+
+SerialAsyncLogger::SerialAsyncLogger(unsigned int slots)
+ : _slots(0L), _mask(0), _head(0), _tail(0), _draining(false), _fd(-1),
+   _policy(eDrop_Newest), _thread(), _stop(false), _batchLen(0),
+   _lines(0), _dropped(0), _truncated(0), _reported(0), _writes(0)
+{
+    size_t count(1);
+
+    while( count < slots )
+        count <<= 1;
+
+    _slots = new Slot[count];
+    _mask  = count - 1;
+
+    for( size_t Idx(0); Idx < count; Idx++ )
+        _slots[Idx].seq.store(Idx, std::memory_order_relaxed);
+}
+
+SerialAsyncLogger::~SerialAsyncLogger(void)
+{
+    Close();
+    delete [] _slots;
+}
+
+bool    SerialAsyncLogger::Open(const string& filePath)
+{
+    Close();
+
+    _fd = ::open(filePath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+
+    if( _fd == -1 )
+        return false;
+
+    _stop = false;
+
+    if( ::pthread_create(&_thread, 0L, ThreadFn, this) != 0 )
+    {
+        ::close(_fd);
+        _fd = -1;
+        return false;
+    }
+
+    // Fatal signal handler, if installed, drains whatever is registered here
+    for( int Idx(0); Idx < MAX_CRASH_LOGGERS; Idx++ )
+    {
+        SerialAsyncLogger* pEmpty(0L);
+
+        if( gCrashLoggers[Idx].compare_exchange_strong(pEmpty, this) )
+            break;
+    }
+
+    LogLine("+++++++++ Opened ++++++++");
+
+    return true;
+}
+
+void    SerialAsyncLogger::Close(void)
+{
+    if( _fd == -1 )
+        return;
+
+    LogLine("--------- Closed --------");
+
+    _stop = true;
+    ::pthread_join(_thread, 0L);
+
+    for( int Idx(0); Idx < MAX_CRASH_LOGGERS; Idx++ )
+    {
+        SerialAsyncLogger* pThis(this);
+
+        gCrashLoggers[Idx].compare_exchange_strong(pThis, 0L);
+    }
+
+    // Flusher is gone, rest is ours
+    Drain();
+
+    ::close(_fd);
+    _fd = -1;
+}
+
+void    SerialAsyncLogger::LogLine(const char* pBuffer, unsigned int len)
+{
+    if( _fd != -1 )
+        Push(pBuffer, len, true);
+}
+
+void    SerialAsyncLogger::LogLine(const std::string& message)
+{
+    if( _fd != -1 )
+        Push(message.data(), message.size(), true);
+}
+
+void    SerialAsyncLogger::Log(const char* pBuffer, unsigned int len)
+{
+    if( _fd != -1 )
+        Push(pBuffer, len, false);
+}
+
+void    SerialAsyncLogger::Log(const std::string& message)
+{
+    if( _fd != -1 )
+        Push(message.data(), message.size(), false);
+}
+
+// Bounded MPMC slot queue (sequence per slot). Producer owns slot
+// after winning CAS on _head and publishes it with seq = pos + 1
+void    SerialAsyncLogger::Push(const char* pBuffer, unsigned int len, bool newline)
+{
+    size_t pos = _head.load(std::memory_order_relaxed);
+    Slot*  pSlot;
+
+    while( true )
+    {
+        pSlot = &_slots[pos & _mask];
+
+        size_t    seq  = pSlot->seq.load(std::memory_order_acquire);
+        ptrdiff_t diff = (ptrdiff_t)seq - (ptrdiff_t)pos;
+
+        if( diff == 0 )
+        {
+            if( _head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed) )
+                break;
+        }
+        else if( diff < 0 )
+        {
+            // Full
+            if( _policy == eDrop_Newest || _stop )
+            {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            sched_yield();
+            pos = _head.load(std::memory_order_relaxed);
+        }
+        else
+            pos = _head.load(std::memory_order_relaxed);
+    }
+
+    if( len > SLOT_DATA )
+    {
+        len = SLOT_DATA;
+        _truncated.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    memcpy(pSlot->data, pBuffer, len);
+    pSlot->len     = len;
+    pSlot->newline = newline;
+    pSlot->seq.store(pos + 1, std::memory_order_release);
+
+    _lines.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Single consumer. Flusher, Close after join, or crash handler
+bool    SerialAsyncLogger::Drain(void)
+{
+    bool any(false);
+
+    while( true )
+    {
+        Slot*  pSlot = &_slots[_tail & _mask];
+        size_t seq   = pSlot->seq.load(std::memory_order_acquire);
+
+        if( seq != _tail + 1 )
+            break;
+
+        if( _batchLen + pSlot->len + 1 > sizeof(_batch) )
+            WriteOut(_batch, _batchLen);
+
+        memcpy(_batch + _batchLen, pSlot->data, pSlot->len);
+        _batchLen += pSlot->len;
+
+        if( pSlot->newline )
+            _batch[_batchLen++] = '\n';
+
+        // Free for producer that comes around next lap
+        pSlot->seq.store(_tail + _mask + 1, std::memory_order_release);
+        ++_tail;
+        any = true;
+    }
+
+    unsigned long dropped = _dropped.load(std::memory_order_relaxed);
+
+    if( dropped != _reported && sizeof(_batch) - _batchLen >= 64 )
+    {
+        static const char   head[] = "--------- Logger dropped ";
+        static const char   tail[] = " lines --------\n";
+
+        char* pOut = _batch + _batchLen;
+
+        memcpy(pOut, head, sizeof(head) - 1);
+        pOut = FormatULong(pOut + sizeof(head) - 1, dropped - _reported);
+        memcpy(pOut, tail, sizeof(tail) - 1);
+
+        _batchLen  = pOut + sizeof(tail) - 1 - _batch;
+        _reported  = dropped;
+    }
+
+    if( _batchLen != 0 )
+        WriteOut(_batch, _batchLen);
+
+    return any;
+}
+
+void    SerialAsyncLogger::WriteOut(const char* pBuffer, unsigned int len)
+{
+    unsigned int done(0);
+
+    while( done < len )
+    {
+        int ret = ::write(_fd, pBuffer + done, len - done);
+
+        if( ret < 0 && errno == EINTR )
+            continue;
+
+        if( ret <= 0 )
+            break;      // Disk full or alike. Nothing sensible left to do
+
+        done += ret;
+    }
+
+    _writes.fetch_add(1, std::memory_order_relaxed);
+    _batchLen = 0;
+}
+
+void    SerialAsyncLogger::InstallCrashHandler(void)
+{
+    InstallSignalHandlers(OnFatalSignal);
+}
+
+bool    SerialAsyncLogger::AddCrashFlush(void (*pFn)(void*), void* pArg)
+{
+    for( int Idx(0); Idx < CRASH_FLUSHES; Idx++ )
+    {
+        void* pEmpty(0L);
+
+        // Argument claims the entry, handler skips it until fn is set
+        if( gCrashFlushes[Idx].arg.compare_exchange_strong(pEmpty, pArg) )
+        {
+            gCrashFlushes[Idx].fn.store(pFn);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void    SerialAsyncLogger::RemoveCrashFlush(void* pArg)
+{
+    for( int Idx(0); Idx < CRASH_FLUSHES; Idx++ )
+    {
+        if( gCrashFlushes[Idx].arg.load() == pArg )
+        {
+            gCrashFlushes[Idx].fn.store(0L);
+            gCrashFlushes[Idx].arg.store(0L);
+        }
+    }
+}
+
+void*   SerialAsyncLogger::ThreadFn(void* ptr)
+{
+    ((SerialAsyncLogger*)ptr)->Flusher();
+    return 0L;
+}
+
+void    SerialAsyncLogger::Flusher(void)
+{
+    long napUs(FLUSH_MS * 1000);
+
+    while( _stop == false )
+    {
+        bool any(false);
+
+        if( _draining.exchange(true, std::memory_order_acquire) == false )
+        {
+            any = Drain();
+            _draining.store(false, std::memory_order_release);
+        }
+
+        // Short naps while lines keep coming so burst does not fill
+        // the ring, back off to FLUSH_MS when quiet
+        if( any )
+            napUs = 100;
+        else if( (napUs *= 2) > FLUSH_MS * 1000 )
+            napUs = FLUSH_MS * 1000;
+
+        timespec nap = { 0, napUs * 1000 };
+
+        ::nanosleep(&nap, 0L);
+    }
+}
+
+// Only async signal safe calls from here on
+void    SerialAsyncLogger::OnFatalSignal(int sig)
+{
+    for( int Idx(0); Idx < MAX_CRASH_LOGGERS; Idx++ )
+    {
+        SerialAsyncLogger* pLogger = gCrashLoggers[Idx].load();
+
+        if( pLogger == 0L || pLogger->_fd == -1 )
+            continue;
+
+        // Flusher may be mid batch on another thread. If it does not let
+        // go it is probably the one that crashed with _tail / _batch half
+        // updated. Draining over that could write garbage or loop, so
+        // that logger loses its tail instead
+        bool owned(false);
+
+        for( int spin(0); spin < 1000 && owned == false; spin++ )
+        {
+            if( pLogger->_draining.exchange(true, std::memory_order_acquire) == false )
+                owned = true;
+            else
+                sched_yield();
+        }
+
+        if( owned )
+            pLogger->Drain();
+    }
+
+    for( int Idx(0); Idx < CRASH_FLUSHES; Idx++ )
+    {
+        void (*pFn)(void*) = gCrashFlushes[Idx].fn.load();
+        void*  pArg        = gCrashFlushes[Idx].arg.load();
+
+        if( pFn != 0L && pArg != 0L )
+            pFn(pArg);
+    }
+
+    for( int Idx(0); Idx < gFatalCount; Idx++ )
+    {
+        if( gFatalSignals[Idx] == sig )
+            ::sigaction(sig, &gPrevActions[Idx], 0L);
+    }
+
+    ::raise(sig);
+}
+
+}   // End of oxoocoffee namespace
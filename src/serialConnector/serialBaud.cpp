@@ -0,0 +1,67 @@
+#include "serialBaud.h"
+#include <errno.h>
+
+#if defined(__linux__)
+#include <asm/termbits.h>
+#include <sys/ioctl.h>
+#endif
+
+namespace oxoocoffee
+{
+
+#if defined(__linux__)
+
+bool    SerialBaud::IsSupported(void)
+{
+    return true;
+}
+
+bool    SerialBaud::Set(int fd, unsigned int rate)
+{
+    struct termios2 options;
+
+    if( ::ioctl(fd, TCGETS2, &options) != 0 )
+        return false;
+
+    options.c_cflag &= ~(CBAUD | (CBAUD << IBSHIFT));
+    options.c_cflag |= BOTHER | (BOTHER << IBSHIFT);
+    options.c_ispeed = rate;
+    options.c_ospeed = rate;
+
+    return ::ioctl(fd, TCSETS2, &options) == 0;
+}
+
+bool    SerialBaud::Get(int fd, unsigned int& rate)
+{
+    struct termios2 options;
+
+    if( ::ioctl(fd, TCGETS2, &options) != 0 )
+        return false;
+
+    rate = options.c_ospeed;
+
+    return true;
+}
+
+#else
+
+bool    SerialBaud::IsSupported(void)
+{
+    return false;
+}
+
+bool    SerialBaud::Set(int, unsigned int)
+{
+    errno = ENOTSUP;
+    return false;
+}
+
+bool    SerialBaud::Get(int, unsigned int&)
+{
+    errno = ENOTSUP;
+    return false;
+}
+
+#endif
+
+}   // End of oxoocoffee namespace
@@ -0,0 +1,304 @@
+#include "serialCapture.h"
+#include "serialClock.h"
+#include "serialAsyncLogger.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace oxoocoffee
+{
+
+static const char  CAPTURE_MAGIC[4] = { 'R', 'C', 'A', 'P' };
+
+struct CaptureHeader
+{
+    char        magic[4];
+    uint32_t    version;
+    uint64_t    monoNs;
+    uint64_t    wallNs;
+};
+
+SerialCapture::SerialCapture(void)
+ : _fd(-1), _startNs(0), _flushNs(0), _len(0), _busy(false), _records(0), _errors(0)
+{
+    ::pthread_mutex_init(&_mtx, 0L);
+}
+
+SerialCapture::~SerialCapture(void)
+{
+    Close();
+    ::pthread_mutex_destroy(&_mtx);
+}
+
+void    SerialCapture::Open(const string& path)
+{
+    Close();
+
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+    if( fd == -1 )
+        THROW_RUNTIME_ERROR("SerialCapture - can not create " << path << " errno: " << errno);
+
+    timespec      wall;
+    CaptureHeader header;
+
+    ::clock_gettime(CLOCK_REALTIME, &wall);
+
+    memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.monoNs  = SerialClock::NowNs();
+    header.wallNs  = SerialClock::ToNs(wall);
+
+    if( WriteOut(fd, (const char*)&header, sizeof(header)) == false )
+    {
+        int err = errno;
+
+        ::close(fd);
+        THROW_RUNTIME_ERROR("SerialCapture - can not write " << path << " errno: " << err);
+    }
+
+    ::pthread_mutex_lock(&_mtx);
+    _fd      = fd;
+    _startNs = header.monoNs;
+    _flushNs = header.monoNs;
+    _len     = 0;
+    _records = 0;
+    _errors  = 0;
+    ::pthread_mutex_unlock(&_mtx);
+
+    // Full when several captures are open, those only lose buffered tail
+    SerialAsyncLogger::AddCrashFlush(OnCrash, this);
+}
+
+void    SerialCapture::Close(void)
+{
+    SerialAsyncLogger::RemoveCrashFlush(this);
+
+    ::pthread_mutex_lock(&_mtx);
+
+    if( _fd != -1 )
+    {
+        while( _busy.exchange(true, std::memory_order_acquire) )
+            sched_yield();
+
+        FlushLocked();
+        ::close(_fd);
+
+        _busy.store(false, std::memory_order_release);
+    }
+
+    _fd = -1;
+
+    ::pthread_mutex_unlock(&_mtx);
+}
+
+void    SerialCapture::Write(eDir dir, const char* pData, unsigned int len)
+{
+    if( _fd == -1 || len == 0 )
+        return;
+
+    // Longer chunks are split so Load can bound every record
+    while( len > MAX_RECORD )
+    {
+        Write(dir, pData, MAX_RECORD);
+        pData += MAX_RECORD;
+        len   -= MAX_RECORD;
+    }
+
+    uint64_t now = SerialClock::NowNs();
+
+    ::pthread_mutex_lock(&_mtx);
+
+    if( _fd != -1 )
+    {
+        uint64_t ns     = now - _startNs;
+        uint32_t length = len | (dir == eDir_TX ? (uint32_t)TX_FLAG : 0);
+
+        // Only contender under _mtx is crash handler on another thread
+        while( _busy.exchange(true, std::memory_order_acquire) )
+            sched_yield();
+
+        if( _len + sizeof(ns) + sizeof(length) + len > sizeof(_buf) )
+            FlushLocked();
+
+        Append(&ns, sizeof(ns));
+        Append(&length, sizeof(length));
+
+        if( len > sizeof(_buf) - _len )
+        {
+            // Does not fit even empty buffer, data goes out directly
+            FlushLocked();
+
+            if( WriteOut(_fd, pData, len) == false )
+                ++_errors;
+        }
+        else
+            Append(pData, len);
+
+        ++_records;
+
+        if( now - _flushNs >= FLUSH_MS * 1000000ULL )
+            FlushLocked();
+
+        _busy.store(false, std::memory_order_release);
+    }
+
+    ::pthread_mutex_unlock(&_mtx);
+}
+
+void    SerialCapture::Append(const void* pData, unsigned int len)
+{
+    memcpy(_buf + _len, pData, len);
+    _len += len;
+}
+
+uint64_t SerialCapture::FlushDueNs(void)
+{
+    ::pthread_mutex_lock(&_mtx);
+
+    uint64_t due = (_fd != -1 && _len != 0) ? _flushNs + FLUSH_MS * 1000000ULL : 0;
+
+    ::pthread_mutex_unlock(&_mtx);
+
+    return due;
+}
+
+void    SerialCapture::Flush(void)
+{
+    ::pthread_mutex_lock(&_mtx);
+
+    if( _fd != -1 )
+    {
+        while( _busy.exchange(true, std::memory_order_acquire) )
+            sched_yield();
+
+        FlushLocked();
+
+        _busy.store(false, std::memory_order_release);
+    }
+
+    ::pthread_mutex_unlock(&_mtx);
+}
+
+// Called with _mtx held and _busy taken
+void    SerialCapture::FlushLocked(void)
+{
+    if( _len != 0 && WriteOut(_fd, _buf, _len) == false )
+        ++_errors;
+
+    _len     = 0;
+    _flushNs = SerialClock::NowNs();
+}
+
+bool    SerialCapture::WriteOut(int fd, const char* pData, unsigned int len)
+{
+    unsigned int done(0);
+
+    while( done < len )
+    {
+        int ret = ::write(fd, pData + done, len - done);
+
+        if( ret < 0 && errno == EINTR )
+            continue;
+
+        if( ret <= 0 )
+            return false;
+
+        done += ret;
+    }
+
+    return true;
+}
+
+// Fatal signal path, only async signal safe calls. Thread that crashed
+// inside Write keeps _busy, its buffer is then left alone
+void    SerialCapture::OnCrash(void* ptr)
+{
+    SerialCapture* pThis = (SerialCapture*)ptr;
+
+    for( int spin(0); spin < 1000; spin++ )
+    {
+        if( pThis->_busy.exchange(true, std::memory_order_acquire) == false )
+        {
+            if( pThis->_fd != -1 && pThis->_len != 0 )
+                WriteOut(pThis->_fd, pThis->_buf, pThis->_len);
+
+            pThis->_len = 0;
+            return;
+        }
+
+        sched_yield();
+    }
+}
+
+static bool ReadHeader(FILE* pFile)
+{
+    CaptureHeader header;
+
+    return ::fread(&header, sizeof(header), 1, pFile) == 1 &&
+           memcmp(header.magic, CAPTURE_MAGIC, sizeof(header.magic)) == 0 &&
+           header.version == SerialCapture::VERSION;
+}
+
+void    SerialCapture::Load(const string& path, vector<Record>& records)
+{
+    FILE* pFile = ::fopen(path.c_str(), "rb");
+
+    if( pFile == 0L )
+        THROW_RUNTIME_ERROR("SerialCapture - can not open " << path);
+
+    if( ReadHeader(pFile) == false )
+    {
+        ::fclose(pFile);
+        THROW_RUNTIME_ERROR("SerialCapture - not a capture file " << path);
+    }
+
+    records.clear();
+
+    Record      record;
+    uint32_t    length;
+
+    // Partial record at end (process killed mid write) is dropped
+    while( ::fread(&record.ns, sizeof(record.ns), 1, pFile) == 1 &&
+           ::fread(&length, sizeof(length), 1, pFile) == 1 )
+    {
+        record.dir = (length & TX_FLAG) ? eDir_TX : eDir_RX;
+        length    &= ~(uint32_t)TX_FLAG;
+
+        // Corrupt length must not turn into a huge allocation
+        if( length > MAX_RECORD )
+        {
+            ::fclose(pFile);
+            THROW_RUNTIME_ERROR("SerialCapture - corrupt record length " << length << " in " << path);
+        }
+
+        record.data.resize(length);
+
+        if( record.data.empty() == false &&
+            ::fread(&record.data[0], record.data.size(), 1, pFile) != 1 )
+            break;
+
+        records.push_back(record);
+    }
+
+    ::fclose(pFile);
+}
+
+bool    SerialCapture::IsCapture(const string& path)
+{
+    FILE* pFile = ::fopen(path.c_str(), "rb");
+
+    if( pFile == 0L )
+        return false;
+
+    bool capture = ReadHeader(pFile);
+
+    ::fclose(pFile);
+
+    return capture;
+}
+
+}   // End of oxoocoffee namespace
@@ -5,7 +5,12 @@ CONFIG -= qt
 
 SOURCES += main.cpp \
     serialNetPort.cpp \
-    serialPort.cpp
+    serialPtyPort.cpp \
+    serialReplayPort.cpp \
+    serialCapture.cpp \
+    serialAsyncLogger.cpp \
+    serialPort.cpp \
+    serialBaud.cpp
 
 include(deployment.pri)
 qtcAddDeployment()
@@ -15,5 +20,11 @@ INCLUDEPATH += $$PWD/../../include/
 HEADERS += \
     serialException.h \
     ../../include/serialLogger.h \
+    ../../include/serialTransport.h \
     ../../include/serialNetPort.h \
-    ../../include/serialPort.h
+    ../../include/serialPtyPort.h \
+    ../../include/serialReplayPort.h \
+    ../../include/serialCapture.h \
+    ../../include/serialAsyncLogger.h \
+    ../../include/serialPort.h \
+    ../../include/serialBaud.h
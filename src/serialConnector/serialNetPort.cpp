@@ -1,35 +1,125 @@
 #include "serialNetPort.h"
 #include <sstream>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 
 namespace oxoocoffee
 {
 
 SerialNetPort::SerialNetPort(SerialLogger& log)
- : _logger(log)
+ : _logger(log), _fd(-1), _lineRate(0)
 {
 }
 
 SerialNetPort::~SerialNetPort(void)
 {
+    disconnect();
 }
 
 bool    SerialNetPort::isOpen(void) const
 {
-    return false;
+    return _fd != -1;
 }
 
 void    SerialNetPort::connect(const string& host, unsigned short port)
 {
-    ostringstream msg;
-    msg << "SerialNetPort::connect " << host << ":" << port;
+    if( isOpen() )
+        disconnect();
 
-    _logger.Log( msg.str() );
+    SERIAL_LOG_INFO(_logger, "SerialNetPort - connecting " << host << ":" << port);
+
+    addrinfo  hints;
+    addrinfo* pList(0L);
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    ostringstream service; service << port;
+
+    int ret = ::getaddrinfo(host.c_str(), service.str().c_str(), &hints, &pList);
+
+    if( ret != 0 )
+        THROW_RUNTIME_ERROR("SerialNetPort - can not resolve " << host << ": " << gai_strerror(ret));
+
+    int err(0);
+
+    for( addrinfo* pAddr = pList; pAddr != 0L; pAddr = pAddr->ai_next )
+    {
+        _fd = ::socket(pAddr->ai_family, pAddr->ai_socktype, pAddr->ai_protocol);
+
+        if( _fd == -1 )
+        {
+            err = errno;
+            continue;
+        }
+
+        if( ::connect(_fd, pAddr->ai_addr, pAddr->ai_addrlen) == 0 )
+            break;
+
+        err = errno;
+        ::close(_fd);
+        _fd = -1;
+    }
+
+    ::freeaddrinfo(pList);
+
+    if( _fd == -1 )
+        THROW_RUNTIME_ERROR("SerialNetPort - failed to connect " << host << ":" << port << " errno: " << err);
+
+    // Commands are small and latency bound
+    int on(1);
+    ::setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+    SERIAL_LOG_INFO(_logger, "SerialNetPort - connected");
 }
 
 void    SerialNetPort::disconnect(void)
 {
-    _logger.Log("SerialNetPort::disconnect");
+    if( isOpen() == false )
+        return;
+
+    SERIAL_LOG_INFO(_logger, "SerialNetPort - disconnect");
+
+    // Wakes up reader blocked in read()
+    ::shutdown(_fd, SHUT_RDWR);
+    ::close(_fd);
+    _fd = -1;
 }
 
-} // end of namespace oxoocoffee
+int     SerialNetPort::Open(const string& address)
+{
+    string::size_type Idx = address.rfind(':');
+
+    if( Idx == string::npos || Idx == 0 || Idx + 1 == address.size() )
+        THROW_INVALID_ARG("SerialNetPort - address must be host:port, got " << address);
+
+    connect(address.substr(0, Idx), (unsigned short)atoi(address.c_str() + Idx + 1));
 
+    return _fd;
+}
+
+void    SerialNetPort::Close(int)
+{
+    disconnect();
+}
+
+int     SerialNetPort::PendingOutput(int fd) const
+{
+    int count(0);
+
+    // Same request as TIOCOUTQ. Bytes not yet acked by peer
+    if( ::ioctl(fd, TIOCOUTQ, &count) != 0 )
+        return -1;
+
+    return count;
+}
+
+} // end of namespace oxoocoffee
@@ -1,4 +1,5 @@
 #include "serialPort.h"
+#include "serialBaud.h"
 #include <errno.h>
 #include <string.h> // For strcmp on ubuntu
 #include <stdlib.h> // For free() on ubuntu
@@ -7,6 +8,11 @@
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/ioctl.h>
+#include <poll.h>
+#if defined(__linux__)
+#include <linux/serial.h>
+#include <sys/eventfd.h>
+#endif
 #include <iostream>
 
 int     fileFilter(const struct dirent* pEntry);
@@ -14,31 +20,105 @@ int     fileFilter(const struct dirent* pEntry);
 namespace oxoocoffee
 {
 
+// eventfd, pipe off Linux. Both ends non blocking
+static bool OpenWakeFds(int& readFd, int& writeFd)
+{
+#if defined(__linux__)
+    readFd = writeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#else
+    int fds[2];
+
+    if( ::pipe(fds) == 0 )
+    {
+        ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+        ::fcntl(fds[1], F_SETFL, O_NONBLOCK);
+        readFd  = fds[0];
+        writeFd = fds[1];
+    }
+#endif
+
+    return readFd != -1;
+}
+
+static void CloseWakeFds(int readFd, int writeFd)
+{
+    if( writeFd != readFd && writeFd != -1 )
+        ::close(writeFd);
+
+    if( readFd != -1 )
+        ::close(readFd);
+}
+
+static void DrainWakeFd(int fd)
+{
+    uint64_t drain[8];
+
+    while( ::read(fd, drain, sizeof(drain)) > 0 )
+        ;
+}
+
 // -1 means invalid file 
 SerialPort::SerialPort(SerialLogger& log) 
- : INVALID_FD(-1), _logger(log), _fd(INVALID_FD)
+ : INVALID_FD(-1), _logger(log), _fd(INVALID_FD), _baudRate(9600), _customBaud(false),
+   _profile(eProfile_Default), _profileReport(), _skipMatching(false), _pTransport(0L), _pCapture(0L),
+   _wakeFd(-1), _wakeWriteFd(-1), _kickFd(-1), _kickWriteFd(-1), _interrupted(false),
+   _rxHead(0), _rxTail(0), _rxChunkCount(0), _rxStamp(), _rxReads(0),
+   _txWrites(0), _txShort(0), _cfgWrites(0), _cfgSkips(0)
 {
     baud(9600);
     dateSize(eDataSize_8Bit);
     stopBit(eStopBit_1);
     parity(eParity_None);
     flowControl(eFlow_None);
+
+    // Stop signal next to device fd in every wait, kick only in read waits
+    if( OpenWakeFds(_wakeFd, _wakeWriteFd) == false ||
+        OpenWakeFds(_kickFd, _kickWriteFd) == false )
+    {
+        int err = errno;
+
+        CloseWakeFds(_wakeFd, _wakeWriteFd);
+        THROW_RUNTIME_ERROR("SerialPort - failed to create wake fd. errno: " << err);
+    }
 }
 
 SerialPort::~SerialPort(void)
 {
+    CloseWakeFds(_kickFd, _kickWriteFd);
+    CloseWakeFds(_wakeFd, _wakeWriteFd);
 }
         // device is /dev/tty???
 void    SerialPort::connect(const string& device)
 {
-    if( device.empty() )
-        THROW_INVALID_ARG("SerialPort - invalid device path")
-
     if( isOpen() )
         disconnect();
 
-    if( _logger.IsLogOpen() )
-        _logger.LogLine("SerialPort - opening " + device );
+    clearInterrupt();
+
+    if( _pTransport != 0L )
+    {
+        SERIAL_LOG_INFO(_logger, "SerialPort - opening " << _pTransport->Name() << " " << device);
+
+        // Line settings do not apply, link decides
+        _fd = _pTransport->Open(device);
+
+        // Waits happen in poll, see waitReadable / waitWritable
+        if( _fd != INVALID_FD )
+            ::fcntl(_fd, F_SETFL, ::fcntl(_fd, F_GETFL) | O_NONBLOCK);
+
+        resetRx();
+        _rxReads   = 0;
+        _txWrites  = 0;
+        _txShort   = 0;
+        _cfgWrites = 0;
+        _cfgSkips  = 0;
+        return;
+    }
+
+    if( device.empty() )
+        THROW_INVALID_ARG("SerialPort - invalid device path")
+
+    SERIAL_LOG_INFO(_logger, "SerialPort - opening " << device);
 
     // The O_NOCTTY flag tells UNIX that this program doesn't
     //     want to be the controlling entity for that port.
@@ -59,99 +139,147 @@ void    SerialPort::connect(const string& device)
         THROW_RUNTIME_ERROR("SerialPort - invalid device");
     }
 
-    fcntl(_fd, F_SETFL, 0);
+    // Stays non blocking. Every wait is a poll that interrupt can
+    // reach, a blocking write() on stalled adapter could not be
+    fcntl(_fd, F_SETFL, O_NONBLOCK);
+
+    resetRx();
+    _rxReads   = 0;
+    _txWrites  = 0;
+    _txShort   = 0;
+    _cfgWrites = 0;
+    _cfgSkips  = 0;
 
     applySettings();
 
-    if( _logger.IsLogOpen() )
-        _logger.LogLine("SerialPort - connected " + device );
+    SERIAL_LOG_INFO(_logger, "SerialPort - connected " << device);
+}
+
+void    SerialPort::connect(const string& device, const Config& config)
+{
+    if( isOpen() )
+        disconnect();
+
+    configure(config);
+    connect(device);
 }
 
 void    SerialPort::disconnect(bool echo)
 {
     if( isOpen() )
     {
-        if( echo && _logger.IsLogOpen() )
-            _logger.LogLine("SerialPort - disconnect");
+        if( echo )
+            SERIAL_LOG_INFO(_logger, "SerialPort - disconnect");
 
-        ::close(_fd);
+        if( _pTransport != 0L )
+            _pTransport->Close(_fd);
+        else
+            ::close(_fd);
     }
 
     _fd = INVALID_FD;
+    resetRx();
+    clearInterrupt();
+}
+
+void    SerialPort::interrupt(void)
+{
+    uint64_t one(1);
+
+    _interrupted = true;
+
+    if( ::write(_wakeWriteFd, &one, sizeof(one)) < 0 && errno != EAGAIN )
+        SERIAL_LOG_ERROR(_logger, "SerialPort - interrupt failed");
+}
+
+void    SerialPort::clearInterrupt(void)
+{
+    DrainWakeFd(_wakeFd);
+    DrainWakeFd(_kickFd);
+
+    _interrupted = false;
+}
+
+void    SerialPort::wake(void)
+{
+    uint64_t one(1);
+
+    if( ::write(_kickWriteFd, &one, sizeof(one)) < 0 && errno != EAGAIN )
+        SERIAL_LOG_ERROR(_logger, "SerialPort - wake failed");
 }
 
 void    SerialPort::canonical(const eCanonical mode)
 {
     _canonical = mode;
 
-    if( _logger.IsLogOpen() )
-    {
-        if( _canonical == eCanonical_Disable )
-            _logger.LogLine("SerialPort - setting up raw mode");
-        else
-            _logger.LogLine("SerialPort - setting up line mode");
-    }
+    SERIAL_LOG_INFO(_logger, "SerialPort - setting up " << (_canonical == eCanonical_Disable ? "raw" : "line") << " mode");
 
     applySettings(); 
 }
 
 void    SerialPort::baud(const unsigned int& baud)
 {
-    if( _logger.IsLogOpen() )
+    SERIAL_LOG_INFO(_logger, "SerialPort - setting baud to " << baud);
+
+    if( baudConstant(baud, _baud) )
+        _customBaud = false;
+    else if( baud != 0 && SerialBaud::IsSupported() )
     {
-        ostringstream msg; msg << "SerialPort - setting baud to " << baud;
-        _logger.LogLine( msg.str() );
+        _baud       = B38400;   // Placeholder until termios2 call
+        _customBaud = true;
     }
-
-    switch (baud) 
+    else
     {
-        case 50:        _baud = B50;     break;
-        case 75:        _baud = B75;     break;
-        case 110:       _baud = B110;    break;
-        case 134:       _baud = B134;    break;
-        case 150:       _baud = B150;    break;
-        case 200:       _baud = B200;    break;
-        case 300:       _baud = B300;    break;
-        case 600:       _baud = B600;    break;
-        case 1200:      _baud = B1200;   break;
-        case 1800:      _baud = B1800;   break;
-        case 4800:      _baud = B4800;   break;
-        case 9600:      _baud = B9600;   break;
-        case 19200:     _baud = B19200;  break;
-        case 38400:     _baud = B38400;  break;
-        case 57600:     _baud = B57600;  break;
-        case 115200:    _baud = B115200; break;
-        case 230400:    _baud = B230400; break;
-        default:
-            disconnect();
-            THROW_INVALID_ARG("SerialPort - invalid port boud rate set");
-            break;
+        disconnect();
+        THROW_INVALID_ARG("SerialPort - invalid port boud rate set");
     }
 
+    _baudRate = baud;
+
     applySettings(); 
 }
 
-void    SerialPort::dateSize(const eDataSize size)
+// false when rate has no Bxxx constant
+bool    SerialPort::baudConstant(unsigned int rate, speed_t& speed)
 {
-    _dataSize = size;
-
-    switch( size )
+    switch( rate )
     {
-        case eDataSize_5Bit:
-            if( _logger.IsLogOpen() )
-                _logger.LogLine("SerialPort - setting up data size to 5 bits"); break;
-        case eDataSize_6Bit:
-            if( _logger.IsLogOpen() )
-                _logger.LogLine("SerialPort - setting up data size to 6 bits"); break;
-        case eDataSize_7Bit:
-            if( _logger.IsLogOpen() )
-                _logger.LogLine("SerialPort - setting up data size to 7 bits"); break;
-        case eDataSize_8Bit:
-            if( _logger.IsLogOpen() )
-                _logger.LogLine("SerialPort - setting up data size to 8 bits"); break;
+        case 50:        speed = B50;     return true;
+        case 75:        speed = B75;     return true;
+        case 110:       speed = B110;    return true;
+        case 134:       speed = B134;    return true;
+        case 150:       speed = B150;    return true;
+        case 200:       speed = B200;    return true;
+        case 300:       speed = B300;    return true;
+        case 600:       speed = B600;    return true;
+        case 1200:      speed = B1200;   return true;
+        case 1800:      speed = B1800;   return true;
+        case 4800:      speed = B4800;   return true;
+        case 9600:      speed = B9600;   return true;
+        case 19200:     speed = B19200;  return true;
+        case 38400:     speed = B38400;  return true;
+        case 57600:     speed = B57600;  return true;
+        case 115200:    speed = B115200; return true;
+        case 230400:    speed = B230400; return true;
+#ifdef B460800
+        case 460800:    speed = B460800; return true;
+#endif
+#ifdef B921600
+        case 921600:    speed = B921600; return true;
+#endif
         default:
-            THROW_INVALID_ARG("SerialPort - invalid date size"); break;
+            return false;
     }
+}
+
+void    SerialPort::dateSize(const eDataSize size)
+{
+    _dataSize = size;
+
+    if( size > eDataSize_8Bit )
+        THROW_INVALID_ARG("SerialPort - invalid date size");
+
+    SERIAL_LOG_INFO(_logger, "SerialPort - setting up data size to " << (5 + size) << " bits");
 
     applySettings(); 
 }
@@ -160,15 +288,11 @@ void    SerialPort::parity(const eParity parity)
 {
     _parity = parity;
 
-    if( _logger.IsLogOpen() )
-    {
-        if( _parity == eParity_None )
-            _logger.LogLine("SerialPort - disable parity");
-        else if( _parity == eParity_Even )
-            _logger.LogLine("SerialPort - enable odd parity");
-        else
-            _logger.LogLine("SerialPort - enable odd parity");
-    }
+    if( _parity == eParity_None )
+        SERIAL_LOG_INFO(_logger, "SerialPort - disable parity");
+    else
+        SERIAL_LOG_INFO(_logger, "SerialPort - enable " << (_parity == eParity_Even ? "even" :
+                                 _parity == eParity_Odd ? "odd" : "space") << " parity");
 
     applySettings();
 }
@@ -177,13 +301,7 @@ void    SerialPort::stopBit(const eStopBit stop)
 {
     _stopBit = stop;
 
-    if( _logger.IsLogOpen() )
-    {
-        if( stop == eStopBit_1 )
-            _logger.LogLine("SerialPort - setting up 1 stop bit");
-        else
-            _logger.LogLine("SerialPort - setting up 2 stop bit");
-    }
+    SERIAL_LOG_INFO(_logger, "SerialPort - setting up " << (stop == eStopBit_1 ? 1 : 2) << " stop bit");
 
     applySettings(); 
 }
@@ -192,17 +310,68 @@ void    SerialPort::flowControl(const eFlow flow)
 {
     _flow = flow;
 
-    if( _logger.IsLogOpen() )
-    {
-        if( _flow == eFlow_None )
-            _logger.LogLine("SerialPort - disable flow control");
-        else
-            _logger.LogLine("SerialPort - enable flow control");
-    }
+    SERIAL_LOG_INFO(_logger, "SerialPort - " << (_flow == eFlow_None ? "disable" : "enable") << " flow control");
 
     applySettings(); 
 }
 
+void    SerialPort::transport(ITransport* pTransport)
+{
+    if( isOpen() )
+        THROW_RUNTIME_ERROR("SerialPort - transport must be set while closed");
+
+    _pTransport = pTransport;
+}
+
+void    SerialPort::capture(SerialCapture* pCapture)
+{
+    _pCapture = pCapture;
+}
+
+void    SerialPort::profile(const eProfile profile)
+{
+    _profile = profile;
+
+    SERIAL_LOG_INFO(_logger, "SerialPort - setting up " << (_profile == eProfile_LowLatency ? "low latency" :
+                             _profile == eProfile_Throughput ? "throughput" : "default") << " profile");
+
+    applySettings();
+}
+
+void    SerialPort::configure(const Config& config)
+{
+    speed_t speed(B38400);
+    bool    custom = baudConstant(config.baud, speed) == false;
+
+    if( custom && (config.baud == 0 || SerialBaud::IsSupported() == false) )
+        THROW_INVALID_ARG("SerialPort - invalid port boud rate set");
+
+    if( config.canonical > eCanonical_Enable || config.dataSize > eDataSize_8Bit ||
+        config.stopBit > eStopBit_2 || config.parity > eParity_Space ||
+        config.flow > eFlow_Software || config.profile > eProfile_Throughput )
+        THROW_INVALID_ARG("SerialPort - invalid config");
+
+    _canonical    = config.canonical;
+    _baud         = speed;
+    _baudRate     = config.baud;
+    _customBaud   = custom;
+    _dataSize     = config.dataSize;
+    _stopBit      = config.stopBit;
+    _parity       = config.parity;
+    _flow         = config.flow;
+    _profile      = config.profile;
+    _skipMatching = config.skipIfMatching;
+
+    static const char parity[] = { 'N', 'E', 'O', 'S' };
+    static const char flow[]   = { 'N', 'H', 'S' };
+
+    SERIAL_LOG_INFO(_logger, "SerialPort - config " << _baudRate << " " << (5 + _dataSize) << parity[_parity]
+                             << (_stopBit == eStopBit_1 ? 1 : 2) << " flow " << flow[_flow]
+                             << (_canonical == eCanonical_Enable ? " line" : " raw") << " profile " << _profile);
+
+    applySettings();
+}
+
 int     SerialPort::write(const string& mseeage)
 {
     return SerialPort::write(mseeage.c_str(), mseeage.size() );
@@ -215,7 +384,67 @@ int     SerialPort::write(const char* pBuffer, const unsigned int numBytes)
     else if( pBuffer == 0L )
         THROW_RUNTIME_ERROR("SerialPort - trying to write from null pointer")
 
-    return ::write(_fd, pBuffer, numBytes);
+    ++_txWrites;
+
+    int ret = ::write(_fd, pBuffer, numBytes);
+
+    if( _pCapture != 0L && ret > 0 )
+        _pCapture->Write(SerialCapture::eDir_TX, pBuffer, ret);
+
+    return ret;
+}
+
+int     SerialPort::writeAll(const char* pBuffer, const unsigned int numBytes)
+{
+    return writeAllDeadline(pBuffer, numBytes, 0L);
+}
+
+int     SerialPort::writeAll(const char* pBuffer, const unsigned int numBytes,
+                             const timespec& deadline)
+{
+    return writeAllDeadline(pBuffer, numBytes, &deadline);
+}
+
+int     SerialPort::writeAllDeadline(const char* pBuffer, const unsigned int numBytes,
+                                     const timespec* pDeadline)
+{
+    if( _fd == INVALID_FD )
+        THROW_RUNTIME_ERROR("SerialPort - trying to write on closed device")
+    else if( pBuffer == 0L )
+        THROW_RUNTIME_ERROR("SerialPort - trying to write from null pointer")
+
+    unsigned int sent(0);
+
+    while( sent < numBytes )
+    {
+        ++_txWrites;
+
+        int ret = ::write(_fd, pBuffer + sent, numBytes - sent);
+
+        if( ret > 0 )
+        {
+            if( _pCapture != 0L )
+                _pCapture->Write(SerialCapture::eDir_TX, pBuffer + sent, ret);
+
+            sent += ret;
+
+            if( sent < numBytes )
+                ++_txShort;
+
+            continue;
+        }
+
+        if( ret < 0 && errno == EINTR )
+            continue;
+
+        // Adapter that stopped draining must not hold caller forever
+        if( ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && waitWritable(pDeadline) )
+            continue;
+
+        return -1;
+    }
+
+    return sent;
 }
 
 int     SerialPort::read(char* pBuffer, const unsigned int numBytes)
@@ -225,8 +454,468 @@ int     SerialPort::read(char* pBuffer, const unsigned int numBytes)
     else if( pBuffer == 0L )
         THROW_RUNTIME_ERROR("SerialPort - trying to read to null pointer")
 
+    if( _rxHead == _rxTail && waitReadable(0L) == false )
+        return errno == EINTR ? 0 : -1;
+
+    return readBuffered(pBuffer, numBytes);
+}
+
+int     SerialPort::readBuffered(char* pBuffer, const unsigned int numBytes)
+{
     pBuffer[0] = 0;
-    return ::read(_fd, pBuffer, numBytes);
+
+    // Hand out what is already buffered before going to the device
+    if( _rxHead != _rxTail )
+    {
+        unsigned int count = _rxTail - _rxHead;
+
+        if( count > numBytes )
+            count = numBytes;
+
+        memcpy(pBuffer, _rxBuf + _rxHead, count);
+        _rxHead += count;
+
+        return count;
+    }
+
+    ++_rxReads;
+
+    int count = ::read(_fd, pBuffer, numBytes);
+
+    if( count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) )
+        count = 0;
+    else if( count == 0 )
+    {
+        // Readable with nothing to read is end of file
+        // (peer closed socket, tty hung up)
+        errno = EPIPE;
+        count = -1;
+    }
+
+    if( _pCapture != 0L && count > 0 )
+        _pCapture->Write(SerialCapture::eDir_RX, pBuffer, count);
+
+    return count;
+}
+
+int     SerialPort::read(char* pBuffer, const unsigned int numBytes,
+                             const timespec& deadline)
+{
+    if( _fd == INVALID_FD )
+        return _fd;
+    else if( pBuffer == 0L )
+        THROW_RUNTIME_ERROR("SerialPort - trying to read to null pointer")
+
+    // Buffered data is served without waiting
+    if( _rxHead == _rxTail && waitReadable(&deadline) == false )
+        return (errno == ETIMEDOUT || errno == EINTR) ? 0 : -1;
+
+    return readBuffered(pBuffer, numBytes);
+}
+
+int     SerialPort::readFrame(string& frame, const char terminator)
+{
+    return readFrameUntil(frame, terminator, 0L);
+}
+
+int     SerialPort::readFrame(string& frame, const char terminator,
+                              const timespec& deadline)
+{
+    return readFrameUntil(frame, terminator, &deadline);
+}
+
+bool    SerialPort::skipUntil(const char ch)
+{
+    return skipUntilDeadline(ch, 0L);
+}
+
+bool    SerialPort::skipUntil(const char ch, const timespec& deadline)
+{
+    return skipUntilDeadline(ch, &deadline);
+}
+
+int     SerialPort::readFrameUntil(string& frame, const char terminator,
+                                   const timespec* pDeadline)
+{
+    while( true )
+    {
+        if( popFrame(frame, terminator) )
+            return frame.length();
+
+        int count = fillRx(pDeadline);
+
+        if( count <= 0 )
+            return count;
+    }
+}
+
+int     SerialPort::receive(void)
+{
+    return fillRx(0L);
+}
+
+bool    SerialPort::popFrame(string& frame, const char terminator)
+{
+    frame.clear();
+
+    // Skip empty frames (back to back terminators)
+    while( _rxHead != _rxTail && _rxBuf[_rxHead] == terminator )
+        ++_rxHead;
+
+    if( _rxHead == _rxTail )
+        return false;
+
+    const char* pStart = _rxBuf + _rxHead;
+    const char* pEnd   = (const char*)memchr(pStart, terminator, _rxTail - _rxHead);
+
+    if( pEnd != 0L )
+    {
+        frame.assign(pStart, pEnd - pStart);
+        stampFrame(_rxHead, _rxHead + (pEnd - pStart));
+        _rxHead += (pEnd - pStart) + 1;
+        return true;
+    }
+
+    // Buffer full and still no terminator. Hand over
+    // what we have so reader does not stall forever
+    if( _rxHead == 0 && _rxTail == RX_BUFFER_SIZE )
+    {
+        frame.assign(pStart, _rxTail);
+        stampFrame(0, _rxTail - 1);
+        resetRx();
+        return true;
+    }
+
+    return false;
+}
+
+bool    SerialPort::skipUntilDeadline(const char ch, const timespec* pDeadline)
+{
+    while( true )
+    {
+        if( _rxHead != _rxTail )
+        {
+            const char* pStart = _rxBuf + _rxHead;
+            const char* pFound = (const char*)memchr(pStart, ch, _rxTail - _rxHead);
+
+            if( pFound != 0L )
+            {
+                _rxHead += (pFound - pStart) + 1;
+                return true;
+            }
+
+            resetRx();
+        }
+
+        if( fillRx(pDeadline) <= 0 )
+            return false;
+    }
+}
+
+// Untimed waits poll too, so interrupt and wake can reach them
+bool    SerialPort::waitReadable(const timespec* pDeadline)
+{
+    pollfd pfd[3];
+
+    pfd[0].fd     = _fd;
+    pfd[0].events = POLLIN;
+    pfd[1].fd     = _wakeFd;
+    pfd[1].events = POLLIN;
+    pfd[2].fd     = _kickFd;
+    pfd[2].events = POLLIN;
+
+    while( true )
+    {
+        pfd[0].revents = 0;
+        pfd[1].revents = 0;
+        pfd[2].revents = 0;
+
+        int  waitMs = pDeadline ? SerialClock::RemainingMs(*pDeadline) : -1;
+        bool flush(false);
+
+        // Idle reader puts capture data left in buffer on disk
+        uint64_t flushNs = _pCapture != 0L ? _pCapture->FlushDueNs() : 0;
+
+        if( flushNs != 0 )
+        {
+            uint64_t now = SerialClock::NowNs();
+            int      ms  = flushNs > now ? (int)((flushNs - now + 999999) / 1000000) : 0;
+
+            if( waitMs < 0 || ms < waitMs )
+            {
+                waitMs = ms;
+                flush  = true;
+            }
+        }
+
+        int ret = _interrupted ? 0 : ::poll(pfd, 3, waitMs);
+
+        // Stop wins over pending data
+        if( _interrupted || pfd[1].revents != 0 )
+        {
+            errno = ECANCELED;
+            return false;
+        }
+
+        if( pfd[2].revents != 0 )
+        {
+            DrainWakeFd(_kickFd);
+            errno = EINTR;
+            return false;
+        }
+
+        if( ret > 0 )
+            return true;    // Readable, hangup or error. read() tells which
+
+        if( ret == 0 && flush && _interrupted == false )
+        {
+            _pCapture->Flush();
+            continue;
+        }
+
+        if( ret == 0 )
+        {
+            errno = ETIMEDOUT;
+            return false;
+        }
+
+        if( errno != EINTR )
+            return false;
+    }
+}
+
+// Same as waitReadable, for POLLOUT
+bool    SerialPort::waitWritable(const timespec* pDeadline)
+{
+    pollfd pfd[2];
+
+    pfd[0].fd     = _fd;
+    pfd[0].events = POLLOUT;
+    pfd[1].fd     = _wakeFd;
+    pfd[1].events = POLLIN;
+
+    while( true )
+    {
+        pfd[0].revents = 0;
+        pfd[1].revents = 0;
+
+        int ret = _interrupted ? 0 : ::poll(pfd, 2, pDeadline ? SerialClock::RemainingMs(*pDeadline) : -1);
+
+        if( _interrupted || pfd[1].revents != 0 )
+        {
+            errno = ECANCELED;
+            return false;
+        }
+
+        if( ret > 0 )
+            return true;    // Writable, hangup or error. write() tells which
+
+        if( ret == 0 )
+        {
+            errno = ETIMEDOUT;
+            return false;
+        }
+
+        if( errno != EINTR )
+            return false;
+    }
+}
+
+// Throughput profile. Some bytes are there, let more arrive while
+// line keeps delivering. Gap is a few character times, so frame
+// stamps taken after read() stay close to arrival. Sleeps on wake
+// fd only, never past deadline
+void    SerialPort::gatherRx(const timespec* pDeadline)
+{
+    uint64_t gapNs = wireTimeNs(THROUGHPUT_GAP_CHARS);
+
+    // No line rate to pace by
+    if( gapNs == 0 )
+        return;
+
+    int avail(0);
+    int last(-1);
+
+    while( ::ioctl(_fd, FIONREAD, &avail) == 0 && avail < THROUGHPUT_BYTES && avail != last )
+    {
+        uint64_t waitNs = gapNs;
+
+        if( pDeadline != 0L )
+        {
+            uint64_t now = SerialClock::NowNs();
+            uint64_t end = SerialClock::ToNs(*pDeadline);
+
+            if( end <= now )
+                return;
+
+            if( end - now < waitNs )
+                waitNs = end - now;
+        }
+
+        if( _interrupted )
+            return;
+
+        pollfd   pfd  = { _wakeFd, POLLIN, 0 };
+        timespec wait = SerialClock::FromNs(waitNs);
+
+        // Woken means interrupt, waitReadable reports it
+        if( ::ppoll(&pfd, 1, &wait, 0L) != 0 )
+            return;
+
+        last = avail;
+    }
+}
+
+int     SerialPort::fillRx(const timespec* pDeadline)
+{
+    if( _fd == INVALID_FD )
+        return _fd;
+
+    // Move partial frame to front to make room
+    if( _rxHead == _rxTail )
+        resetRx();
+    else if( _rxHead != 0 && _rxTail == RX_BUFFER_SIZE )
+    {
+        memmove(_rxBuf, _rxBuf + _rxHead, _rxTail - _rxHead);
+
+        unsigned int kept(0);
+
+        for( unsigned int Idx(0); Idx < _rxChunkCount; Idx++ )
+        {
+            if( _rxChunks[Idx].end > _rxHead )
+            {
+                _rxChunks[kept]      = _rxChunks[Idx];
+                _rxChunks[kept].end -= _rxHead;
+                ++kept;
+            }
+        }
+
+        _rxChunkCount = kept;
+        _rxTail -= _rxHead;
+        _rxHead  = 0;
+    }
+
+    int count;
+
+    // Readable but nothing there (non blocking fd), wait again
+    do
+    {
+        if( waitReadable(pDeadline) == false )
+            return (errno == ETIMEDOUT || errno == EINTR) ? 0 : -1;
+
+        if( _profile == eProfile_Throughput )
+            gatherRx(pDeadline);
+
+        ++_rxReads;
+        count = ::read(_fd, _rxBuf + _rxTail, RX_BUFFER_SIZE - _rxTail);
+    }
+    while( count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) );
+
+    // Readable with nothing to read is end of file (peer closed
+    // socket, tty hung up). Reported as error so loops stop polling
+    if( count == 0 )
+    {
+        errno = EPIPE;
+        return -1;
+    }
+
+    if( count > 0 )
+    {
+        if( _pCapture != 0L )
+            _pCapture->Write(SerialCapture::eDir_RX, _rxBuf + _rxTail, count);
+
+        _rxTail += count;
+
+        if( _rxChunkCount == RX_CHUNKS )
+        {
+            // Oldest bytes get older stamp of the two
+            _rxChunks[0].end = _rxChunks[1].end;
+            memmove(_rxChunks + 1, _rxChunks + 2, (RX_CHUNKS - 2) * sizeof(RxChunk));
+            --_rxChunkCount;
+        }
+
+        _rxChunks[_rxChunkCount].end = _rxTail;
+        _rxChunks[_rxChunkCount].ns  = SerialClock::NowNs();
+        ++_rxChunkCount;
+    }
+
+    return count;
+}
+
+void    SerialPort::resetRx(void)
+{
+    _rxHead       = 0;
+    _rxTail       = 0;
+    _rxChunkCount = 0;
+}
+
+// Byte at offset arrived wire time of bytes behind it in
+// same chunk before read() returned
+uint64_t SerialPort::stampAt(unsigned int offset) const
+{
+    for( unsigned int Idx(0); Idx < _rxChunkCount; Idx++ )
+    {
+        if( _rxChunks[Idx].end > offset )
+            return _rxChunks[Idx].ns - wireTimeNs(_rxChunks[Idx].end - 1 - offset);
+    }
+
+    return 0;
+}
+
+// first and last are buffer offsets of frame's first byte and terminator
+void    SerialPort::stampFrame(unsigned int first, unsigned int last)
+{
+    _rxStamp.firstNs  = stampAt(first);
+    _rxStamp.lastNs   = stampAt(last);
+
+    uint64_t wire = wireTimeNs(last - first + 1);
+
+    // No chunk covers terminator, all stamps 0 (unknown) rather than
+    // 0 less wire time
+    if( _rxStamp.lastNs == 0 )
+        _rxStamp.firstNs = 0;
+    else if( _rxStamp.firstNs == 0 || _rxStamp.firstNs > _rxStamp.lastNs )
+        _rxStamp.firstNs = _rxStamp.lastNs;
+
+    _rxStamp.sampleNs = _rxStamp.lastNs > wire ? _rxStamp.lastNs - wire : 0;
+
+    // Drop chunks this frame used up
+    unsigned int done(0);
+
+    while( done < _rxChunkCount && _rxChunks[done].end <= last + 1 )
+        ++done;
+
+    if( done != 0 )
+    {
+        memmove(_rxChunks, _rxChunks + done, (_rxChunkCount - done) * sizeof(RxChunk));
+        _rxChunkCount -= done;
+    }
+}
+
+int     SerialPort::pendingOutput(void) const
+{
+    int count(0);
+
+    if( _fd == INVALID_FD )
+        return -1;
+
+    if( _pTransport != 0L )
+        return _pTransport->PendingOutput(_fd);
+
+    if( ::ioctl(_fd, TIOCOUTQ, &count) != 0 )
+        return -1;
+
+    return count;
+}
+
+unsigned int    SerialPort::bitsPerChar(void) const
+{
+    unsigned int bits = 1 + 5 + (unsigned int)_dataSize;   // Start + data
+
+    if( _parity == eParity_Even || _parity == eParity_Odd )
+        ++bits;
+
+    return bits + (_stopBit == eStopBit_2 ? 2 : 1);
 }
 
 void    SerialPort::enumeratePorts(SerialPort::TList& lst, const string& path)
@@ -281,21 +970,22 @@ void    SerialPort::printPorts(void)
 
 void    SerialPort::log(const string& msg)
 {
-    if( _logger.IsLogOpen() )
+    if( _logger.IsLogging(SerialLogger::eLevel_Info) )
         _logger.Log(msg);
 }
 
 void    SerialPort::logLine(const string& msg)
 {
-    if( _logger.IsLogOpen() )
+    if( _logger.IsLogging(SerialLogger::eLevel_Info) )
         _logger.LogLine(msg);
 }
 
 void    SerialPort::applySettings(void)
 {
-    if( isOpen() )
+    if( isOpen() && _pTransport == 0L )
     {
         termios options;
+        termios current;
 
         bzero(&options, sizeof(options));
 
@@ -305,12 +995,18 @@ void    SerialPort::applySettings(void)
             disconnect();
             THROW_RUNTIME_ERROR(err.str());
         }
-    
+
+        current = options;
+
+        // Custom rate already there. Leave BOTHER speed bits as found
+        unsigned int actual(0);
+        bool         customSet = _customBaud && SerialBaud::Get(_fd, actual) && actual == _baudRate;
+
         // Set the read and write speed 
-        if( ::cfsetispeed(&options, _baud) != 0)
+        if( customSet == false && ::cfsetispeed(&options, _baud) != 0)
             THROW_RUNTIME_ERROR("SerialPort - failed to set input baud speed");
 
-        if( ::cfsetospeed(&options, _baud) != 0)
+        if( customSet == false && ::cfsetospeed(&options, _baud) != 0)
             THROW_RUNTIME_ERROR("SerialPort - failed to set output baud speed");
 
         // Enable the receiver and set local mod
@@ -384,6 +1080,12 @@ void    SerialPort::applySettings(void)
         {
             options.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG);
             options.c_lflag &= ~(ECHOPRT);
+
+            // read() only runs after poll() said readable and takes
+            // what is there. Kernel VMIN / VTIME would hold it past
+            // deadline and interrupt, throughput batching is gatherRx
+            options.c_cc[VMIN]  = 0;
+            options.c_cc[VTIME] = 0;
         }
 
         if( _flow == eFlow_Software )
@@ -392,12 +1094,115 @@ void    SerialPort::applySettings(void)
             options.c_cc[VSTOP]    = '\023'; 
         }
 
+        bool same = options.c_iflag == current.c_iflag && options.c_oflag == current.c_oflag &&
+                    options.c_cflag == current.c_cflag && options.c_lflag == current.c_lflag &&
+                    cfgetispeed(&options) == cfgetispeed(&current) &&
+                    cfgetospeed(&options) == cfgetospeed(&current) &&
+                    memcmp(options.c_cc, current.c_cc, sizeof(options.c_cc)) == 0;
+
+        if( _skipMatching && same && (_customBaud == false || customSet) )
+        {
+            ++_cfgSkips;
+            applyProfile();
+            return;
+        }
+
+        ++_cfgWrites;
+
         if(tcsetattr(_fd, TCSANOW, &options)!= 0)
         {
             ostringstream err; err << "SerialPort - failed to apply changes. errno: " << errno;
             disconnect();
             THROW_RUNTIME_ERROR(err.str());
         }
+
+        if( _customBaud && customSet == false )
+        {
+            if( SerialBaud::Set(_fd, _baudRate) == false )
+            {
+                ostringstream err; err << "SerialPort - failed to set baud " << _baudRate << ". errno: " << errno;
+                disconnect();
+                THROW_RUNTIME_ERROR(err.str());
+            }
+
+            // Keep wire model on rate driver really uses
+            if( SerialBaud::Get(_fd, actual) && actual != 0 && actual != _baudRate )
+            {
+                SERIAL_LOG_WARN(_logger, "SerialPort - driver rounded baud " << _baudRate << " to " << actual);
+
+                _baudRate = actual;
+            }
+        }
+
+        applyProfile();
+    }
+}
+
+// Port is open. Driver low latency flag, then read back what stuck
+void    SerialPort::applyProfile(void)
+{
+    _profileReport.profile          = _profile;
+    _profileReport.serialInfo       = false;
+    _profileReport.lowLatency       = false;
+    _profileReport.lowLatencyErrno  = 0;
+    _profileReport.gatherBytes      = 0;
+    _profileReport.gatherGapUs      = 0;
+
+#if defined(__linux__)
+    serial_struct info;
+
+    // Not there on ptys and many USB CDC drivers
+    if( ::ioctl(_fd, TIOCGSERIAL, &info) == 0 )
+    {
+        _profileReport.serialInfo = true;
+
+        if( _profile != eProfile_Default )
+        {
+            int flags = info.flags;
+
+            if( _profile == eProfile_LowLatency )
+                flags |= ASYNC_LOW_LATENCY;
+            else
+                flags &= ~ASYNC_LOW_LATENCY;
+
+            if( flags != info.flags )
+            {
+                info.flags = flags;
+
+                if( ::ioctl(_fd, TIOCSSERIAL, &info) != 0 )
+                    _profileReport.lowLatencyErrno = errno;
+
+                if( ::ioctl(_fd, TIOCGSERIAL, &info) != 0 )
+                    info.flags = 0;
+            }
+        }
+
+        _profileReport.lowLatency = (info.flags & ASYNC_LOW_LATENCY) != 0;
+    }
+#endif
+
+    // VMIN / VTIME stay 0, batching is gatherRx
+    if( _profile == eProfile_Throughput && wireTimeNs(THROUGHPUT_GAP_CHARS) != 0 )
+    {
+        _profileReport.gatherBytes = THROUGHPUT_BYTES;
+        _profileReport.gatherGapUs = (unsigned int)(wireTimeNs(THROUGHPUT_GAP_CHARS) / 1000);
+    }
+
+    if( _logger.IsLogging(SerialLogger::eLevel_Info) )
+    {
+        ostringstream msg; msg << "SerialPort - profile in effect: ASYNC_LOW_LATENCY ";
+
+        if( _profileReport.serialInfo == false )
+            msg << "n/a";
+        else
+            msg << (_profileReport.lowLatency ? "on" : "off");
+
+        if( _profileReport.lowLatencyErrno != 0 )
+            msg << " (TIOCSSERIAL errno " << _profileReport.lowLatencyErrno << ")";
+
+        msg << ", gather " << _profileReport.gatherBytes << " bytes / " << _profileReport.gatherGapUs << " us";
+
+        _logger.LogLineAt(SerialLogger::eLevel_Info, msg.str());
     }
 }
 
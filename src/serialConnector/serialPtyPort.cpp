@@ -0,0 +1,83 @@
+#include "serialPtyPort.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+
+namespace oxoocoffee
+{
+
+SerialPtyPort::SerialPtyPort(SerialLogger& log)
+ : _logger(log), _master(-1), _slave(-1), _lineRate(0)
+{
+}
+
+SerialPtyPort::~SerialPtyPort(void)
+{
+    Close(_master);
+}
+
+int     SerialPtyPort::Open(const string&)
+{
+    Close(_master);
+
+    _master = ::posix_openpt(O_RDWR | O_NOCTTY);
+
+    if( _master == -1 || ::grantpt(_master) != 0 || ::unlockpt(_master) != 0 )
+    {
+        int err = errno;
+        Close(_master);
+        THROW_RUNTIME_ERROR("SerialPtyPort - failed to create pty. errno: " << err);
+    }
+
+    const char* pName = ::ptsname(_master);
+
+    if( pName == 0L || (_slave = ::open(pName, O_RDWR | O_NOCTTY)) == -1 )
+    {
+        int err = errno;
+        Close(_master);
+        THROW_RUNTIME_ERROR("SerialPtyPort - failed to open pty slave. errno: " << err);
+    }
+
+    _slavePath = pName;
+
+    // Bytes pass through untouched both ways
+    termios options;
+
+    if( ::tcgetattr(_slave, &options) == 0 )
+    {
+        ::cfmakeraw(&options);
+        ::tcsetattr(_slave, TCSANOW, &options);
+    }
+
+    SERIAL_LOG_INFO(_logger, "SerialPtyPort - slave " << _slavePath);
+
+    return _master;
+}
+
+void    SerialPtyPort::Close(int)
+{
+    if( _slave != -1 )
+        ::close(_slave);
+
+    if( _master != -1 )
+        ::close(_master);
+
+    _slave  = -1;
+    _master = -1;
+    _slavePath.clear();
+}
+
+int     SerialPtyPort::PendingOutput(int fd) const
+{
+    int count(0);
+
+    if( ::ioctl(fd, TIOCOUTQ, &count) != 0 )
+        return -1;
+
+    return count;
+}
+
+}   // End of oxoocoffee namespace
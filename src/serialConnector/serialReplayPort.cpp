@@ -0,0 +1,236 @@
+#include "serialReplayPort.h"
+#include "serialClock.h"
+#include <errno.h>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+
+namespace oxoocoffee
+{
+
+SerialReplayPort::SerialReplayPort(SerialLogger& log)
+ : _logger(log), _repeat(1), _realTime(false), _host(-1), _feed(-1), _thread(),
+   _running(false), _done(false), _fed(0), _received(0)
+{
+}
+
+SerialReplayPort::~SerialReplayPort(void)
+{
+    Close(_host);
+}
+
+int     SerialReplayPort::Open(const string& address)
+{
+    Close(_host);
+
+    _chunks.clear();
+
+    if( address.empty() == false && SerialCapture::IsCapture(address) )
+    {
+        vector<SerialCapture::Record> records;
+
+        SerialCapture::Load(address, records);
+
+        for( vector<SerialCapture::Record>::const_iterator it = records.begin(); it != records.end(); ++it )
+        {
+            if( it->dir != SerialCapture::eDir_RX )
+                continue;
+
+            Chunk chunk;
+
+            chunk.ns   = it->ns;
+            chunk.data = it->data;
+            _chunks.push_back(chunk);
+        }
+
+        // Spacing is relative to first RX chunk
+        for( size_t Idx(_chunks.size()); Idx-- > 0; )
+            _chunks[Idx].ns -= _chunks[0].ns;
+    }
+    else
+    {
+        if( address.empty() == false )
+        {
+            ifstream file(address.c_str(), ios::in | ios::binary);
+
+            if( file.is_open() == false )
+                THROW_RUNTIME_ERROR("SerialReplayPort - can not open " << address);
+
+            ostringstream content;
+            content << file.rdbuf();
+            _data = content.str();
+        }
+
+        if( _data.empty() == false )
+        {
+            Chunk chunk;
+
+            chunk.ns   = 0;
+            chunk.data = _data;
+            _chunks.push_back(chunk);
+        }
+    }
+
+    if( _chunks.empty() || _repeat == 0 )
+        THROW_INVALID_ARG("SerialReplayPort - nothing to replay");
+
+    int fds[2];
+
+    if( ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0 )
+        THROW_RUNTIME_ERROR("SerialReplayPort - socketpair failed. errno: " << errno);
+
+    _host     = fds[0];
+    _feed     = fds[1];
+    _done     = false;
+    _fed      = 0;
+    _received = 0;
+
+    if( ::pthread_create(&_thread, 0L, ThreadFn, this) != 0 )
+    {
+        ::close(_host);
+        ::close(_feed);
+        _host = _feed = -1;
+        THROW_RUNTIME_ERROR("SerialReplayPort - failed to start feeder");
+    }
+
+    _running = true;
+
+    SERIAL_LOG_INFO(_logger, "SerialReplayPort - replaying " << _chunks.size() << " chunks x " << _repeat
+                             << (_realTime ? " real time" : " as fast as possible"));
+
+    return _host;
+}
+
+void    SerialReplayPort::Close(int)
+{
+    if( _host == -1 )
+        return;
+
+    // Reader gets EOF, feeder sees hangup
+    ::shutdown(_host, SHUT_RDWR);
+
+    if( _running )
+        ::pthread_join(_thread, 0L);
+
+    ::close(_host);
+    ::close(_feed);
+
+    _running = false;
+    _host    = -1;
+    _feed    = -1;
+}
+
+int     SerialReplayPort::PendingOutput(int fd) const
+{
+    int count(0);
+
+    if( ::ioctl(fd, TIOCOUTQ, &count) != 0 )
+        return -1;
+
+    return count;
+}
+
+void*   SerialReplayPort::ThreadFn(void* ptr)
+{
+    ((SerialReplayPort*)ptr)->Feed();
+    return 0L;
+}
+
+void    SerialReplayPort::Feed(void)
+{
+    char            sink[1024];
+    unsigned int    round(0);
+    size_t          chunk(0);
+    size_t          offset(0);
+    uint64_t        roundNs = SerialClock::NowNs();
+    pollfd          pfd;
+
+    pfd.fd = _feed;
+
+    while( true )
+    {
+        bool      send(_done == false);
+        timespec  wait;
+        timespec* pWait(0L);
+
+        // Next chunk waits for its recorded time
+        if( send && _realTime && offset == 0 )
+        {
+            uint64_t due = roundNs + _chunks[chunk].ns;
+            uint64_t now = SerialClock::NowNs();
+
+            if( due > now )
+            {
+                wait  = SerialClock::FromNs(due - now);
+                pWait = &wait;
+                send  = false;
+            }
+        }
+
+        pfd.events  = send ? (POLLIN | POLLOUT) : POLLIN;
+        pfd.revents = 0;
+
+        if( ::ppoll(&pfd, 1, pWait, 0L) < 0 )
+        {
+            if( errno == EINTR )
+                continue;
+
+            break;
+        }
+
+        if( pfd.revents & POLLIN )
+        {
+            int count = ::read(_feed, sink, sizeof(sink));
+
+            if( count <= 0 )
+                break;      // Host end shut down
+
+            _received.fetch_add(count);
+        }
+
+        if( pfd.revents & (POLLHUP | POLLERR) )
+            break;
+
+        if( send && (pfd.revents & POLLOUT) )
+        {
+            const string& data = _chunks[chunk].data;
+            size_t        size = data.size() - offset;
+
+            if( size > sizeof(sink) * 4 )
+                size = sizeof(sink) * 4;
+
+            // No SIGPIPE when Close shuts host end mid write
+            int count = ::send(_feed, data.data() + offset, size, MSG_NOSIGNAL);
+
+            if( count < 0 )
+            {
+                if( errno == EINTR || errno == EAGAIN )
+                    continue;
+
+                break;
+            }
+
+            _fed.fetch_add(count);
+            offset += count;
+
+            if( offset == data.size() )
+            {
+                offset = 0;
+
+                if( ++chunk == _chunks.size() )
+                {
+                    chunk   = 0;
+                    roundNs = SerialClock::NowNs();
+
+                    if( ++round == _repeat )
+                        _done = true;
+                }
+            }
+        }
+    }
+}
+
+}   // End of oxoocoffee namespace
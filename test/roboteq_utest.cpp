@@ -1,5 +1,48 @@
 #include <gtest/gtest.h>
 #include "../src/rosRoboteqDrv/rosRoboteqDrv.h"
+#include "roboteqEngine.h"
+#include "serialNetPort.h"
+#include "serialReplayPort.h"
+#include "serialAsyncLogger.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+class NullLogger : public SerialLogger
+{
+	public:
+		virtual bool	IsLogOpen(void) const { return false; }
+		virtual void	LogLine(const char*, unsigned int) {}
+		virtual void	LogLine(const std::string&) {}
+		virtual void	Log(const char*, unsigned int) {}
+		virtual void	Log(const std::string&) {}
+};
+
+// Master side of a pty plays the controller
+class TestPty
+{
+	public:
+		TestPty(void)
+		{
+			_master = posix_openpt(O_RDWR | O_NOCTTY);
+			grantpt(_master);
+			unlockpt(_master);
+			_slave = ptsname(_master);
+		}
+
+		~TestPty(void) { close(_master); }
+
+		void	Send(const std::string& data) { EXPECT_EQ(write(_master, data.c_str(), data.size()), (int)data.size()); }
+
+		int			_master;
+		std::string	_slave;
+};
 
 
 TEST(TestRoboteq, standStill)
@@ -30,6 +73,1442 @@ TEST(TestRoboteq, convertTwistToWheelVels)
 
 }
 
+TEST(TestSerialPort, bufferedFraming)
+{
+	TestPty		pty;
+	NullLogger	log;
+	SerialPort	port(log);
+	std::string	frame;
+
+	port.canonical(SerialPort::eCanonical_Disable);
+	port.connect(pty._slave);
+
+	pty.Send("junk+\r\rS=10:-10\rA=1:");
+
+	EXPECT_TRUE(port.skipUntil('+'));
+	EXPECT_EQ(port.readFrame(frame, '\r'), 8);
+	EXPECT_EQ(frame, "S=10:-10");
+
+	pty.Send("2\r");
+
+	EXPECT_EQ(port.readFrame(frame, '\r'), 5);
+	EXPECT_EQ(frame, "A=1:2");
+	EXPECT_LE(port.rxReadCount(), 2u);
+
+	port.disconnect(false);
+}
+
+TEST(TestSerialPort, frameStamps)
+{
+	TestPty		pty;
+	NullLogger	log;
+	SerialPort	port(log);
+	std::string	frame;
+
+	port.canonical(SerialPort::eCanonical_Disable);
+	port.connect(pty._slave);
+
+	pty.Send("A=1:");
+	EXPECT_EQ(port.receive(), 4);
+
+	usleep(20000);
+	pty.Send("2\r");
+
+	EXPECT_EQ(port.readFrame(frame, '\r'), 5);
+
+	const RxStamp& stamp = port.frameStamp();
+
+	EXPECT_GE(stamp.lastNs - stamp.firstNs, 15000000u);		// Split over two reads
+	EXPECT_LE(stamp.lastNs, SerialClock::NowNs());
+	EXPECT_EQ(stamp.sampleNs, stamp.lastNs - port.wireTimeNs(6));
+
+	port.disconnect(false);
+}
+
+// Frames must come off pty faster than they could cross the wire
+TEST(TestSerialPort, customBaudThroughput)
+{
+	const unsigned int rates[] = { 921600, 1000000, 3000000 };
+
+	for( unsigned int r(0); r < sizeof(rates) / sizeof(rates[0]); r++ )
+	{
+		TestPty		pty;
+		NullLogger	log;
+		SerialPort	port(log);
+		std::string	frame;
+		std::string	batch;
+
+		port.canonical(SerialPort::eCanonical_Disable);
+		port.baud(rates[r]);
+		port.connect(pty._slave);
+
+		EXPECT_EQ(port.baudRate(), rates[r]);
+
+		while( batch.size() < 4000 )
+			batch += "S=1234:-1234\r";
+
+		unsigned int	frames(0);
+		uint64_t		bytes(0);
+		uint64_t		start = SerialClock::NowNs();
+
+		for( int round(0); round < 64; round++ )
+		{
+			pty.Send(batch);
+			bytes += batch.size();
+
+			for( unsigned int Idx(0); Idx < batch.size() / 13; Idx++ )
+			{
+				ASSERT_EQ(port.readFrame(frame, '\r', SerialClock::DeadlineIn(100)), 12);
+				++frames;
+			}
+		}
+
+		EXPECT_EQ(frames * 13u, bytes);
+		EXPECT_LT(SerialClock::NowNs() - start, port.wireTimeNs(bytes));
+
+		port.disconnect(false);
+	}
+}
+
+TEST(TestSerialPort, profileReport)
+{
+	TestPty		pty;
+	NullLogger	log;
+	SerialPort	port(log);
+
+	port.canonical(SerialPort::eCanonical_Disable);
+	port.profile(SerialPort::eProfile_Throughput);
+	port.connect(pty._slave);
+
+	EXPECT_EQ(port.profileReport().profile, SerialPort::eProfile_Throughput);
+	EXPECT_FALSE(port.profileReport().serialInfo);		// No TIOCGSERIAL on pty
+	EXPECT_EQ(port.profileReport().gatherBytes, 64u);				// Batching is in user space
+	EXPECT_EQ(port.profileReport().gatherGapUs, port.wireTimeNs(3) / 1000);	// Three character times
+
+	// Short frame waits a few character times, not for a full batch
+	std::string	frame;
+	uint64_t	start = SerialClock::NowNs();
+
+	pty.Send("+\r");
+	EXPECT_EQ(port.readFrame(frame, '\r', SerialClock::DeadlineIn(500)), 1);
+	EXPECT_LT(SerialClock::NowNs() - start, 20000000ULL);
+
+	port.profile(SerialPort::eProfile_LowLatency);
+
+	EXPECT_EQ(port.profileReport().profile, SerialPort::eProfile_LowLatency);
+	EXPECT_EQ(port.profileReport().gatherBytes, 0u);
+	EXPECT_EQ(port.profileReport().gatherGapUs, 0u);
+
+	port.disconnect(false);
+}
+
+TEST(TestSerialPort, configAppliedOnce)
+{
+	TestPty				pty;
+	NullLogger			log;
+	SerialPort			port(log);
+	SerialPort::Config	config;
+
+	config.baud		= 1000000;
+	config.profile	= SerialPort::eProfile_LowLatency;
+
+	port.connect(pty._slave, config);
+
+	EXPECT_EQ(port.configWriteCount(), 1u);
+	EXPECT_EQ(port.baudRate(), 1000000u);
+
+	// Master stays open so tty keeps settings. Nothing to write
+	port.connect(pty._slave, config);
+
+	EXPECT_EQ(port.configWriteCount(), 0u);
+	EXPECT_EQ(port.configSkipCount(), 1u);
+
+	config.parity = SerialPort::eParity_Even;
+	port.configure(config);
+
+	EXPECT_EQ(port.configWriteCount(), 1u);
+
+	config.baud = 0;
+	EXPECT_THROW(port.configure(config), std::invalid_argument);
+	EXPECT_TRUE(port.isOpen());
+
+	port.disconnect(false);
+}
+
+TEST(TestSerialPort, timedReadExpires)
+{
+	TestPty		pty;
+	NullLogger	log;
+	SerialPort	port(log);
+	char		buf[16];
+
+	port.canonical(SerialPort::eCanonical_Disable);
+	port.connect(pty._slave);
+
+	EXPECT_EQ(port.read(buf, sizeof(buf), SerialClock::DeadlineIn(20)), 0);
+	EXPECT_EQ(errno, ETIMEDOUT);
+
+	pty.Send("+\r");
+
+	EXPECT_TRUE(port.skipUntil('+', SerialClock::DeadlineIn(20)));
+	EXPECT_EQ(port.read(buf, sizeof(buf), SerialClock::DeadlineIn(20)), 1);
+
+	port.disconnect(false);
+}
+
+TEST(TestSerialPort, stalledWriteExpires)
+{
+	TestPty				pty;
+	NullLogger			log;
+	SerialPort			port(log);
+	std::vector<char>	data(1024 * 1024, 'x');
+
+	port.canonical(SerialPort::eCanonical_Disable);
+	port.connect(pty._slave);
+
+	// Master never reads, pty buffer fills and POLLOUT never comes
+	uint64_t start = SerialClock::NowNs();
+
+	EXPECT_EQ(port.writeAll(&data[0], data.size(), SerialClock::DeadlineIn(50)), -1);
+	EXPECT_EQ(errno, ETIMEDOUT);
+	EXPECT_LT(SerialClock::NowNs() - start, 1000000000ULL);
+
+	port.interrupt();
+	EXPECT_EQ(port.writeAll(&data[0], data.size()), -1);
+	EXPECT_EQ(errno, ECANCELED);
+
+	port.disconnect(false);
+}
+
+class ReplyCounter : public IEventListener<const IEventArgs>
+{
+	public:
+		ReplyCounter(void) : _count(0) {}
+
+		virtual void OnMsgEvent(const IEventArgs&) { __sync_fetch_and_add(&_count, 1); }
+
+		volatile int _count;
+};
+
+// Answers just enough of Open handshake on pty master, never streams.
+// Keeps every line it hears so tests can check what went on the wire
+class TestResponder
+{
+	public:
+		TestResponder(int fd) : _fd(fd), _stop(false)
+		{
+			pthread_mutex_init(&_mx, 0L);
+			EXPECT_EQ(pthread_create(&_thread, 0L, ThreadFn, this), 0);
+		}
+
+		~TestResponder(void)
+		{
+			_stop = true;
+			pthread_join(_thread, 0L);
+			pthread_mutex_destroy(&_mx);
+		}
+
+		// Lines starting with prefix get reply ("" stays silent)
+		void	Answer(const std::string& prefix, const std::string& reply)
+		{
+			pthread_mutex_lock(&_mx);
+			_answers.push_back(std::make_pair(prefix, reply));
+			pthread_mutex_unlock(&_mx);
+		}
+
+		// Lines heard so far starting with prefix, in wire order
+		std::vector<std::string>	Heard(const std::string& prefix)
+		{
+			std::vector<std::string> lines;
+
+			pthread_mutex_lock(&_mx);
+
+			for( size_t Idx(0); Idx < _lines.size(); Idx++ )
+			{
+				if( _lines[Idx].compare(0, prefix.size(), prefix) == 0 )
+					lines.push_back(_lines[Idx]);
+			}
+
+			pthread_mutex_unlock(&_mx);
+
+			return lines;
+		}
+
+		bool	WaitHeard(const std::string& prefix, size_t count, int timeoutMs = 1000)
+		{
+			for( int Idx(0); Idx < timeoutMs; Idx++ )
+			{
+				if( Heard(prefix).size() >= count )
+					return true;
+
+				usleep(1000);
+			}
+
+			return Heard(prefix).size() >= count;
+		}
+
+	private:
+		static void* ThreadFn(void* ptr) { ((TestResponder*)ptr)->Loop(); return 0L; }
+
+		void	Loop(void)
+		{
+			std::string	line;
+			char		byte;
+			pollfd		pfd = { _fd, POLLIN, 0 };
+
+			while( _stop == false )
+			{
+				if( poll(&pfd, 1, 10) <= 0 )
+					continue;
+
+				// EIO while slave is closed between cycles
+				if( read(_fd, &byte, 1) != 1 )
+				{
+					usleep(100);
+					continue;
+				}
+
+				if( byte != '\r' )
+				{
+					line += byte;
+					continue;
+				}
+
+				if( line == "^ECHOF 1" )
+					Send("+\r");
+				else if( line == "?$1E" )
+					Send("FID=Roboteq test\r");
+				else if( line == "?$1F" )
+					Send("TRN=:TEST\r");
+
+				pthread_mutex_lock(&_mx);
+
+				_lines.push_back(line);
+
+				for( size_t Idx(0); Idx < _answers.size(); Idx++ )
+				{
+					if( line.compare(0, _answers[Idx].first.size(), _answers[Idx].first) == 0 )
+					{
+						if( _answers[Idx].second.empty() == false )
+							Send(_answers[Idx].second.c_str());
+
+						break;
+					}
+				}
+
+				pthread_mutex_unlock(&_mx);
+
+				line.clear();
+			}
+		}
+
+		void	Send(const char* pReply) { EXPECT_GT(write(_fd, pReply, strlen(pReply)), 0); }
+
+		int				_fd;
+		volatile bool	_stop;
+		pthread_t		_thread;
+		pthread_mutex_t	_mx;
+		std::vector<std::string>						_lines;
+		std::vector<std::pair<std::string, std::string> >	_answers;
+};
+
+TEST(TestRoboteqCom, openCloseCycles)
+{
+	TestPty			pty;
+	TestResponder	controller(pty._master);
+	NullLogger		log;
+	ReplyCounter	events;
+	RoboteqCom		com(log, events);
+	uint64_t		slowest(0);
+
+	com.SetTimeout(500);
+
+	// Nothing arrives after Open, reader sits in untimed wait until Close
+	for( int Idx(0); Idx < 2000; Idx++ )
+	{
+		com.Open(RoboteqCom::eSerial, pty._slave);
+		ASSERT_TRUE(com.IsThreadRunning());
+
+		uint64_t start = SerialClock::NowNs();
+		com.Close();
+		uint64_t took = SerialClock::NowNs() - start;
+
+		ASSERT_FALSE(com.IsThreadRunning());
+		ASSERT_FALSE(com.Port().isOpen());
+
+		if( took > slowest )
+			slowest = took;
+	}
+
+	EXPECT_LT(slowest, 100000000u);
+}
+
+TEST(TestRoboteqCom, batchingJoinsCommands)
+{
+	TestPty			pty;
+	TestResponder	controller(pty._master);
+	NullLogger		log;
+	ReplyCounter	events;
+	RoboteqCom		com(log, events);
+
+	com.SetTimeout(500);
+	com.Open(RoboteqCom::eSerial, pty._slave);
+
+	// Reader parks in untimed wait before any timed work shows up
+	usleep(50000);
+
+	// Window long enough for all three, reader flushes when it passes
+	com.SetBatching(20000);
+	com.IssueCommand("!G", "1 100");
+	com.IssueCommand("!G", "2 200");
+	com.IssueCommand("!G", "3 300");
+
+	ASSERT_TRUE(controller.WaitHeard("!G", 1));
+	usleep(30000);
+
+	std::vector<std::string> lines = controller.Heard("!G");
+
+	ASSERT_EQ(lines.size(), 1u);
+	EXPECT_EQ(lines[0], "!G 1 100_!G 2 200_!G 3 300");
+
+	RoboteqCom::BatchStats stats;
+
+	com.GetBatchStats(stats);
+	EXPECT_EQ(stats.batches, 1u);
+	EXPECT_EQ(stats.commands, 3u);
+	EXPECT_EQ(stats.sizes[3], 1u);
+
+	// Byte budget splits batch before line that would not fit
+	com.SetBatching(20000, 20);
+	com.IssueCommand("!G", "1 101");
+	com.IssueCommand("!G", "2 201");
+	com.IssueCommand("!G", "3 301");
+
+	ASSERT_TRUE(controller.WaitHeard("!G", 3));
+
+	lines = controller.Heard("!G");
+
+	EXPECT_EQ(lines[1], "!G 1 101_!G 2 201");
+	EXPECT_EQ(lines[2], "!G 3 301");
+
+	com.Close();
+}
+
+TEST(TestRoboteqCom, setpointLatestWins)
+{
+	TestPty			pty;
+	TestResponder	controller(pty._master);
+	NullLogger		log;
+	ReplyCounter	events;
+	RoboteqCom		com(log, events);
+
+	com.SetTimeout(500);
+	com.Open(RoboteqCom::eSerial, pty._slave);
+
+	// Reader parks in untimed wait before any timed work shows up
+	usleep(50000);
+
+	com.SetMotorSetpoint(0, 1, 100, false);
+	com.SetMotorSetpoint(0, 1, 200, false);
+	com.SetMotorSetpoint(0, 2, -50, false);
+	com.SetMotorSetpoint(0, 2, -60);
+
+	ASSERT_TRUE(controller.WaitHeard("!G", 1));
+	EXPECT_EQ(controller.Heard("!G")[0], "!G 1 200_!G 2 -60");
+
+	RoboteqCom::SetpointStats stats;
+
+	com.GetSetpointStats(stats);
+	EXPECT_EQ(stats.submitted, 4u);
+	EXPECT_EQ(stats.coalesced, 2u);
+	EXPECT_EQ(stats.sent, 2u);
+	EXPECT_EQ(stats.writes, 1u);
+
+	// Same slots reuse compiled line, only digits change (and their count)
+	com.SetMotorSetpoint(0, 1, 7, false);
+	com.SetMotorSetpoint(0, 2, -1234);
+
+	ASSERT_TRUE(controller.WaitHeard("!G", 2));
+	EXPECT_EQ(controller.Heard("!G")[1], "!G 1 7_!G 2 -1234");
+
+	// Other slots compile new line
+	com.SetMotorSetpoint(3, 1, 9);
+
+	ASSERT_TRUE(controller.WaitHeard("@", 1));
+	EXPECT_EQ(controller.Heard("@")[0], "@03!G 1 9");
+
+	com.SetMotorSetpoint(0, 1, 0, false);
+	com.SetMotorSetpoint(0, 2, 55);
+
+	ASSERT_TRUE(controller.WaitHeard("!G", 3));
+	EXPECT_EQ(controller.Heard("!G")[2], "!G 1 0_!G 2 55");
+
+	com.Close();
+}
+
+TEST(TestRoboteqCom, setpointWaitsForLink)
+{
+	TestPty			pty;
+	TestResponder	controller(pty._master);
+	NullLogger		log;
+	ReplyCounter	events;
+	RoboteqCom		com(log, events);
+
+	com.SetTimeout(500);
+	com.Open(RoboteqCom::eSerial, pty._slave);
+	usleep(50000);
+
+	// Link model still busy with config dump, setpoint stays staged
+	// until reader finds link free
+	for( int Idx(0); Idx < 20; Idx++ )
+		com.IssueCommand("^MXRPM", "1 3000");
+
+	com.SetMotorSetpoint(0, 1, 11);
+
+	ASSERT_TRUE(controller.WaitHeard("!G", 1));
+	EXPECT_EQ(controller.Heard("").back(), "!G 1 11");
+
+	RoboteqCom::SetpointStats stats;
+
+	com.GetSetpointStats(stats);
+	EXPECT_EQ(stats.sent, 1u);
+
+	com.Close();
+}
+
+static size_t LinePos(const std::vector<std::string>& lines, const std::string& line)
+{
+	return std::find(lines.begin(), lines.end(), line) - lines.begin();
+}
+
+TEST(TestRoboteqCom, schedulerPriorityOrder)
+{
+	TestPty			pty;
+	TestResponder	controller(pty._master);
+	NullLogger		log;
+	ReplyCounter	events;
+	RoboteqCom		com(log, events);
+
+	com.SetTimeout(500);
+	com.Open(RoboteqCom::eSerial, pty._slave);
+
+	// Reader parks in untimed wait before any timed work shows up
+	usleep(50000);
+	com.SetScheduler(true);
+
+	// Config dump fills link model past slack, rest waits in queue
+	for( int Idx(0); Idx < 20; Idx++ )
+		com.IssueCommand("^MXRPM", "1 3000");
+
+	// Queued lowest class first, must go out highest first
+	com.IssueCommand("?V");
+	com.IssueCommand("!G", "1 5");
+	com.IssueCommand("!EX");
+
+	ASSERT_TRUE(controller.WaitHeard("^MXRPM", 20));
+
+	std::vector<std::string> lines = controller.Heard("");
+
+	size_t safety = LinePos(lines, "!EX");
+	size_t motion = LinePos(lines, "!G 1 5");
+	size_t query  = LinePos(lines, "?V");
+
+	ASSERT_LT(query, lines.size());
+	EXPECT_LT(safety, motion);
+	EXPECT_LT(motion, query);
+	EXPECT_EQ(lines.back(), "^MXRPM 1 3000");
+
+	RoboteqCom::SchedulerStats stats;
+
+	com.GetSchedulerStats(stats);
+	EXPECT_EQ(stats.classes[RoboteqCom::ePriority_Safety].sent, 1u);
+	EXPECT_EQ(stats.classes[RoboteqCom::ePriority_Config].sent, 20u);
+	EXPECT_GT(stats.classes[RoboteqCom::ePriority_Config].maxDepth, 1u);
+
+	com.Close();
+}
+
+TEST(TestRoboteqCom, queryMatchAndTimeout)
+{
+	TestPty			pty;
+	TestResponder	controller(pty._master);
+	NullLogger		log;
+	ReplyCounter	events;
+	RoboteqCom		com(log, events);
+	RoboteqQuery	volts, amps, temp;
+
+	controller.Answer("?A", "A=7:8\r");
+
+	com.SetTimeout(500);
+	com.Open(RoboteqCom::eSerial, pty._slave);
+
+	// Reader parks in untimed wait before any timed work shows up
+	usleep(50000);
+
+	int before = events._count;
+
+	// Both in flight, answer to second one comes first
+	ASSERT_TRUE(com.Query(volts, "?V", 1000));
+	ASSERT_TRUE(com.Query(amps, "?A", 1000));
+
+	EXPECT_TRUE(amps.Wait());
+	EXPECT_EQ(amps.Reply(), "A=7:8");
+	EXPECT_EQ(volts.Status(), RoboteqQuery::eStatus_Pending);
+
+	// Telemetry in between is not a reply
+	pty.Send("S=1:2\rV=3:4\r");
+
+	EXPECT_TRUE(volts.Wait());
+	EXPECT_EQ(volts.Value(), "3:4");
+	EXPECT_EQ(events._count, before + 1);
+
+	ASSERT_TRUE(com.Query(temp, "?T", 20));
+
+	uint64_t start = SerialClock::NowNs();
+
+	EXPECT_FALSE(temp.Wait());
+	EXPECT_EQ(temp.Status(), RoboteqQuery::eStatus_Timeout);
+	EXPECT_GE(SerialClock::NowNs() - start, 10000000u);
+	EXPECT_EQ(com.QueriesPending(), 0u);
+
+	com.Close();
+}
+
+static const RoboteqCom::AckTypeStats* FindAckType(const RoboteqCom::AckTypeStats* pStats,
+												   unsigned int count, const char* pName)
+{
+	for( unsigned int Idx(0); Idx < count; Idx++ )
+	{
+		if( strcmp(pStats[Idx].name, pName) == 0 )
+			return &pStats[Idx];
+	}
+
+	return 0L;
+}
+
+TEST(TestRoboteqCom, ackPairingAndExpiry)
+{
+	TestPty			pty;
+	TestResponder	controller(pty._master);
+	NullLogger		log;
+	ReplyCounter	events;
+	RoboteqCom		com(log, events);
+	RoboteqAck		go, rpm, stop;
+
+	controller.Answer("!G", "+\r");
+	controller.Answer("^MXRPM", "-\r");
+	controller.Answer("!MS", "");
+
+	com.SetTimeout(500);
+	com.Open(RoboteqCom::eSerial, pty._slave);
+
+	// Reader parks in untimed wait before any timed work shows up
+	usleep(50000);
+	com.SetAckTracking(true, 500);
+
+	int before = events._count;
+
+	ASSERT_TRUE(com.IssueTracked(go, "!G", "1 100", 500));
+	ASSERT_TRUE(com.IssueTracked(rpm, "^MXRPM", "1 3000", 500));
+
+	EXPECT_TRUE(go.Wait());
+	EXPECT_EQ(go.Status(), RoboteqAck::eStatus_Accepted);
+	EXPECT_FALSE(rpm.Wait());
+	EXPECT_EQ(rpm.Status(), RoboteqAck::eStatus_Rejected);
+
+	// Untracked command still pairs with its answer
+	com.IssueCommand("!G", "2 5");
+	ASSERT_TRUE(controller.WaitHeard("!G 2", 1));
+
+	// Lost answer, sent once more, then given up
+	ASSERT_TRUE(com.IssueTracked(stop, "!MS", "1", 30, 1));
+
+	EXPECT_FALSE(stop.Wait());
+	EXPECT_EQ(stop.Status(), RoboteqAck::eStatus_Timeout);
+	EXPECT_EQ(stop.Attempts(), 2u);
+	EXPECT_EQ(controller.Heard("!MS").size(), 2u);
+
+	// "+" and "-" were consumed, not dispatched
+	EXPECT_EQ(events._count, before);
+
+	RoboteqCom::AckTypeStats		stats[ROBO_ACK_TYPES];
+	unsigned int					count = com.GetAckStats(stats, ROBO_ACK_TYPES);
+	const RoboteqCom::AckTypeStats*	pGo   = FindAckType(stats, count, "!G");
+	const RoboteqCom::AckTypeStats*	pRpm  = FindAckType(stats, count, "^MXRPM");
+	const RoboteqCom::AckTypeStats*	pStop = FindAckType(stats, count, "!MS");
+
+	ASSERT_TRUE(pGo != 0L && pRpm != 0L && pStop != 0L);
+	EXPECT_EQ(pGo->accepted, 2u);
+	EXPECT_EQ(pRpm->rejected, 1u);
+	EXPECT_EQ(pStop->lost, 2u);
+	EXPECT_EQ(pStop->retransmits, 1u);
+
+	com.Close();
+}
+
+TEST(TestRoboteqCom, silentLineExpires)
+{
+	TestPty			pty;
+	TestResponder	controller(pty._master);
+	NullLogger		log;
+	ReplyCounter	events;
+	RoboteqCom		com(log, events);
+	RoboteqQuery	temp;
+	RoboteqAck		stop;
+
+	controller.Answer("!MS", "");
+
+	com.SetTimeout(500);
+	com.Open(RoboteqCom::eSerial, pty._slave);
+	usleep(50000);
+
+	// Nothing ever arrives, only timed wakeups can end these
+	ASSERT_TRUE(com.Query(temp, "?T", 20));
+	EXPECT_FALSE(temp.Wait());
+	EXPECT_EQ(temp.Status(), RoboteqQuery::eStatus_Timeout);
+
+	com.SetAckTracking(true, 500);
+	ASSERT_TRUE(com.IssueTracked(stop, "!MS", "1", 30, 2));
+
+	EXPECT_FALSE(stop.Wait());
+	EXPECT_EQ(stop.Status(), RoboteqAck::eStatus_Timeout);
+	EXPECT_EQ(stop.Attempts(), 3u);
+	EXPECT_EQ(controller.Heard("!MS").size(), 3u);
+
+	com.Close();
+}
+
+TEST(TestRoboteqCom, engineServicesTimedWork)
+{
+	TestPty			pty;
+	TestResponder	controller(pty._master);
+	NullLogger		log;
+	ReplyCounter	events;
+	RoboteqEngine	engine(log);
+	RoboteqCom		com(log, events, engine);
+
+	engine.Start();
+
+	com.SetTimeout(500);
+	com.Open(RoboteqCom::eSerial, pty._slave);
+	usleep(50000);
+
+	// No reader thread, engine must flush batch and pending setpoint
+	com.SetBatching(10000);
+	com.IssueCommand("!G", "1 100");
+	com.IssueCommand("!G", "2 200");
+
+	ASSERT_TRUE(controller.WaitHeard("!G", 1));
+	EXPECT_EQ(controller.Heard("!G")[0], "!G 1 100_!G 2 200");
+
+	com.SetBatching(0);
+	com.SetMotorSetpoint(0, 1, 7, false);
+	com.SetMotorSetpoint(0, 2, 8);
+
+	ASSERT_TRUE(controller.WaitHeard("!G", 2));
+	EXPECT_EQ(controller.Heard("!G")[1], "!G 1 7_!G 2 8");
+
+	// Scheduler queue behind link model drains without reader thread
+	com.SetScheduler(true);
+
+	for( int Idx(0); Idx < 20; Idx++ )
+		com.IssueCommand("^MXRPM", "1 3000");
+
+	EXPECT_TRUE(controller.WaitHeard("^MXRPM", 20));
+
+	EXPECT_THROW(com.SetAckTracking(true), std::runtime_error);
+
+	com.Close();
+	engine.Stop();
+}
+
+// Callback holds reader inside Complete while test deletes the query
+class SlowQueryDone : public IQueryDone
+{
+	public:
+		SlowQueryDone(void) : _entered(false), _left(false) {}
+
+		virtual void OnQueryDone(RoboteqQuery&)
+		{
+			_entered = true;
+			usleep(50000);
+			_left = true;
+		}
+
+		volatile bool	_entered;
+		volatile bool	_left;
+};
+
+TEST(TestRoboteqCom, queryDestroyedDuringCallback)
+{
+	TestPty			pty;
+	TestResponder	controller(pty._master);
+	NullLogger		log;
+	ReplyCounter	events;
+	RoboteqCom		com(log, events);
+	SlowQueryDone	done;
+	RoboteqQuery*	pQuery = new RoboteqQuery();
+
+	com.SetTimeout(500);
+	com.Open(RoboteqCom::eSerial, pty._slave);
+
+	// Never answered, completes by timeout on reader thread
+	ASSERT_TRUE(com.Query(*pQuery, "?T", 10, &done));
+
+	for( int Idx(0); Idx < 1000 && done._entered == false; Idx++ )
+		usleep(1000);
+
+	ASSERT_TRUE(done._entered);
+	EXPECT_NE(pQuery->Status(), RoboteqQuery::eStatus_Pending);
+
+	delete pQuery;
+	EXPECT_TRUE(done._left);
+
+	com.Close();
+}
+
+TEST(TestRoboteqCom, openSilentControllerFails)
+{
+	TestPty		pty;
+	NullLogger	log;
+	RoboteqCom	com(log);
+
+	com.SetTimeout(50);
+
+	uint64_t start = SerialClock::NowNs();
+
+	EXPECT_THROW(com.Open(RoboteqCom::eSerial, pty._slave), std::runtime_error);
+	EXPECT_LT(SerialClock::NowNs() - start, 1000000000ULL);
+
+	com.Close();
+}
+
+class ReplyCollector : public IEventListener<const IEventArgs>
+{
+	public:
+		virtual void OnMsgEvent(const IEventArgs& evt) { _replies.push_back(evt.Reply()); }
+
+		std::vector<std::string> _replies;
+};
+
+TEST(TestRoboteqEngine, dispatchManyPorts)
+{
+	NullLogger		log;
+	RoboteqEngine	engine(log);
+	TestPty			pty1, pty2;
+	SerialPort		port1(log), port2(log);
+	ReplyCollector	events1, events2;
+
+	port1.connect(pty1._slave);
+	port2.connect(pty2._slave);
+
+	engine.Add(port1, events1);
+	engine.Add(port2, events2);
+	EXPECT_EQ(engine.Count(), 2u);
+
+	pty1.Send("S=1:2\r+\rA=3:4\r");
+	pty2.Send("V=5:6\r");
+
+	for( int Idx(0); Idx < 10 && events1._replies.size() + events2._replies.size() < 3; Idx++ )
+		engine.Poll(50);
+
+	ASSERT_EQ(events1._replies.size(), 2u);
+	ASSERT_EQ(events2._replies.size(), 1u);
+	EXPECT_EQ(events1._replies[1], "A=3:4");
+	EXPECT_EQ(events2._replies[0], "V=5:6");
+
+	engine.Remove(port1);
+	EXPECT_EQ(engine.Count(), 1u);
+	engine.Remove(port2);
+}
+
+TEST(TestRoboteqTelemetry, parseReplies)
+{
+	RoboteqTelemetry::Reply reply;
+
+	// Echo byte in front is skipped, CR is tried before C
+	ASSERT_TRUE(RoboteqTelemetry::Parse(string("!CR=-12:15"), reply));
+	EXPECT_EQ(reply.key, RoboteqTelemetry::eKey_CR);
+	ASSERT_EQ(reply.count, 2u);
+	EXPECT_EQ(reply.values[0], -12);
+	EXPECT_EQ(reply.values[1], 15);
+
+	ASSERT_TRUE(RoboteqTelemetry::Parse(string("V=135:241:4980\r"), reply));
+	EXPECT_EQ(reply.key, RoboteqTelemetry::eKey_V);
+	ASSERT_EQ(reply.count, 3u);
+	EXPECT_EQ(reply.values[2], 4980);
+
+	string frame("?S=1250:-1248");
+	IEventArgs evt(frame);
+
+	ASSERT_TRUE(RoboteqTelemetry::Parse(evt.Data(), evt.Length(), reply));
+	EXPECT_EQ(reply.key, RoboteqTelemetry::eKey_S);
+	EXPECT_EQ(reply.values[1], -1248);
+	EXPECT_EQ(frame, "?S=1250:-1248");
+	EXPECT_EQ(evt.Reply(), "S=1250:-1248");
+
+	EXPECT_FALSE(RoboteqTelemetry::Parse(string("S=12:"), reply));
+	EXPECT_FALSE(RoboteqTelemetry::Parse(string("S=1x"), reply));
+	EXPECT_FALSE(RoboteqTelemetry::Parse(string("ZZ=1"), reply));
+	EXPECT_FALSE(RoboteqTelemetry::Parse(string("S=1:2:3:4:5:6:7:8:9"), reply));
+}
+
+TEST(TestRoboteqReplyRing, wrapAndDrop)
+{
+	RoboteqReplyRing ring(3, 8);		// Rounded up to 4 slots
+	const char*      pData;
+	unsigned int     len;
+	char             reply[2] = { 'A', 0 };
+
+	EXPECT_FALSE(ring.Peek(pData, len));
+
+	for( int Idx(0); Idx < 10; Idx++ )
+	{
+		reply[1] = '0' + Idx;
+		ring.Push(reply, 2);
+
+		if( Idx % 2 == 1 )
+		{
+			ASSERT_TRUE(ring.Peek(pData, len));
+			ring.Release();
+		}
+	}
+
+	EXPECT_FALSE(ring.Push("too long reply", 14));
+
+	RoboteqReplyRing::Stats stats;
+	ring.GetStats(stats);
+
+	EXPECT_EQ(stats.capacity, 4u);
+	EXPECT_EQ(stats.highWater, 4u);
+	EXPECT_EQ(stats.pushed + stats.dropped, 11u);
+	EXPECT_EQ(ring.Size(), stats.pushed - stats.popped);
+
+	ASSERT_TRUE(ring.Peek(pData, len));
+	EXPECT_EQ(len, 2u);
+	EXPECT_EQ(pData[0], 'A');
+}
+
+TEST(TestRoboteqCmdQueue, fullAndWrap)
+{
+	RoboteqCmdQueue queue(2);
+	const char*     pData;
+	unsigned int    len;
+	ICommandDone*   pDone;
+	uint64_t        ticket;
+	char            big[ROBO_CMDQ_SLOT_BYTES + 1];
+
+	EXPECT_EQ(queue.Push("!G 1 1\r", 7, 0L), 1u);
+	EXPECT_EQ(queue.Push("!G 1 2\r", 7, 0L), 2u);
+	EXPECT_EQ(queue.Push("!G 1 3\r", 7, 0L), 0u);		// Full
+	EXPECT_EQ(queue.Push(big, sizeof(big), 0L), 0u);	// Too long
+
+	for( uint64_t expect(1); expect <= 5; expect++ )
+	{
+		ASSERT_TRUE(queue.Peek(pData, len, pDone, ticket));
+		EXPECT_EQ(ticket, expect);
+		EXPECT_EQ(len, 7u);
+		queue.Release();
+
+		EXPECT_EQ(queue.Push("!G 1 4\r", 7, 0L), expect + 2);
+	}
+
+	EXPECT_EQ(queue.Size(), 2u);
+}
+
+TEST(TestRoboteqHistogram, percentiles)
+{
+	RoboteqHistogram			hist;
+	RoboteqHistogram::Snapshot	snap;
+
+	for( uint64_t value(1); value <= 1000; value++ )
+		hist.Record(value * 1000);				// 1 us .. 1 ms
+
+	hist.GetSnapshot(snap);
+
+	EXPECT_EQ(snap.total, 1000u);
+	EXPECT_EQ(snap.min, 1000u);
+	EXPECT_EQ(snap.max, 1000000u);
+	EXPECT_DOUBLE_EQ(snap.Mean(), 500500.0);
+	EXPECT_NEAR(snap.Percentile(50), 500000.0, 500000 * 0.04);
+	EXPECT_NEAR(snap.Percentile(99), 990000.0, 990000 * 0.04);
+	EXPECT_EQ(snap.Percentile(100), 1000000u);
+
+	for( unsigned int Idx(0); Idx < RoboteqHistogram::BUCKETS; Idx++ )
+		EXPECT_EQ(RoboteqHistogram::Index(RoboteqHistogram::UpperEdge(Idx)), Idx);
+
+	hist.Reset();
+	hist.GetSnapshot(snap);
+
+	EXPECT_EQ(snap.total, 0u);
+	EXPECT_EQ(snap.Percentile(50), 0u);
+}
+
+TEST(TestSerialCapture, flushedWhileOpen)
+{
+	SerialCapture	capture;
+	char			path[64];
+
+	snprintf(path, sizeof(path), "/tmp/roboteq_utest_open_%d.rcap", (int)getpid());
+
+	capture.Open(path);
+	capture.Write(SerialCapture::eDir_RX, "S=1:2\r", 6);
+	usleep((SerialCapture::FLUSH_MS + 10) * 1000);
+	capture.Write(SerialCapture::eDir_TX, "?S\r", 3);
+
+	// Record larger than buffer skips it
+	std::string big(SerialCapture::BUFFER + 100, 'x');
+
+	capture.Write(SerialCapture::eDir_RX, big.data(), big.size());
+
+	// Still open, all three already on disk
+	std::vector<SerialCapture::Record> records;
+
+	SerialCapture::Load(path, records);
+
+	capture.Close();
+	unlink(path);
+
+	ASSERT_EQ(records.size(), 3u);
+	EXPECT_EQ(records[1].data, "?S\r");
+	EXPECT_EQ(records[2].data, big);
+	EXPECT_EQ(capture.Errors(), 0u);
+}
+
+TEST(TestSerialCapture, flushedByIdleReader)
+{
+	TestPty			pty;
+	NullLogger		log;
+	SerialPort		port(log);
+	SerialCapture	capture;
+	char			path[64];
+	std::string		frame;
+
+	snprintf(path, sizeof(path), "/tmp/roboteq_utest_idle_%d.rcap", (int)getpid());
+
+	capture.Open(path);
+	port.capture(&capture);
+	port.canonical(SerialPort::eCanonical_Disable);
+	port.connect(pty._slave);
+
+	// Command stays buffered, no further Write comes to flush it
+	EXPECT_EQ(port.write("?S\r"), 3);
+	EXPECT_NE(capture.FlushDueNs(), 0u);
+
+	// Quiet line, reader waiting for the answer puts it on disk
+	EXPECT_EQ(port.readFrame(frame, '\r', SerialClock::DeadlineIn(SerialCapture::FLUSH_MS + 50)), 0);
+	EXPECT_EQ(capture.FlushDueNs(), 0u);
+
+	std::vector<SerialCapture::Record> records;
+
+	SerialCapture::Load(path, records);
+
+	ASSERT_EQ(records.size(), 1u);
+	EXPECT_EQ(records[0].data, "?S\r");
+
+	port.disconnect(false);
+	capture.Close();
+	unlink(path);
+}
+
+TEST(TestSerialCapture, corruptLengthRejected)
+{
+	SerialCapture	capture;
+	char			path[64];
+
+	snprintf(path, sizeof(path), "/tmp/roboteq_utest_bad_%d.rcap", (int)getpid());
+
+	capture.Open(path);
+	capture.Close();
+
+	// Valid header, then a record claiming almost 2 GB
+	FILE*		pFile = fopen(path, "ab");
+	uint64_t	ns(0);
+	uint32_t	length(0x7FFFFFF0);
+
+	ASSERT_TRUE(pFile != 0L);
+	fwrite(&ns, sizeof(ns), 1, pFile);
+	fwrite(&length, sizeof(length), 1, pFile);
+	fclose(pFile);
+
+	std::vector<SerialCapture::Record> records;
+
+	EXPECT_THROW(SerialCapture::Load(path, records), std::runtime_error);
+
+	unlink(path);
+}
+
+TEST(TestSerialCapture, captureAndTimedReplay)
+{
+	TestPty			pty;
+	NullLogger		log;
+	SerialPort		port(log);
+	SerialCapture	capture;
+	std::string		frame;
+	char			path[64];
+
+	snprintf(path, sizeof(path), "/tmp/roboteq_utest_%d.rcap", (int)getpid());
+
+	capture.Open(path);
+	port.connect(pty._slave);
+	port.capture(&capture);
+
+	pty.Send("S=1:2\r");
+	ASSERT_GT(port.readFrame(frame, '\r', SerialClock::DeadlineIn(200)), 0);
+	EXPECT_EQ(port.write("?S\r"), 3);
+	usleep(30000);
+	pty.Send("S=3:4\r");
+	ASSERT_GT(port.readFrame(frame, '\r', SerialClock::DeadlineIn(200)), 0);
+
+	port.disconnect(false);
+	capture.Close();
+
+	std::vector<SerialCapture::Record> records;
+
+	SerialCapture::Load(path, records);
+
+	ASSERT_EQ(records.size(), 3u);
+	EXPECT_EQ(records[0].dir, SerialCapture::eDir_RX);
+	EXPECT_EQ(records[0].data, "S=1:2\r");
+	EXPECT_EQ(records[1].dir, SerialCapture::eDir_TX);
+	EXPECT_EQ(records[1].data, "?S\r");
+	EXPECT_GE(records[2].ns - records[0].ns, 30000000u);
+
+	// RX chunks come back with their recorded spacing
+	SerialReplayPort	replay(log);
+
+	replay.setRealTime(true);
+	port.transport(&replay);
+	port.connect(path);
+
+	ASSERT_GT(port.readFrame(frame, '\r', SerialClock::DeadlineIn(200)), 0);
+	uint64_t first = SerialClock::NowNs();
+	ASSERT_GT(port.readFrame(frame, '\r', SerialClock::DeadlineIn(200)), 0);
+
+	EXPECT_EQ(frame, "S=3:4");
+	EXPECT_GE(SerialClock::NowNs() - first, 25000000u);
+
+	port.disconnect(false);
+	unlink(path);
+}
+
+TEST(TestSerialNetPort, peerCloseEndsRead)
+{
+	NullLogger		log;
+	SerialPort		port(log);
+	SerialNetPort	net(log);
+	sockaddr_in		addr;
+	socklen_t		len(sizeof(addr));
+	int				listener = socket(AF_INET, SOCK_STREAM, 0);
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family		 = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	ASSERT_EQ(bind(listener, (sockaddr*)&addr, sizeof(addr)), 0);
+	ASSERT_EQ(listen(listener, 1), 0);
+	ASSERT_EQ(getsockname(listener, (sockaddr*)&addr, &len), 0);
+
+	std::ostringstream address;
+
+	address << "127.0.0.1:" << ntohs(addr.sin_port);
+
+	port.transport(&net);
+	port.connect(address.str());
+
+	int peer = accept(listener, 0L, 0L);
+
+	ASSERT_GE(peer, 0);
+	ASSERT_EQ(write(peer, "S=1:2\r", 6), 6);
+
+	std::string frame;
+
+	ASSERT_GT(port.readFrame(frame, '\r', SerialClock::DeadlineIn(500)), 0);
+	EXPECT_EQ(frame, "S=1:2");
+
+	// End of file is an error, not another empty wait
+	close(peer);
+
+	uint64_t start = SerialClock::NowNs();
+
+	EXPECT_LT(port.readFrame(frame, '\r', SerialClock::DeadlineIn(500)), 0);
+	EXPECT_EQ(errno, EPIPE);
+	EXPECT_LT(port.readFrame(frame, '\r'), 0);
+	EXPECT_LT(SerialClock::NowNs() - start, 100000000u);
+
+	port.disconnect(false);
+	close(listener);
+}
+
+TEST(TestRoboteqCom, replayTransport)
+{
+	NullLogger			log;
+	ReplyCounter		events;
+	RoboteqCom			com(log, events);
+	SerialReplayPort	replay(log);
+	std::string			data("+\rFID=Roboteq replay\rTRN=:REPLAY\r");
+
+	for( int Idx(0); Idx < 100; Idx++ )
+		data += "S=10:-10\r";
+
+	replay.setData(data);
+	com.SetTransport(&replay);
+	com.SetTimeout(200);
+	com.Open(RoboteqCom::eSerial, "");
+
+	EXPECT_EQ(com.Version().compare(0, 7, "Roboteq"), 0);
+
+	for( int Idx(0); Idx < 200 && events._count < 100; Idx++ )
+		usleep(1000);
+
+	EXPECT_EQ(events._count, 100);
+	EXPECT_EQ(com.Port().wireTimeNs(100), 0u);
+	EXPECT_GT(replay.bytesReceived(), 0u);
+
+	com.Close();
+	EXPECT_TRUE(replay.isDone());
+}
+
+TEST(TestRoboteqCmdLine, formatAndOverflow)
+{
+	RoboteqCmdLine	line;
+
+	line.Command(4, "!G", 1, 900).Command(4, "!G", 2, -1000).Command(0, "!G", 1, 0);
+	line.Command(12, "!G", 3, INT_MIN).Command(123, "!G", 1, INT_MAX);
+
+	EXPECT_EQ(line.Str(), "@04!G 1 900_@04!G 2 -1000_!G 1 0_@12!G 3 -2147483648_@123!G 1 2147483647");
+	EXPECT_EQ(line.Count(), 5u);
+
+	line.Terminate();
+	EXPECT_EQ(line.Data()[line.Size() - 1], '\r');
+
+	line.Clear();
+
+	for( int Idx(0); Idx < 200; Idx++ )
+		line.Command(1, "!G", 1, -1000);
+
+	EXPECT_TRUE(line.Overflow());
+	EXPECT_EQ(line.Size(), (unsigned int)RoboteqCmdLine::MAX_LINE);
+
+	line.Terminate();
+	EXPECT_EQ(line.Size(), RoboteqCmdLine::MAX_LINE + 1u);
+}
+
+TEST(TestRoboteqCmdTable, typedEncoding)
+{
+	using namespace RoboteqCmd;
+
+	RoboteqCmdLine	line;
+
+	Cmd<Go>(line, 4, 1, -1000);
+	Cmd<EmergencyStop>(line, 0);
+	Cmd<ReadSpeed>(line, 2);
+	Cmd<ReadSpeed>(line, 0, 1);
+	Cmd<TelemetryEvery>(line, 0, 100);
+
+	EXPECT_EQ(line.Str(), "@04!G 1 -1000_!EX_@02?S_?S 1_# 100");
+	EXPECT_EQ(Cmd<TelemetryClear>(0).Str(), "# C");
+	EXPECT_EQ(Cmd<Echo>(0, 1).Str(), "^ECHOF 1");
+	EXPECT_EQ((int)ReadModel::KIND, (int)eKind_Query);
+	EXPECT_EQ((int)Reset::LEN, 6);
+}
+
+TEST(TestRoboteqCmdTemplate, slotPatching)
+{
+	RoboteqCmdTemplate	tmpl;
+	unsigned int		slots[4];
+
+	slots[0] = tmpl.Add<RoboteqCmd::Go>(1, 1);
+	slots[1] = tmpl.Add<RoboteqCmd::Go>(1, 2);
+	slots[2] = tmpl.Add<RoboteqCmd::Go>(12, 1);
+	slots[3] = tmpl.Add<RoboteqCmd::TelemetryEvery>(0);
+
+	EXPECT_EQ(tmpl.Str(), "@01!G 1 0_@01!G 2 0_@12!G 1 0_# 0");
+
+	tmpl.Set(slots[0], -1000);
+	tmpl.Set(slots[1], 900);
+	tmpl.Set(slots[2], INT_MIN);
+	tmpl.Set(slots[3], 100);
+
+	EXPECT_EQ(tmpl.Str(), "@01!G 1 -1000_@01!G 2 900_@12!G 1 -2147483648_# 100");
+
+	// Same width is in place, shorter moves tail back
+	tmpl.Set(slots[0], -2000);
+	tmpl.Set(slots[2], 7);
+
+	EXPECT_EQ(tmpl.Str(), "@01!G 1 -2000_@01!G 2 900_@12!G 1 7_# 100");
+	EXPECT_EQ(tmpl.Data()[tmpl.Size() - 1], '\r');
+	EXPECT_EQ(tmpl.Count(), 4u);
+	EXPECT_FALSE(tmpl.Overflow());
+}
+
+// Keeps last line and its level
+class LastLineLogger : public SerialLogger
+{
+	public:
+		LastLineLogger(void) : _lines(0), _level(eLevel_None) {}
+
+		virtual bool	IsLogOpen(void) const { return true; }
+		virtual void	LogLine(const char* pBuffer, unsigned int len) { LogLine(std::string(pBuffer, len)); }
+		virtual void	LogLine(const std::string& message) { _last = message; ++_lines; }
+		virtual void	Log(const char* pBuffer, unsigned int len) { LogLine(pBuffer, len); }
+		virtual void	Log(const std::string& message) { LogLine(message); }
+		virtual void	LogLineAt(eLevel level, const std::string& message) { _level = level; LogLine(message); }
+
+		std::string		_last;
+		int				_lines;
+		eLevel			_level;
+};
+
+static int CountCall(int& calls)
+{
+	return ++calls;
+}
+
+TEST(TestSerialLogger, levelFilterIsLazy)
+{
+	LastLineLogger	log;
+	int				calls(0);
+
+	// Default level is info, debug stream is not even evaluated
+	SERIAL_LOG_DEBUG(log, "calls " << CountCall(calls));
+	EXPECT_EQ(calls, 0);
+	EXPECT_EQ(log._lines, 0);
+
+	SERIAL_LOG_WARN(log, "calls " << CountCall(calls));
+	EXPECT_EQ(log._last, "calls 1");
+	EXPECT_EQ(log._level, SerialLogger::eLevel_Warn);
+
+	log.SetLevel(SerialLogger::eLevel_Debug);
+	SERIAL_LOG_DEBUG(log, "calls " << CountCall(calls));
+	EXPECT_EQ(log._last, "calls 2");
+
+	log.SetLevel(SerialLogger::eLevel_None);
+	SERIAL_LOG_ERROR(log, "calls " << CountCall(calls));
+	EXPECT_EQ(calls, 2);
+	EXPECT_EQ(log._lines, 2);
+}
+
+static void* LogFiveThousand(void* ptr)
+{
+	for( int Idx(0); Idx < 5000; Idx++ )
+		((SerialLogger*)ptr)->LogLine("> : S=10:-10");
+
+	return 0L;
+}
+
+TEST(TestSerialAsyncLogger, blockPolicyLosesNothing)
+{
+	SerialAsyncLogger	logger(64);
+	pthread_t			threads[4];
+	char				path[64];
+
+	snprintf(path, sizeof(path), "/tmp/roboteq_utest_%d.log", (int)getpid());
+	unlink(path);
+
+	logger.SetDropPolicy(SerialAsyncLogger::eDrop_Block);
+	ASSERT_TRUE(logger.Open(path));
+
+	for( int Idx(0); Idx < 4; Idx++ )
+		ASSERT_EQ(pthread_create(&threads[Idx], 0L, LogFiveThousand, &logger), 0);
+
+	for( int Idx(0); Idx < 4; Idx++ )
+		pthread_join(threads[Idx], 0L);
+
+	logger.LogLine(std::string(SerialAsyncLogger::SLOT_DATA + 10, 'x'));
+	logger.Close();
+
+	EXPECT_EQ(logger.Dropped(), 0u);
+	EXPECT_EQ(logger.Truncated(), 1u);
+
+	FILE*	pFile = fopen(path, "r");
+	char	line[512];
+	int		lines(0);
+	size_t	longest(0);
+
+	ASSERT_TRUE(pFile != 0L);
+
+	while( fgets(line, sizeof(line), pFile) )
+	{
+		++lines;
+		longest = std::max(longest, strlen(line));
+	}
+
+	fclose(pFile);
+	unlink(path);
+
+	// 20000 lines, long one and Opened / Closed banners
+	EXPECT_EQ(lines, 20003);
+	EXPECT_EQ(longest, SerialAsyncLogger::SLOT_DATA + 1u);
+}
+
+TEST(TestSerialAsyncLogger, dropsNotedInFile)
+{
+	SerialAsyncLogger	logger(2);
+	char				path[64];
+
+	snprintf(path, sizeof(path), "/tmp/roboteq_utest_drop_%d.log", (int)getpid());
+	unlink(path);
+
+	ASSERT_TRUE(logger.Open(path));
+
+	for( int Idx(0); Idx < 20000; Idx++ )
+		logger.LogLine("> : S=10:-10");
+
+	logger.Close();
+
+	FILE*			pFile = fopen(path, "r");
+	char			line[512];
+	unsigned long	noted(0);
+
+	ASSERT_TRUE(pFile != 0L);
+
+	while( fgets(line, sizeof(line), pFile) )
+	{
+		unsigned long count(0);
+
+		if( sscanf(line, "--------- Logger dropped %lu lines --------", &count) == 1 )
+			noted += count;
+	}
+
+	fclose(pFile);
+	unlink(path);
+
+	EXPECT_EQ(noted, logger.Dropped());
+}
+
+TEST(TestSerialAsyncLogger, crashHandlerIsOptIn)
+{
+	SerialAsyncLogger	logger;
+	SerialCapture		capture;
+	struct sigaction	before, after;
+	char				path[64];
+
+	snprintf(path, sizeof(path), "/tmp/roboteq_utest_sig_%d", (int)getpid());
+
+	ASSERT_EQ(sigaction(SIGSEGV, 0L, &before), 0);
+
+	// Neither one touches process signal handling by itself
+	ASSERT_TRUE(logger.Open(std::string(path) + ".log"));
+	capture.Open(std::string(path) + ".rcap");
+
+	ASSERT_EQ(sigaction(SIGSEGV, 0L, &after), 0);
+	EXPECT_EQ(after.sa_handler, before.sa_handler);
+
+	SerialAsyncLogger::InstallCrashHandler();
+
+	ASSERT_EQ(sigaction(SIGSEGV, 0L, &after), 0);
+	EXPECT_NE(after.sa_handler, before.sa_handler);
+
+	// Leave rest of the run as it was
+	sigaction(SIGSEGV, &before, 0L);
+
+	capture.Close();
+	logger.Close();
+	unlink((std::string(path) + ".log").c_str());
+	unlink((std::string(path) + ".rcap").c_str());
+}
+
 /*
 TEST(TestRoboteq, convertWheelVelsToTwist)
 {